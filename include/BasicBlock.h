@@ -21,50 +21,91 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "API.h"
 #include "Types.h"
-#include <iterator>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 class QString;
 
 using instruction_pointer = std::shared_ptr<edb::Instruction>;
 
+// how an instruction affects control flow, as far as the analysis cares
+enum class InstructionFlow : uint8_t {
+	None,
+	Call,
+	Jump,
+	ConditionalJump,
+	Terminator, // ret, hlt, int3 and friends
+};
+
+// what the analysis remembers about an instruction, the rest is decoded again
+// when someone asks for it
+struct InstructionRecord {
+	uint32_t offset      = 0; // from the start of the arena
+	uint8_t size         = 0;
+	InstructionFlow flow = InstructionFlow::None;
+	edb::address_t target; // for direct calls and jumps, 0 otherwise
+};
+
+// the instructions of all of the basic blocks of a region, every block is a
+// range of records in here. The bytes of the instructions are kept too, as
+// they were when the region was analyzed
+class EDB_EXPORT InstructionArena {
+public:
+	using size_type = size_t;
+
+public:
+	explicit InstructionArena(edb::address_t base);
+	InstructionArena(const InstructionArena &)            = delete;
+	InstructionArena &operator=(const InstructionArena &) = delete;
+
+public:
+	size_type append(const std::vector<InstructionRecord> &records, const uint8_t *memory);
+
+public:
+	[[nodiscard]] const InstructionRecord &operator[](size_type pos) const { return records_[pos]; }
+	[[nodiscard]] const uint8_t *bytes(size_type pos) const;
+	[[nodiscard]] edb::address_t base() const { return base_; }
+	[[nodiscard]] size_type size() const;
+	[[nodiscard]] size_type memoryUsage() const;
+
+private:
+	edb::address_t base_;
+	mutable std::mutex mutex_;
+	std::vector<InstructionRecord> records_;
+	std::vector<uint8_t> bytes_;
+
+	// the first record and the first byte of every run of instructions which
+	// follow each other, the bytes of a run are in one piece
+	std::vector<std::pair<uint32_t, uint32_t>> runs_;
+};
+
 class EDB_EXPORT BasicBlock {
 public:
-	using size_type              = size_t;
-	using value_type             = instruction_pointer;
-	using reference              = instruction_pointer &;
-	using const_reference        = const instruction_pointer &;
-	using iterator               = std::vector<instruction_pointer>::iterator;
-	using const_iterator         = std::vector<instruction_pointer>::const_iterator;
-	using reverse_iterator       = std::reverse_iterator<iterator>;
-	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+	using size_type = size_t;
+
+public:
+	BasicBlock() = default;
+	BasicBlock(std::shared_ptr<const InstructionArena> arena, size_type first, size_type count);
 
 public:
-	void push_back(const instruction_pointer &inst);
 	void addReference(edb::address_t refsite, edb::address_t target);
 
 public:
 	[[nodiscard]] std::vector<std::pair<edb::address_t, edb::address_t>> references() const;
 
 public:
-	[[nodiscard]] reference operator[](size_type pos);
-	[[nodiscard]] const_reference operator[](size_type pos) const;
-
-	[[nodiscard]] const_reference back() const;
-	[[nodiscard]] const_reference front() const;
-	[[nodiscard]] reference back();
-	[[nodiscard]] reference front();
+	// these decode the instruction from the bytes it was analyzed
+	// from every time, prefer record() when the flow and target are enough
+	[[nodiscard]] instruction_pointer operator[](size_type pos) const;
+	[[nodiscard]] instruction_pointer back() const;
+	[[nodiscard]] instruction_pointer front() const;
 
 public:
-	[[nodiscard]] const_iterator begin() const;
-	[[nodiscard]] const_iterator end() const;
-	[[nodiscard]] const_reverse_iterator rbegin() const;
-	[[nodiscard]] const_reverse_iterator rend() const;
-	[[nodiscard]] iterator begin();
-	[[nodiscard]] iterator end();
-	[[nodiscard]] reverse_iterator rbegin();
-	[[nodiscard]] reverse_iterator rend();
+	[[nodiscard]] const InstructionRecord &record(size_type pos) const;
+	[[nodiscard]] edb::address_t instructionAddress(size_type pos) const;
 
 public:
 	[[nodiscard]] size_type size() const;
@@ -82,10 +123,12 @@ public:
 	[[nodiscard]] edb::address_t lastAddress() const;
 
 public:
-	std::pair<BasicBlock, BasicBlock> splitBlock(const instruction_pointer &inst);
+	[[nodiscard]] std::pair<BasicBlock, BasicBlock> splitBlock(size_type pos) const;
 
 private:
-	std::vector<instruction_pointer> instructions_;
+	std::shared_ptr<const InstructionArena> arena_;
+	uint32_t first_ = 0;
+	uint32_t count_ = 0;
 	std::vector<std::pair<edb::address_t, edb::address_t>> references_;
 };
 
@@ -89,6 +89,7 @@ public:
 	bool remove_stale_symbols;
 	bool disableASLR;
 	bool disableLazyBinding;
+	bool nonStopMode;
 	bool break_on_library_load;
 	IBreakpoint::TypeId default_breakpoint_type;
 	QString tty_command;
@@ -0,0 +1,36 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DEBUG_EVENT_NOTIFIER_H_20240301_
+#define DEBUG_EVENT_NOTIFIER_H_20240301_
+
+#include "API.h"
+#include <QObject>
+
+// Provided by debugger cores which can tell on their own when
+// IDebugger::waitDebugEvent() has something to return. The signal may be
+// emitted from any thread.
+class EDB_EXPORT DebugEventNotifier : public QObject {
+	Q_OBJECT
+public:
+	using QObject::QObject;
+
+Q_SIGNALS:
+	void debugEventPending();
+};
+
+#endif
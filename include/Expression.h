@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Status.h"
 #include <QString>
 #include <functional>
+#include <vector>
 
 struct ExpressionError {
 public:
@@ -83,6 +84,12 @@ public:
 	using variable_getter_t = std::function<T(const QString &, bool *, ExpressionError *)>;
 	using memoryReader_t    = std::function<T(T, bool *, ExpressionError *)>;
 
+	// a binder turns a variable name into a number (a register index for
+	// example) once, when compiling, or -1 if it can't. A bound reader gets
+	// handed that number instead of the name every time the program runs
+	using variable_binder_t = std::function<int(const QString &)>;
+	using bound_reader_t    = std::function<T(int, bool *, ExpressionError *)>;
+
 public:
 	Expression(const QString &s, variable_getter_t vg, memoryReader_t mr);
 	~Expression() = default;
@@ -141,37 +148,86 @@ private:
 		Type type_         = UNKNOWN;
 	};
 
-private:
-	T evalInternal() {
-		T result;
+	// the expression is compiled into a small postfix program which can be
+	// run as many times as needed without parsing it again
+	struct Instruction {
+		enum Opcode {
+			CONSTANT,
+			VARIABLE,
+			READ_MEMORY,
+			UNARY,
+			BINARY
+		};
 
-		getToken();
-		evalExp(result);
+		Opcode opcode                      = CONSTANT;
+		typename Token::Operator operator_ = Token::NONE;
+		T value                            = T();
+		int variable                       = 0;
+	};
 
-		return result;
+public:
+	Result<void, ExpressionError> compile() noexcept {
+		try {
+			compileInternal();
+			return {};
+		} catch (const ExpressionError &e) {
+			program_.clear();
+			return make_unexpected(e);
+		}
+	}
+
+	Result<void, ExpressionError> compile(const variable_binder_t &binder) noexcept {
+		const Result<void, ExpressionError> compiled = compile();
+		if (compiled && binder) {
+			for (std::size_t i = 0; i < variables_.size(); ++i) {
+				bindings_[i] = binder(variables_[i]);
+			}
+		}
+		return compiled;
 	}
 
-public:
 	Result<T, ExpressionError> evaluate() noexcept {
+		return evaluate(variableReader_, memoryReader_);
+	}
+
+	Result<T, ExpressionError> evaluate(const variable_getter_t &vg, const memoryReader_t &mr) noexcept {
+		return evaluate(vg, mr, bound_reader_t());
+	}
+
+	Result<T, ExpressionError> evaluate(const variable_getter_t &vg, const memoryReader_t &mr, const bound_reader_t &br) noexcept {
+		if (program_.empty()) {
+			const Result<void, ExpressionError> compiled = compile();
+			if (!compiled) {
+				return make_unexpected(compiled.error());
+			}
+		}
+
 		try {
-			return evalInternal();
+			return execute(vg, mr, br);
 		} catch (const ExpressionError &e) {
 			return make_unexpected(e);
 		}
 	}
 
+	[[nodiscard]] const QString &expression() const { return expression_; }
+
 private:
-	void evalExp(T &result);
-	void evalExp0(T &result);
-	void evalExp1(T &result);
-	void evalExp2(T &result);
-	void evalExp3(T &result);
-	void evalExp4(T &result);
-	void evalExp5(T &result);
-	void evalExp6(T &result);
-	void evalExp7(T &result);
-	void evalAtom(T &result);
+	void compileInternal();
+	T execute(const variable_getter_t &vg, const memoryReader_t &mr, const bound_reader_t &br);
+
+private:
+	void evalExp();
+	void evalExp0();
+	void evalExp1();
+	void evalExp2();
+	void evalExp3();
+	void evalExp4();
+	void evalExp5();
+	void evalExp6();
+	void evalExp7();
+	void evalAtom();
 	void getToken();
+	void emitOp(typename Instruction::Opcode opcode, typename Token::Operator oper);
 
 private:
 	QString expression_;
@@ -179,6 +235,13 @@ private:
 	Token token_;
 	variable_getter_t variableReader_;
 	memoryReader_t memoryReader_;
+
+	std::vector<Instruction> program_;
+	std::vector<QString> variables_;
+	std::vector<int> bindings_;
+	std::vector<T> stack_;
+	std::vector<T> values_;
+	std::vector<bool> valuesLoaded_;
 };
 
 #include "Expression.tcc"
@@ -19,6 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef EXPRESSION_20070402_TCC_
 #define EXPRESSION_20070402_TCC_
 
+#include <algorithm>
+
 namespace detail {
 
 inline bool is_delim(QChar ch) {
@@ -36,17 +38,218 @@ Expression<T>::Expression(const QString &s, variable_getter_t vg, memoryReader_t
 	: expression_(s), expressionPtr_(expression_.begin()), variableReader_(vg), memoryReader_(mr) {
 }
 
+//------------------------------------------------------------------------------
+// Name: compileInternal
+// Desc: parses the expression into program_
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::compileInternal() {
+	program_.clear();
+	variables_.clear();
+
+	expressionPtr_ = expression_.begin();
+
+	getToken();
+	evalExp();
+
+	bindings_.assign(variables_.size(), -1);
+}
+
+//------------------------------------------------------------------------------
+// Name: emitOp
+// Desc:
+//------------------------------------------------------------------------------
+template <class T>
+void Expression<T>::emitOp(typename Instruction::Opcode opcode, typename Token::Operator oper) {
+	Instruction insn;
+	insn.opcode    = opcode;
+	insn.operator_ = oper;
+	program_.push_back(insn);
+}
+
+//------------------------------------------------------------------------------
+// Name: execute
+// Desc: runs the compiled program, each variable is only looked up once. One
+//       which was bound when compiling is read by its binding, the name is
+//       only used if that doesn't work out
+//------------------------------------------------------------------------------
+template <class T>
+T Expression<T>::execute(const variable_getter_t &vg, const memoryReader_t &mr, const bound_reader_t &br) {
+
+	stack_.clear();
+	values_.resize(variables_.size());
+	valuesLoaded_.assign(variables_.size(), false);
+
+	for (const Instruction &insn : program_) {
+		switch (insn.opcode) {
+		case Instruction::CONSTANT:
+			stack_.push_back(insn.value);
+			break;
+		case Instruction::VARIABLE:
+			if (!valuesLoaded_[insn.variable]) {
+				bool ok = false;
+				ExpressionError error(ExpressionError::UnknownVariable);
+
+				const int binding = bindings_[insn.variable];
+				if (binding != -1 && br) {
+					values_[insn.variable] = br(binding, &ok, &error);
+				}
+
+				if (!ok) {
+					if (!vg) {
+						throw error;
+					}
+
+					values_[insn.variable] = vg(variables_[insn.variable], &ok, &error);
+					if (!ok) {
+						throw error;
+					}
+				}
+
+				valuesLoaded_[insn.variable] = true;
+			}
+
+			stack_.push_back(values_[insn.variable]);
+			break;
+		case Instruction::READ_MEMORY:
+			if (mr) {
+				bool ok;
+				ExpressionError error;
+
+				stack_.back() = mr(stack_.back(), &ok, &error);
+				if (!ok) {
+					throw error;
+				}
+			} else {
+				throw ExpressionError(ExpressionError::CannotReadMemory);
+			}
+			break;
+		case Instruction::UNARY: {
+			T &result = stack_.back();
+			switch (insn.operator_) {
+			case Token::PLUS:
+				// this may seems like a waste, but unary + can be overloaded for a type
+				// to have a non-nop effect!
+				result = +result;
+				break;
+			case Token::MINUS:
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4146)
+#endif
+				result = -result;
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+				break;
+			case Token::CMP:
+				result = ~result;
+				break;
+			case Token::NOT:
+				result = !result;
+				break;
+			default:
+				break;
+			}
+			break;
+		}
+		case Instruction::BINARY: {
+			const T partial_value = stack_.back();
+			stack_.pop_back();
+
+			T &result = stack_.back();
+			switch (insn.operator_) {
+			case Token::LOGICAL_AND:
+				result = result && partial_value;
+				break;
+			case Token::LOGICAL_OR:
+				result = result || partial_value;
+				break;
+			case Token::AND:
+				result &= partial_value;
+				break;
+			case Token::OR:
+				result |= partial_value;
+				break;
+			case Token::XOR:
+				result ^= partial_value;
+				break;
+			case Token::LT:
+				result = result < partial_value;
+				break;
+			case Token::LE:
+				result = result <= partial_value;
+				break;
+			case Token::GT:
+				result = result > partial_value;
+				break;
+			case Token::GE:
+				result = result >= partial_value;
+				break;
+			case Token::EQ:
+				result = result == partial_value;
+				break;
+			case Token::NE:
+				result = result != partial_value;
+				break;
+			case Token::LSHFT:
+				result <<= partial_value;
+				break;
+			case Token::RSHFT:
+				result >>= partial_value;
+				break;
+			case Token::PLUS:
+				result += partial_value;
+				break;
+			case Token::MINUS:
+#ifdef _MSC_VER
+#pragma warning(push)
+/* disable warning about applying unary - to an unsigned type */
+#pragma warning(disable : 4146)
+#endif
+				result -= partial_value;
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+				break;
+			case Token::MUL:
+				result *= partial_value;
+				break;
+			case Token::DIV:
+				if (partial_value == 0) {
+					throw ExpressionError(ExpressionError::DivideByZero);
+				}
+				result /= partial_value;
+				break;
+			case Token::MOD:
+				if (partial_value == 0) {
+					throw ExpressionError(ExpressionError::DivideByZero);
+				}
+				result %= partial_value;
+				break;
+			default:
+				break;
+			}
+			break;
+		}
+		}
+	}
+
+	Q_ASSERT(stack_.size() == 1);
+	return stack_.back();
+}
+
 //------------------------------------------------------------------------------
 // Name: evalExp
 // Desc: private entry point with sanity check
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::evalExp(T &result) {
+void Expression<T>::evalExp() {
 	if (token_.type_ == Token::UNKNOWN) {
 		throw ExpressionError(ExpressionError::Syntax);
 	}
 
-	evalExp0(result);
+	evalExp0();
 
 	switch (token_.type_) {
 	case Token::OPERATOR:
@@ -74,26 +277,13 @@ void Expression<T>::evalExp(T &result) {
 // Desc: logic
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::evalExp0(T &result) {
-	evalExp1(result);
+void Expression<T>::evalExp0() {
+	evalExp1();
 
 	for (Token op = token_; op.operator_ == Token::LOGICAL_AND || op.operator_ == Token::LOGICAL_OR; op = token_) {
-		T partial_value;
-
 		getToken();
-		evalExp1(partial_value);
-
-		// add or subtract
-		switch (op.operator_) {
-		case Token::LOGICAL_AND:
-			result = result && partial_value;
-			break;
-		case Token::LOGICAL_OR:
-			result = result || partial_value;
-			break;
-		default:
-			break;
-		}
+		evalExp1();
+		emitOp(Instruction::BINARY, op.operator_);
 	}
 }
 
@@ -102,29 +292,13 @@ void Expression<T>::evalExp0(T &result) {
 // Desc: binary logic
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::evalExp1(T &result) {
-	evalExp2(result);
+void Expression<T>::evalExp1() {
+	evalExp2();
 
 	for (Token op = token_; op.operator_ == Token::AND || op.operator_ == Token::OR || op.operator_ == Token::XOR; op = token_) {
-		T partial_value;
-
 		getToken();
-		evalExp2(partial_value);
-
-		// add or subtract
-		switch (op.operator_) {
-		case Token::AND:
-			result &= partial_value;
-			break;
-		case Token::OR:
-			result |= partial_value;
-			break;
-		case Token::XOR:
-			result ^= partial_value;
-			break;
-		default:
-			break;
-		}
+		evalExp2();
+		emitOp(Instruction::BINARY, op.operator_);
 	}
 }
 
@@ -133,38 +307,13 @@ void Expression<T>::evalExp1(T &result) {
 // Desc: comparisons
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::evalExp2(T &result) {
-	evalExp3(result);
+void Expression<T>::evalExp2() {
+	evalExp3();
 
 	for (Token op = token_; op.operator_ == Token::LT || op.operator_ == Token::LE || op.operator_ == Token::GT || op.operator_ == Token::GE || op.operator_ == Token::EQ || op.operator_ == Token::NE; op = token_) {
-		T partial_value;
-
 		getToken();
-		evalExp3(partial_value);
-
-		// perform the relational operation
-		switch (op.operator_) {
-		case Token::LT:
-			result = result < partial_value;
-			break;
-		case Token::LE:
-			result = result <= partial_value;
-			break;
-		case Token::GT:
-			result = result > partial_value;
-			break;
-		case Token::GE:
-			result = result >= partial_value;
-			break;
-		case Token::EQ:
-			result = result == partial_value;
-			break;
-		case Token::NE:
-			result = result != partial_value;
-			break;
-		default:
-			break;
-		}
+		evalExp3();
+		emitOp(Instruction::BINARY, op.operator_);
 	}
 }
 
@@ -173,26 +322,13 @@ void Expression<T>::evalExp2(T &result) {
 // Desc: shifts
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::evalExp3(T &result) {
-	evalExp4(result);
+void Expression<T>::evalExp3() {
+	evalExp4();
 
 	for (Token op = token_; op.operator_ == Token::RSHFT || op.operator_ == Token::LSHFT; op = token_) {
-		T partial_value;
-
 		getToken();
-		evalExp4(partial_value);
-
-		// perform the shift operation
-		switch (op.operator_) {
-		case Token::LSHFT:
-			result <<= partial_value;
-			break;
-		case Token::RSHFT:
-			result >>= partial_value;
-			break;
-		default:
-			break;
-		}
+		evalExp4();
+		emitOp(Instruction::BINARY, op.operator_);
 	}
 }
 
@@ -201,34 +337,13 @@ void Expression<T>::evalExp3(T &result) {
 // Desc: addition/subtraction
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::evalExp4(T &result) {
-	evalExp5(result);
+void Expression<T>::evalExp4() {
+	evalExp5();
 
 	for (Token op = token_; op.operator_ == Token::PLUS || op.operator_ == Token::MINUS; op = token_) {
-		T partial_value;
-
 		getToken();
-		evalExp5(partial_value);
-
-		// add or subtract
-		switch (op.operator_) {
-		case Token::PLUS:
-			result += partial_value;
-			break;
-		case Token::MINUS:
-#ifdef _MSC_VER
-#pragma warning(push)
-/* disable warning about applying unary - to an unsigned type */
-#pragma warning(disable : 4146)
-#endif
-			result -= partial_value;
-#ifdef _MSC_VER
-#pragma warning(pop)
-#endif
-			break;
-		default:
-			break;
-		}
+		evalExp5();
+		emitOp(Instruction::BINARY, op.operator_);
 	}
 }
 
@@ -237,35 +352,13 @@ void Expression<T>::evalExp4(T &result) {
 // Desc: multiplication/division
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::evalExp5(T &result) {
-	evalExp6(result);
+void Expression<T>::evalExp5() {
+	evalExp6();
 
 	for (Token op = token_; op.operator_ == Token::MUL || op.operator_ == Token::DIV || op.operator_ == Token::MOD; op = token_) {
-		T partial_value;
-
 		getToken();
-		evalExp6(partial_value);
-
-		// mul, div, or modulus
-		switch (op.operator_) {
-		case Token::MUL:
-			result *= partial_value;
-			break;
-		case Token::DIV:
-			if (partial_value == 0) {
-				throw ExpressionError(ExpressionError::DivideByZero);
-			}
-			result /= partial_value;
-			break;
-		case Token::MOD:
-			if (partial_value == 0) {
-				throw ExpressionError(ExpressionError::DivideByZero);
-			}
-			result %= partial_value;
-			break;
-		default:
-			break;
-		}
+		evalExp6();
+		emitOp(Instruction::BINARY, op.operator_);
 	}
 }
 
@@ -274,39 +367,15 @@ void Expression<T>::evalExp5(T &result) {
 // Desc: unary expressions
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::evalExp6(T &result) {
+void Expression<T>::evalExp6() {
 
 	Token op = token_;
 	if (op.operator_ == Token::PLUS || op.operator_ == Token::MINUS || op.operator_ == Token::CMP || op.operator_ == Token::NOT) {
 		getToken();
-	}
-
-	evalExp7(result);
-
-	switch (op.operator_) {
-	case Token::PLUS:
-		// this may seems like a waste, but unary + can be overloaded for a type
-		// to have a non-nop effect!
-		result = +result;
-		break;
-	case Token::MINUS:
-#ifdef _MSC_VER
-#pragma warning(push)
-#pragma warning(disable : 4146)
-#endif
-		result = -result;
-#ifdef _MSC_VER
-#pragma warning(pop)
-#endif
-		break;
-	case Token::CMP:
-		result = ~result;
-		break;
-	case Token::NOT:
-		result = !result;
-		break;
-	default:
-		break;
+		evalExp7();
+		emitOp(Instruction::UNARY, op.operator_);
+	} else {
+		evalExp7();
 	}
 }
 
@@ -315,14 +384,14 @@ void Expression<T>::evalExp6(T &result) {
 // Desc: sub-expressions
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::evalExp7(T &result) {
+void Expression<T>::evalExp7() {
 
 	switch (token_.operator_) {
 	case Token::LPAREN:
 		getToken();
 
 		// get sub-expression
-		evalExp0(result);
+		evalExp0();
 
 		if (token_.operator_ != Token::RPAREN) {
 			throw ExpressionError(ExpressionError::UnbalancedParens);
@@ -334,37 +403,23 @@ void Expression<T>::evalExp7(T &result) {
 		throw ExpressionError(ExpressionError::UnbalancedParens);
 		break;
 	case Token::LBRACE:
-		do {
-			getToken();
-
-			// get sub-expression
-			T effective_address;
-			evalExp0(effective_address);
-
-			if (memoryReader_) {
-				bool ok;
-				ExpressionError error;
+		getToken();
 
-				result = memoryReader_(effective_address, &ok, &error);
-				if (!ok) {
-					throw error;
-				}
-			} else {
-				throw ExpressionError(ExpressionError::CannotReadMemory);
-			}
+		// get sub-expression, the effective address
+		evalExp0();
+		emitOp(Instruction::READ_MEMORY, Token::NONE);
 
-			if (token_.operator_ != Token::RBRACE) {
-				throw ExpressionError(ExpressionError::UnbalancedBraces);
-			}
+		if (token_.operator_ != Token::RBRACE) {
+			throw ExpressionError(ExpressionError::UnbalancedBraces);
+		}
 
-			getToken();
-		} while (0);
+		getToken();
 		break;
 	case Token::RBRACE:
 		throw ExpressionError(ExpressionError::UnbalancedBraces);
 		break;
 	default:
-		evalAtom(result);
+		evalAtom();
 		break;
 	}
 }
@@ -374,30 +429,38 @@ void Expression<T>::evalExp7(T &result) {
 // Desc: atoms (variables/constants)
 //------------------------------------------------------------------------------
 template <class T>
-void Expression<T>::evalAtom(T &result) {
+void Expression<T>::evalAtom() {
 
 	switch (token_.type_) {
-	case Token::VARIABLE:
-		if (variableReader_) {
-			bool ok;
-			ExpressionError error;
-			result = variableReader_(token_.data_, &ok, &error);
-			if (!ok) {
-				throw error;
-			}
-		} else {
-			throw ExpressionError(ExpressionError::UnknownVariable);
+	case Token::VARIABLE: {
+		// each distinct variable gets one slot, so that it is only looked up
+		// once per evaluation no matter how often it is used
+		auto it = std::find(variables_.begin(), variables_.end(), token_.data_);
+		if (it == variables_.end()) {
+			it = variables_.insert(variables_.end(), token_.data_);
 		}
+
+		Instruction insn;
+		insn.opcode   = Instruction::VARIABLE;
+		insn.variable = static_cast<int>(it - variables_.begin());
+		program_.push_back(insn);
+
 		getToken();
 		break;
-	case Token::NUMBER:
+	}
+	case Token::NUMBER: {
 		bool ok;
-		result = token_.data_.toULongLong(&ok, 0);
+		Instruction insn;
+		insn.opcode = Instruction::CONSTANT;
+		insn.value  = token_.data_.toULongLong(&ok, 0);
 		if (!ok) {
 			throw ExpressionError(ExpressionError::InvalidNumber);
 		}
+		program_.push_back(insn);
+
 		getToken();
 		break;
+	}
 	default:
 		throw ExpressionError(ExpressionError::Syntax);
 		break;
@@ -50,6 +50,7 @@ public:
 	void insert(const BasicBlock &bb);
 	void insert(BasicBlock &&bb);
 	void addReference();
+	void setReferenceCount(int count);
 	[[nodiscard]] Type type() const;
 	void setType(Type t);
 
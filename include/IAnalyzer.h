@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSet>
 #include <functional>
 #include <memory>
+#include <vector>
 
 class IRegion;
 
@@ -50,6 +51,7 @@ public:
 	[[nodiscard]] virtual FunctionMap functions(const std::shared_ptr<IRegion> &region) const = 0;
 	[[nodiscard]] virtual FunctionMap functions() const                                       = 0;
 	[[nodiscard]] virtual QSet<edb::address_t> specifiedFunctions() const { return {}; }
+	[[nodiscard]] virtual std::vector<edb::address_t> referencesTo(edb::address_t) const { return {}; }
 	[[nodiscard]] virtual Result<edb::address_t, QString> findContainingFunction(edb::address_t address) const                  = 0;
 	virtual void analyze(const std::shared_ptr<IRegion> &region)                                                                = 0;
 	virtual void invalidateAnalysis()                                                                                           = 0;
@@ -19,25 +19,32 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef IBREAKPOINT_H_20060720_
 #define IBREAKPOINT_H_20060720_
 
+#include "API.h"
 #include "Types.h"
 
 #include <QString>
+#include <QStringList>
 #include <exception>
+#include <memory>
+#include <vector>
 
 class QByteArray;
 
+template <class T>
+class Expression;
+
 class BreakpointCreationError : public std::exception {
 	[[nodiscard]] const char *what() const noexcept override {
 		return "BreakpointCreationError";
 	}
 };
 
-class IBreakpoint {
+class EDB_EXPORT IBreakpoint {
 protected:
-	IBreakpoint() = default;
+	IBreakpoint();
 
 public:
-	virtual ~IBreakpoint() = default;
+	virtual ~IBreakpoint();
 
 	enum class TypeId : int {
 		Automatic, // should be the default if the user hasn't chosen anything other
@@ -67,8 +74,33 @@ public:
 	virtual void setType(TypeId type)    = 0;
 
 public:
-	QString condition;
+	[[nodiscard]] const QString &condition() const { return condition_; }
+
+	// the condition compiled when it was set, nullptr if there is no condition
+	// or it failed to compile
+	[[nodiscard]] Expression<edb::address_t> *compiledCondition() const { return compiledCondition_.get(); }
+
+	void setCondition(const QString &condition);
+
+public:
+	// a breakpoint with trace expressions is a tracepoint, it records the
+	// value of each expression when hit and never stops
+	[[nodiscard]] bool isTracepoint() const { return !traceExpressions_.isEmpty(); }
+	[[nodiscard]] const QStringList &traceExpressions() const { return traceExpressions_; }
+
+	// one entry per trace expression, nullptr for those which failed to compile
+	[[nodiscard]] const std::vector<std::unique_ptr<Expression<edb::address_t>>> &compiledTraceExpressions() const { return compiledTrace_; }
+
+	void setTraceExpressions(const QStringList &expressions);
+
+public:
 	quint64 tag = 0;
+
+private:
+	QString condition_;
+	std::unique_ptr<Expression<edb::address_t>> compiledCondition_;
+	QStringList traceExpressions_;
+	std::vector<std::unique_ptr<Expression<edb::address_t>>> compiledTrace_;
 };
 
 Q_DECLARE_METATYPE(IBreakpoint::TypeId)
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define IDEBUGGER_H_20061101_
 
 #include "IBreakpoint.h"
+#include "IThread.h"
 #include "OSTypes.h"
 #include "Types.h"
 #include <QByteArray>
@@ -31,8 +32,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <memory>
 #include <vector>
 
+class DebugEventNotifier;
 class IDebugEvent;
 class IProcess;
+class QObject;
 class IState;
 class State;
 class Status;
@@ -91,6 +94,12 @@ public:
 	virtual void endDebugSession()                                                                                                           = 0;
 	virtual void kill()                                                                                                                      = 0;
 
+public:
+	// cores which can tell on their own when waitDebugEvent() has something to
+	// return provide a notifier here. Otherwise this is nullptr and
+	// waitDebugEvent() needs to be polled.
+	[[nodiscard]] virtual DebugEventNotifier *eventNotifier() const { return nullptr; }
+
 public:
 	// basic breakpoint management
 	// TODO(eteran): these should be logically moved to IProcess
@@ -102,6 +111,11 @@ public:
 	virtual void clearBreakpoints()                                                                 = 0;
 	virtual void removeBreakpoint(edb::address_t address)                                           = 0;
 
+public:
+	// hardware breakpoints, programs the debug registers of every thread of
+	// the process. Cores which can, also apply them to threads created later
+	virtual Status setDebugRegisters(const IThread::DebugRegisters &regs) = 0;
+
 public:
 	virtual void setIgnoredExceptions(const QList<qlonglong> &exceptions) = 0;
 
@@ -37,6 +37,15 @@ class IProcess {
 public:
 	virtual ~IProcess() = default;
 
+public:
+	// a single element of a scatter/gather read, see readBytesV
+	struct ReadRequest {
+		edb::address_t address;
+		void *buf;
+		std::size_t len;
+		std::size_t read; // filled in by readBytesV
+	};
+
 public:
 	// legal to call when not attached
 	[[nodiscard]] virtual QDateTime startTime() const                     = 0;
@@ -74,6 +83,20 @@ public:
 	virtual std::size_t readPages(edb::address_t address, void *buf, size_t count) const = 0;
 	virtual std::size_t writeBytes(edb::address_t address, const void *buf, size_t len)  = 0;
 	virtual void setCurrentThread(IThread &thread)                                       = 0;
+
+public:
+	// reads every request in one batch where the platform supports it.
+	// Each request's "read" member is set to the number of bytes read for it
+	// (with the same short read semantics as readBytes), the total number of
+	// bytes read is returned
+	virtual std::size_t readBytesV(ReadRequest *requests, std::size_t count) const {
+		std::size_t total = 0;
+		for (std::size_t i = 0; i < count; ++i) {
+			requests[i].read = readBytes(requests[i].address, requests[i].buf, requests[i].len);
+			total += requests[i].read;
+		}
+		return total;
+	}
 };
 
 #endif
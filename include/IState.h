@@ -57,6 +57,14 @@ public:
 	// GP
 	[[nodiscard]] virtual Register gpRegister(size_t n) const = 0;
 
+public:
+	// for registers which are read over and over, like the ones in a
+	// breakpoint condition. registerIndex looks the name up once, -1 if the
+	// register can't be read this way, and registerValue reads it back by
+	// that index without any string handling, false if it isn't filled in
+	[[nodiscard]] virtual int registerIndex(const QString &reg) const            = 0;
+	[[nodiscard]] virtual bool registerValue(int index, edb::reg_t *value) const = 0;
+
 public:
 	// This is a more generic means to request architecture
 	// specific registers. The type should be the result of
@@ -20,12 +20,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define ITHREAD_H_20150529_
 
 #include "OSTypes.h"
+#include "State.h"
 #include "Status.h"
 #include "Types.h"
-
-class State;
+#include <cstddef>
 
 class IThread {
+public:
+	// the part of the debug registers which the debugger programs,
+	// DR0-DR3 hold the addresses and DR7 says how each of them is used
+	struct DebugRegisters {
+		edb::reg_t address[4] = {};
+		edb::reg_t control    = 0;
+	};
+
 public:
 	virtual ~IThread() = default;
 
@@ -40,6 +48,19 @@ public:
 	virtual void getState(State *state)       = 0;
 	virtual void setState(const State &state) = 0;
 
+	// writes only the debug registers, the default implementation has to go
+	// through a full getState()/setState() round trip
+	virtual Status setDebugRegisters(const DebugRegisters &regs) {
+		State state;
+		getState(&state);
+		for (std::size_t i = 0; i < 4; ++i) {
+			state.setDebugRegister(i, regs.address[i]);
+		}
+		state.setDebugRegister(7, regs.control);
+		setState(state);
+		return Status::Ok;
+	}
+
 public:
 	virtual Status step()                          = 0;
 	virtual Status step(edb::EventStatus status)   = 0;
@@ -0,0 +1,109 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INSTRUCTION_CACHE_H_20240301_
+#define INSTRUCTION_CACHE_H_20240301_
+
+#include "API.h"
+#include "Instruction.h"
+#include "Types.h"
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+// Remembers decoded instructions by address, so that views which get repainted
+// or scrolled over the same code don't have to decode it over and over. An
+// entry is only handed out while the bytes it was decoded from still match the
+// bytes the caller sees at that address, so a stale entry can never be
+// returned. Writes, breakpoint changes and unmapped regions invalidate the
+// affected range as well, which keeps stale entries from piling up.
+class EDB_EXPORT InstructionCache {
+public:
+	class Entry {
+	public:
+		Entry(edb::address_t address, const uint8_t *buf, std::size_t size);
+		Entry(const Entry &)            = delete;
+		Entry &operator=(const Entry &) = delete;
+
+	public:
+		[[nodiscard]] const edb::Instruction &instruction() const { return instruction_; }
+		[[nodiscard]] const QString &text() const;
+		[[nodiscard]] bool matches(const uint8_t *buf, std::size_t size) const;
+
+	private:
+		edb::Instruction instruction_;
+		uint8_t bytes_[edb::Instruction::MaxSize];
+		std::size_t size_;
+		mutable std::once_flag textOnce_;
+		mutable QString text_;
+	};
+
+	struct Range {
+		edb::address_t address;
+		std::size_t size;
+	};
+
+public:
+	explicit InstructionCache(std::size_t capacity);
+	~InstructionCache()                                   = default;
+	InstructionCache(const InstructionCache &)            = delete;
+	InstructionCache &operator=(const InstructionCache &) = delete;
+
+public:
+	[[nodiscard]] std::shared_ptr<const Entry> find(edb::address_t address, const void *buf, std::size_t size);
+	void invalidate(edb::address_t address, std::size_t size);
+	void clear();
+
+public:
+	// every invalidation is numbered, so that anything else which remembers
+	// facts derived from code can catch up on what changed since it last looked
+	[[nodiscard]] uint64_t sequence() const;
+	[[nodiscard]] bool changesSince(uint64_t sequence, std::vector<Range> *ranges) const;
+
+private:
+	using Map = std::map<edb::address_t, std::shared_ptr<const Entry>>;
+
+private:
+	// an invalidated range, and the last invalidation which grew it
+	struct LogEntry {
+		Range range;
+		uint64_t sequence;
+	};
+
+private:
+	void insert(edb::address_t address, const std::shared_ptr<const Entry> &entry);
+	void logChange(edb::address_t address, std::size_t size);
+
+private:
+	static constexpr std::size_t LogSize = 64;
+
+	mutable std::shared_mutex mutex_;
+	std::size_t capacity_;
+	uint64_t generation_ = 0;
+	Map current_;
+	Map previous_;
+	std::vector<LogEntry> log_;
+	uint64_t sequence_ = 0;
+	uint64_t cleared_  = 0;
+};
+
+#endif
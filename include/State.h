@@ -66,6 +66,8 @@ public:
 	[[nodiscard]] Register gpRegister(size_t n) const;
 	[[nodiscard]] Register instructionPointerRegister() const;
 	[[nodiscard]] Register value(const QString &reg) const;
+	[[nodiscard]] int registerIndex(const QString &reg) const;
+	[[nodiscard]] bool registerValue(int index, edb::reg_t *value) const;
 	void adjustStack(int bytes);
 	void clear();
 
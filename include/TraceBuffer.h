@@ -0,0 +1,75 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_BUFFER_H_20240301_
+#define TRACE_BUFFER_H_20240301_
+
+#include "API.h"
+#include "OSTypes.h"
+#include "Types.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// A fixed size ring of tracepoint hits. All storage is allocated up front,
+// recording a hit never allocates and never blocks. There is a single writer
+// (whoever handles debug events), readers may page through it at any time and
+// simply get told when a record they wanted has already been overwritten.
+class EDB_EXPORT TraceBuffer {
+public:
+	static constexpr std::size_t MaxValues = 8;
+
+	struct Record {
+		uint64_t sequence = 0;
+		edb::address_t address;
+		edb::tid_t tid   = 0;
+		std::size_t count = 0;
+		edb::address_t values[MaxValues];
+		bool valid[MaxValues] = {};
+	};
+
+public:
+	explicit TraceBuffer(std::size_t capacity);
+	~TraceBuffer() = default;
+	TraceBuffer(const TraceBuffer &)            = delete;
+	TraceBuffer &operator=(const TraceBuffer &) = delete;
+
+public:
+	void push(edb::address_t address, edb::tid_t tid, const edb::address_t *values, const bool *valid, std::size_t count) noexcept;
+	void clear() noexcept;
+
+public:
+	[[nodiscard]] bool read(uint64_t sequence, Record *record) const noexcept;
+	[[nodiscard]] uint64_t first() const noexcept;
+	[[nodiscard]] uint64_t end() const noexcept;
+	[[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+
+private:
+	struct Slot {
+		std::atomic<uint64_t> sequence{0};
+		Record record;
+	};
+
+private:
+	std::unique_ptr<Slot[]> slots_;
+	std::size_t capacity_;
+	std::atomic<uint64_t> head_{0};
+	std::atomic<uint64_t> base_{0};
+};
+
+#endif
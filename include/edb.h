@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "API.h"
 #include "IBinary.h"
+#include "OSTypes.h"
 #include "Status.h"
 #include "Types.h"
 #include <QMap>
@@ -37,12 +38,14 @@ class IBreakpoint;
 class IDebugEventHandler;
 class IDebugEvent;
 class IDebugger;
+class InstructionCache;
 class IPlugin;
 class IRegion;
 class ISymbolManager;
 class MemoryRegions;
 class Register;
 class State;
+class TraceBuffer;
 
 class QAbstractScrollArea;
 class QByteArray;
@@ -97,6 +100,10 @@ EDB_EXPORT void remove_breakpoint(address_t address);
 EDB_EXPORT void set_breakpoint_condition(address_t address, const QString &condition);
 EDB_EXPORT void toggle_breakpoint(address_t address);
 
+// tracepoints
+EDB_EXPORT TraceBuffer &trace_buffer();
+EDB_EXPORT void record_tracepoint(const IBreakpoint &bp, tid_t tid, const State &state);
+
 EDB_EXPORT address_t current_data_view_address();
 EDB_EXPORT address_t instruction_pointer_address();
 
@@ -148,6 +155,9 @@ EDB_EXPORT QString find_function_symbol(address_t address, const QString &defaul
 // ask the user for either a value or a variable (register name and such)
 EDB_EXPORT address_t get_value(address_t address, bool *ok, ExpressionError *err);
 EDB_EXPORT address_t get_variable(const QString &s, bool *ok, ExpressionError *err);
+EDB_EXPORT address_t get_state_variable(const State &state, const QString &s, bool *ok, ExpressionError *err);
+EDB_EXPORT int bind_state_variable(const QString &s);
+EDB_EXPORT address_t get_bound_state_variable(const State &state, int index, bool *ok, ExpressionError *err);
 
 // hook the debug event system
 EDB_EXPORT edb::EventStatus execute_debug_event_handlers(const std::shared_ptr<IDebugEvent> &e);
@@ -157,6 +167,9 @@ EDB_EXPORT void remove_debug_event_handler(IDebugEventHandler *p);
 EDB_EXPORT IAnalyzer *set_analyzer(IAnalyzer *p);
 EDB_EXPORT IAnalyzer *analyzer();
 
+// decoded instructions, shared by everything which disassembles the debuggee
+EDB_EXPORT InstructionCache &instruction_cache();
+
 // reads up to size bytes from address (stores how many it could read in size)
 EDB_EXPORT bool get_instruction_bytes(address_t address, uint8_t *buf, int *size);
 EDB_EXPORT bool get_instruction_bytes(address_t address, uint8_t *buf, size_t *size);
@@ -174,6 +187,10 @@ int get_instruction_bytes(address_t address, uint8_t (&buffer)[N]) {
 EDB_EXPORT QString disassemble_address(address_t address);
 
 EDB_EXPORT std::unique_ptr<IBinary> get_binary_info(const std::shared_ptr<IRegion> &region);
+EDB_EXPORT std::shared_ptr<IBinary> cached_binary_info(const std::shared_ptr<IRegion> &region);
+EDB_EXPORT void invalidate_binary_info(const std::shared_ptr<IRegion> &region);
+EDB_EXPORT void clear_binary_info();
+EDB_EXPORT uint64_t binary_info_probes_saved();
 EDB_EXPORT const Prototype *get_function_info(const QString &function);
 
 EDB_EXPORT address_t locate_main_function();
@@ -0,0 +1,670 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AnalysisCache.h"
+#include "Configuration.h"
+#include "Function.h"
+#include "Instruction.h"
+#include "edb.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QtDebug>
+
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+#include "libELF/elf_model.h"
+
+namespace AnalyzerPlugin {
+
+namespace {
+
+constexpr char Magic[8]      = {'E', 'D', 'B', 'A', 'N', 'L', 'Y', 'Z'};
+constexpr uint32_t Version   = 1;
+constexpr uint32_t FlagFuzzy = 0x00000001;
+constexpr int MaxKeySize     = 32;
+
+// everything in the file is a multiple of 8 bytes in size, so
+// every array in it is properly aligned in a mapping of it
+
+struct FileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	uint64_t base; // where the region was loaded when the file was written
+	uint64_t size;
+	uint64_t pageSize;
+	uint8_t key[MaxKeySize];
+	uint32_t keySize;
+	uint32_t pageCount;
+	uint32_t recordCount;
+	uint32_t blockCount;
+	uint32_t regionBlockCount; // the rest of the blocks belong to functions
+	uint32_t functionCount;
+	uint32_t referenceCount;
+	uint32_t knownCount;
+	uint32_t fuzzyCount;
+	uint32_t reserved;
+};
+
+struct FileRecord {
+	uint64_t target;
+	uint32_t offset; // from the start of the region
+	uint8_t size;
+	uint8_t flow;
+	uint16_t reserved;
+};
+
+struct FileBlock {
+	uint32_t firstRecord;
+	uint32_t recordCount;
+	uint32_t firstReference;
+	uint32_t referenceCount;
+};
+
+struct FileFunction {
+	uint64_t entry;
+	uint32_t firstBlock;
+	uint32_t blockCount;
+	int32_t referenceCount;
+	uint32_t type;
+};
+
+struct FileReference {
+	uint64_t site;
+	uint64_t target;
+};
+
+static_assert(sizeof(FileHeader) % 8 == 0, "FileHeader must keep the arrays after it aligned");
+static_assert(sizeof(FileRecord) == 16, "FileRecord has an unexpected size");
+static_assert(sizeof(FileBlock) == 16, "FileBlock has an unexpected size");
+static_assert(sizeof(FileFunction) == 24, "FileFunction has an unexpected size");
+static_assert(sizeof(FileReference) == 16, "FileReference has an unexpected size");
+
+// what goes into the file, before it is written out
+struct Tables {
+	std::vector<FileRecord> records;
+	std::vector<FileBlock> blocks;
+	std::vector<FileFunction> functions;
+	std::vector<FileReference> references;
+
+	// where the record of every instruction that was written went
+	QHash<edb::address_t, uint32_t> recordIndex;
+};
+
+/**
+ * @brief elf_build_id
+ * @param ptr a mapping of a whole ELF file
+ * @param size
+ * @return the GNU build-id of the file, or an empty array if it has none
+ */
+template <class M>
+QByteArray elf_build_id(const uchar *ptr, qint64 size) {
+
+	using elf_header = typename M::elf_header;
+	using elf_phdr   = typename M::elf_phdr;
+	using elf_nhdr   = typename M::elf_nhdr;
+
+	const auto file_size = static_cast<uint64_t>(size);
+	if (file_size < sizeof(elf_header)) {
+		return QByteArray();
+	}
+
+	auto header = reinterpret_cast<const elf_header *>(ptr);
+	if (header->e_phentsize != sizeof(elf_phdr) || header->e_phoff > file_size || header->e_phnum > (file_size - header->e_phoff) / sizeof(elf_phdr)) {
+		return QByteArray();
+	}
+
+	auto phdr = reinterpret_cast<const elf_phdr *>(ptr + header->e_phoff);
+	for (int i = 0; i < header->e_phnum; ++i) {
+		if (phdr[i].p_type != PT_NOTE || phdr[i].p_offset > file_size || phdr[i].p_filesz > file_size - phdr[i].p_offset) {
+			continue;
+		}
+
+		const uint64_t align = phdr[i].p_align == 8 ? 8 : 4;
+		uint64_t offset      = phdr[i].p_offset;
+		const uint64_t end   = phdr[i].p_offset + phdr[i].p_filesz;
+
+		while (end - offset >= sizeof(elf_nhdr)) {
+			auto note           = reinterpret_cast<const elf_nhdr *>(ptr + offset);
+			const uint64_t name = offset + sizeof(elf_nhdr);
+			const uint64_t desc = name + ((note->n_namesz + align - 1) & ~(align - 1));
+			const uint64_t next = desc + ((note->n_descsz + align - 1) & ~(align - 1));
+
+			if (next > end) {
+				break;
+			}
+
+			if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == sizeof(ELF_NOTE_GNU) && std::memcmp(ptr + name, ELF_NOTE_GNU, sizeof(ELF_NOTE_GNU)) == 0) {
+				return QByteArray(reinterpret_cast<const char *>(ptr + desc), static_cast<int>(note->n_descsz));
+			}
+
+			offset = next;
+		}
+	}
+
+	return QByteArray();
+}
+
+/**
+ * @brief module_key
+ * @param filename
+ * @return something which tells this build of the module apart from any other
+ */
+QByteArray module_key(const QString &filename) {
+
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return QByteArray();
+	}
+
+	QByteArray key;
+	if (const uchar *const ptr = file.map(0, file.size())) {
+		if (file.size() >= EI_NIDENT && std::memcmp(ptr, ELFMAG, SELFMAG) == 0) {
+			switch (ptr[EI_CLASS]) {
+			case ELFCLASS32:
+				key = elf_build_id<elf_model<32>>(ptr, file.size());
+				break;
+			case ELFCLASS64:
+				key = elf_build_id<elf_model<64>>(ptr, file.size());
+				break;
+			}
+		}
+	}
+
+	// not every module has a build-id, and some have one which
+	// is too long for us, hashing the whole thing works for all of them
+	if (key.isEmpty() || key.size() > MaxKeySize) {
+		key = edb::v1::get_file_md5(filename);
+	}
+
+	return key;
+}
+
+// what tells one version of a file apart from the next without reading it
+struct FileIdentity {
+	qint64 size     = 0;
+	qint64 modified = 0;
+	uint64_t inode  = 0;
+
+	bool operator==(const FileIdentity &rhs) const {
+		return size == rhs.size && modified == rhs.modified && inode == rhs.inode;
+	}
+};
+
+/**
+ * @brief file_identity
+ * @param info
+ * @return
+ */
+FileIdentity file_identity(const QFileInfo &info) {
+
+	FileIdentity identity;
+	identity.size     = info.size();
+	identity.modified = info.lastModified().toMSecsSinceEpoch();
+
+#ifdef Q_OS_UNIX
+	// installing a new build usually replaces the file rather than
+	// writing over it, which may keep the size and the time
+	struct stat st;
+	if (::stat(QFile::encodeName(info.absoluteFilePath()).constData(), &st) == 0) {
+		identity.inode = st.st_ino;
+	}
+#endif
+
+	return identity;
+}
+
+/**
+ * @brief cached_module_key
+ * @param info
+ * @return the module_key of the file, only worked out again if the file
+ * changed since the last time
+ */
+QByteArray cached_module_key(const QFileInfo &info) {
+
+	static std::mutex mutex;
+	static QHash<QString, std::pair<FileIdentity, QByteArray>> keys;
+
+	const QString filename      = info.absoluteFilePath();
+	const FileIdentity identity = file_identity(info);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = keys.find(filename);
+		if (it != keys.end() && it->first == identity) {
+			return it->second;
+		}
+	}
+
+	const QByteArray key = module_key(filename);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	keys.insert(filename, std::make_pair(identity, key));
+	return key;
+}
+
+/**
+ * @brief add_block
+ * @param block
+ * @param start the address of the region
+ * @param tables
+ * @return the index of the block in the file
+ */
+uint32_t add_block(const BasicBlock &block, edb::address_t start, Tables *tables) {
+
+	FileBlock entry;
+	entry.recordCount    = static_cast<uint32_t>(block.size());
+	entry.firstReference = static_cast<uint32_t>(tables->references.size());
+
+	// splitting a block leaves smaller ranges of the same
+	// instructions, those can share the records of the whole block
+	bool shared = false;
+	auto it     = tables->recordIndex.find(block.firstAddress());
+	if (it != tables->recordIndex.end() && it.value() + block.size() <= tables->records.size()) {
+		shared = true;
+		for (BasicBlock::size_type i = 0; i < block.size(); ++i) {
+			if (tables->records[it.value() + i].offset != (block.instructionAddress(i) - start).toUint()) {
+				shared = false;
+				break;
+			}
+		}
+	}
+
+	if (shared) {
+		entry.firstRecord = it.value();
+	} else {
+		entry.firstRecord = static_cast<uint32_t>(tables->records.size());
+		for (BasicBlock::size_type i = 0; i < block.size(); ++i) {
+			const InstructionRecord &record = block.record(i);
+			const edb::address_t address    = block.instructionAddress(i);
+
+			FileRecord file_record;
+			file_record.target   = record.target.toUint();
+			file_record.offset   = static_cast<uint32_t>((address - start).toUint());
+			file_record.size     = record.size;
+			file_record.flow     = static_cast<uint8_t>(record.flow);
+			file_record.reserved = 0;
+
+			if (!tables->recordIndex.contains(address)) {
+				tables->recordIndex.insert(address, static_cast<uint32_t>(tables->records.size()));
+			}
+
+			tables->records.push_back(file_record);
+		}
+	}
+
+	for (const auto &reference : block.references()) {
+		tables->references.push_back({reference.first.toUint(), reference.second.toUint()});
+	}
+
+	entry.referenceCount = static_cast<uint32_t>(tables->references.size()) - entry.firstReference;
+
+	tables->blocks.push_back(entry);
+	return static_cast<uint32_t>(tables->blocks.size() - 1);
+}
+
+/**
+ * @brief write_array
+ * @param file
+ * @param items
+ * @param count
+ * @return
+ */
+template <class T>
+bool write_array(QIODevice *file, const T *items, size_t count) {
+	const auto size = static_cast<qint64>(count * sizeof(T));
+	return size == 0 || file->write(reinterpret_cast<const char *>(items), size) == size;
+}
+
+/**
+ * @brief addresses
+ * @param set
+ * @return the addresses in <set> as they are stored in the file
+ */
+std::vector<uint64_t> addresses(const QSet<edb::address_t> &set) {
+	std::vector<uint64_t> results;
+	results.reserve(static_cast<size_t>(set.size()));
+	for (const edb::address_t address : set) {
+		results.push_back(address.toUint());
+	}
+	return results;
+}
+
+}
+
+/**
+ * @brief AnalysisCache::AnalysisCache
+ *
+ * Must be called from the GUI thread, after that the cache may be used from
+ * any one thread.
+ *
+ * @param region
+ */
+AnalysisCache::AnalysisCache(const std::shared_ptr<IRegion> &region)
+	: region_(region), symbolDirectory_(edb::v1::config().symbol_path) {
+}
+
+/**
+ * works out which file belongs to the region, the first time it is needed
+ *
+ * @brief AnalysisCache::resolve
+ * @return false if there is none
+ */
+bool AnalysisCache::resolve() {
+
+	if (resolved_) {
+		return !filename_.isEmpty();
+	}
+
+	resolved_ = true;
+
+	if (!region_ || symbolDirectory_.isEmpty()) {
+		return false;
+	}
+
+	QFileInfo info(region_->name());
+	if (!info.isAbsolute() || !info.isFile() || !info.isReadable()) {
+		return false;
+	}
+
+	key_ = cached_module_key(info);
+	if (key_.isEmpty()) {
+		return false;
+	}
+
+	// on Linux, the base of a region is the offset into the file
+	// it is a mapping of, which tells the mappings of a module apart
+	filename_ = QStringLiteral("%1/%2/%3.%4.analysis").arg(symbolDirectory_, info.absolutePath(), info.fileName(), region_->base().toHexString());
+	return true;
+}
+
+/**
+ * @brief AnalysisCache::load
+ * @param data receives what the file says about the region, moved to where
+ * it is loaded now
+ * @param memory a copy of the whole region, the bytes of the instructions are
+ * taken from there
+ * @param pageSize
+ * @return false if there is no usable file for this build of the module
+ */
+bool AnalysisCache::load(RegionData *data, const QVector<uint8_t> &memory, size_t pageSize) {
+
+	Q_ASSERT(data);
+
+	if (!resolve() || static_cast<size_t>(memory.size()) != region_->size()) {
+		return false;
+	}
+
+	QFile file(filename_);
+	if (!file.open(QIODevice::ReadOnly) || file.size() < static_cast<qint64>(sizeof(FileHeader))) {
+		return false;
+	}
+
+	const uchar *const ptr = file.map(0, file.size());
+	if (!ptr) {
+		return false;
+	}
+
+	auto header = reinterpret_cast<const FileHeader *>(ptr);
+
+	if (std::memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->version != Version) {
+		qDebug() << "[Analyzer] ignoring cache file with an unknown format:" << filename_;
+		return false;
+	}
+
+	if (header->keySize != static_cast<uint32_t>(key_.size()) || std::memcmp(header->key, key_.constData(), header->keySize) != 0) {
+		qDebug() << "[Analyzer] ignoring cache file of a different build:" << filename_;
+		return false;
+	}
+
+	if (header->size != region_->size() || header->pageSize != pageSize || header->pageCount != region_->size() / pageSize || header->regionBlockCount > header->blockCount) {
+		qDebug() << "[Analyzer] ignoring cache file of a different region:" << filename_;
+		return false;
+	}
+
+	const uint64_t expected_size = sizeof(FileHeader) +
+								   uint64_t{header->pageCount} * sizeof(uint64_t) +
+								   uint64_t{header->recordCount} * sizeof(FileRecord) +
+								   uint64_t{header->blockCount} * sizeof(FileBlock) +
+								   uint64_t{header->functionCount} * sizeof(FileFunction) +
+								   uint64_t{header->referenceCount} * sizeof(FileReference) +
+								   (uint64_t{header->knownCount} + header->fuzzyCount) * sizeof(uint64_t);
+
+	if (expected_size != static_cast<uint64_t>(file.size())) {
+		qDebug() << "[Analyzer] ignoring truncated cache file:" << filename_;
+		return false;
+	}
+
+	auto page_hashes = reinterpret_cast<const uint64_t *>(header + 1);
+	auto records     = reinterpret_cast<const FileRecord *>(page_hashes + header->pageCount);
+	auto blocks      = reinterpret_cast<const FileBlock *>(records + header->recordCount);
+	auto functions   = reinterpret_cast<const FileFunction *>(blocks + header->blockCount);
+	auto references  = reinterpret_cast<const FileReference *>(functions + header->functionCount);
+	auto known       = reinterpret_cast<const uint64_t *>(references + header->referenceCount);
+	auto fuzzy       = known + header->knownCount;
+
+	// anything which pointed into the region moves along with it, anything
+	// else is left alone
+	const edb::address_t start = region_->start();
+	auto relocate              = [header, start](uint64_t address) -> edb::address_t {
+		if (address >= header->base && address - header->base < header->size) {
+			return start + (address - header->base);
+		}
+		return address;
+	};
+
+	for (uint32_t i = 0; i < header->recordCount; ++i) {
+		const FileRecord &record = records[i];
+		if (record.size == 0 || record.size > edb::Instruction::MaxSize || record.offset + uint64_t{record.size} > header->size || record.flow > static_cast<uint8_t>(InstructionFlow::Terminator)) {
+			qDebug() << "[Analyzer] ignoring corrupt cache file:" << filename_;
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < header->blockCount; ++i) {
+		const FileBlock &block = blocks[i];
+		if (block.recordCount == 0 || uint64_t{block.firstRecord} + block.recordCount > header->recordCount || uint64_t{block.firstReference} + block.referenceCount > header->referenceCount) {
+			qDebug() << "[Analyzer] ignoring corrupt cache file:" << filename_;
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < header->functionCount; ++i) {
+		const FileFunction &function = functions[i];
+		if (function.blockCount == 0 || uint64_t{function.firstBlock} + function.blockCount > header->blockCount || function.type > Function::Thunk) {
+			qDebug() << "[Analyzer] ignoring corrupt cache file:" << filename_;
+			return false;
+		}
+	}
+
+	std::vector<InstructionRecord> instructions(header->recordCount);
+	for (uint32_t i = 0; i < header->recordCount; ++i) {
+		instructions[i].offset = records[i].offset;
+		instructions[i].size   = records[i].size;
+		instructions[i].flow   = static_cast<InstructionFlow>(records[i].flow);
+		instructions[i].target = records[i].target ? relocate(records[i].target) : edb::address_t(0);
+	}
+
+	auto arena = std::make_shared<InstructionArena>(start);
+	arena->append(instructions, memory.data());
+
+	auto make_block = [&](const FileBlock &entry) {
+		BasicBlock block(arena, entry.firstRecord, entry.recordCount);
+		for (uint32_t i = 0; i < entry.referenceCount; ++i) {
+			const FileReference &reference = references[entry.firstReference + i];
+			block.addReference(relocate(reference.site), relocate(reference.target));
+		}
+		return block;
+	};
+
+	RegionData results;
+	results.region       = region_;
+	results.fuzzy        = (header->flags & FlagFuzzy) != 0;
+	results.instructions = arena;
+
+	results.pageHashes.reserve(static_cast<int>(header->pageCount));
+	for (uint32_t i = 0; i < header->pageCount; ++i) {
+		results.pageHashes.push_back(page_hashes[i]);
+	}
+
+	for (uint32_t i = 0; i < header->regionBlockCount; ++i) {
+		BasicBlock block = make_block(blocks[i]);
+		results.basicBlocks.insert(block.firstAddress(), block);
+	}
+
+	for (uint32_t i = 0; i < header->functionCount; ++i) {
+		const FileFunction &entry = functions[i];
+
+		Function function;
+		for (uint32_t j = 0; j < entry.blockCount; ++j) {
+			function.insert(make_block(blocks[entry.firstBlock + j]));
+		}
+
+		for (int32_t j = 0; j < entry.referenceCount; ++j) {
+			function.addReference();
+		}
+
+		function.setType(static_cast<Function::Type>(entry.type));
+		results.functions.insert(relocate(entry.entry), function);
+	}
+
+	for (uint32_t i = 0; i < header->knownCount; ++i) {
+		results.knownFunctions.insert(relocate(known[i]));
+	}
+
+	for (uint32_t i = 0; i < header->fuzzyCount; ++i) {
+		results.fuzzyFunctions.insert(relocate(fuzzy[i]));
+	}
+
+	*data = std::move(results);
+
+	qDebug("[Analyzer] loaded %d functions from the cache", static_cast<int>(data->functions.size()));
+	return true;
+}
+
+/**
+ * writes <data> to the cache file, this is safe to call from any thread
+ *
+ * @brief AnalysisCache::save
+ * @param data
+ * @param pageSize
+ * @param cancelled when this becomes true, the old file is left as it is
+ * @return
+ */
+bool AnalysisCache::save(const RegionData &data, size_t pageSize, const std::atomic<bool> &cancelled) {
+
+	if (!resolve()) {
+		return false;
+	}
+
+	const edb::address_t start = region_->start();
+
+	Tables tables;
+	for (auto it = data.basicBlocks.begin(); it != data.basicBlocks.end(); ++it) {
+		add_block(it.value(), start, &tables);
+	}
+
+	const auto region_blocks = static_cast<uint32_t>(tables.blocks.size());
+
+	for (auto it = data.functions.begin(); it != data.functions.end(); ++it) {
+		if (cancelled) {
+			return false;
+		}
+
+		const Function &function = it.value();
+
+		FileFunction entry;
+		entry.entry          = it.key().toUint();
+		entry.firstBlock     = static_cast<uint32_t>(tables.blocks.size());
+		entry.blockCount     = static_cast<uint32_t>(function.size());
+		entry.referenceCount = function.referenceCount();
+		entry.type           = static_cast<uint32_t>(function.type());
+
+		for (const auto &block : function) {
+			add_block(block.second, start, &tables);
+		}
+
+		tables.functions.push_back(entry);
+	}
+
+	const std::vector<uint64_t> known = addresses(data.knownFunctions);
+	const std::vector<uint64_t> fuzzy = addresses(data.fuzzyFunctions);
+
+	FileHeader header = {};
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	std::memcpy(header.key, key_.constData(), static_cast<size_t>(key_.size()));
+	header.version          = Version;
+	header.flags            = data.fuzzy ? FlagFuzzy : 0;
+	header.base             = start.toUint();
+	header.size             = region_->size();
+	header.pageSize         = pageSize;
+	header.keySize          = static_cast<uint32_t>(key_.size());
+	header.pageCount        = static_cast<uint32_t>(data.pageHashes.size());
+	header.recordCount      = static_cast<uint32_t>(tables.records.size());
+	header.blockCount       = static_cast<uint32_t>(tables.blocks.size());
+	header.regionBlockCount = region_blocks;
+	header.functionCount    = static_cast<uint32_t>(tables.functions.size());
+	header.referenceCount   = static_cast<uint32_t>(tables.references.size());
+	header.knownCount       = static_cast<uint32_t>(known.size());
+	header.fuzzyCount       = static_cast<uint32_t>(fuzzy.size());
+
+	QDir().mkpath(QFileInfo(filename_).absolutePath());
+
+	// QSaveFile only replaces the old file once all of the new one
+	// made it to disk, so a crash never leaves half of a file behind
+	QSaveFile file(filename_);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qDebug() << "[Analyzer] unable to write cache file:" << filename_;
+		return false;
+	}
+
+	const bool ok = write_array(&file, &header, 1) &&
+					write_array(&file, data.pageHashes.constData(), static_cast<size_t>(data.pageHashes.size())) &&
+					write_array(&file, tables.records.data(), tables.records.size()) &&
+					write_array(&file, tables.blocks.data(), tables.blocks.size()) &&
+					write_array(&file, tables.functions.data(), tables.functions.size()) &&
+					write_array(&file, tables.references.data(), tables.references.size()) &&
+					write_array(&file, known.data(), known.size()) &&
+					write_array(&file, fuzzy.data(), fuzzy.size());
+
+	// a QSaveFile which isn't committed throws away what was
+	// written to it
+	if (cancelled) {
+		return false;
+	}
+
+	if (!ok || !file.commit()) {
+		qDebug() << "[Analyzer] unable to write cache file:" << filename_;
+		return false;
+	}
+
+	return true;
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANALYSIS_CACHE_H_20240301_
+#define ANALYSIS_CACHE_H_20240301_
+
+#include "IRegion.h"
+#include "RegionData.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+namespace AnalyzerPlugin {
+
+// Keeps the results of the analysis of a region in a file next to the symbol
+// files of its module, so a later session can pick them up instead of
+// starting over.
+//
+// A file belongs to one mapping of one build of a module: it is named after
+// the file offset of the mapping and holds the GNU build-id of the module (or
+// the MD5 of it when it has none). The address the region was loaded at is
+// recorded too, so the results can be moved to wherever it is loaded next.
+//
+// The file is a header followed by arrays of fixed size records, which are
+// read straight out of a mapping of it. Nothing in there is trusted beyond
+// where it came from though, the caller still has to compare the page hashes
+// with the pages of the region.
+//
+// Working out the name of the file takes a look at the module, which waits for
+// the first load() or save() so it happens on whichever thread does the
+// analysis. The key of a module is remembered until the module file changes.
+class AnalysisCache {
+public:
+	AnalysisCache() = default;
+	explicit AnalysisCache(const std::shared_ptr<IRegion> &region);
+
+public:
+	[[nodiscard]] bool load(RegionData *data, const QVector<uint8_t> &memory, size_t pageSize);
+	bool save(const RegionData &data, size_t pageSize, const std::atomic<bool> &cancelled);
+
+private:
+	bool resolve();
+
+private:
+	std::shared_ptr<IRegion> region_;
+	QString symbolDirectory_;
+	bool resolved_ = false;
+	QString filename_;
+	QByteArray key_;
+};
+
+}
+
+#endif
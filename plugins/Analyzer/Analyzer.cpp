@@ -21,6 +21,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Configuration.h"
 #include "DialogXRefs.h"
 #include "Function.h"
+#include "FunctionCollector.h"
+#include "FuzzyScanner.h"
 #include "IBinary.h"
 #include "IDebugger.h"
 #include "IProcess.h"
@@ -45,38 +47,79 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMessageBox>
 #include <QProgressDialog>
 #include <QSettings>
-#include <QStack>
 #include <QToolBar>
 #include <QtDebug>
 
+#include <algorithm>
 #include <cstring>
 #include <functional>
+#include <iterator>
+#include <utility>
 
 namespace AnalyzerPlugin {
 
 namespace {
 
 constexpr int MinRefCount = 2;
+
+// (target, source)
+using Reference = std::pair<edb::address_t, edb::address_t>;
+
 /**
- * @brief will_return
- * @param address
- * @return
+ * @brief non_returning_functions
+ * @param symbols
+ * @param cancelled
+ * @return the addresses of all of <symbols> whose prototype says they don't
+ * return
  */
-bool will_return(edb::address_t address) {
+QSet<edb::address_t> non_returning_functions(const std::vector<std::shared_ptr<Symbol>> &symbols, const std::atomic<bool> &cancelled) {
+
+	QSet<edb::address_t> results;
+
+	for (const std::shared_ptr<Symbol> &symbol : symbols) {
+		if (cancelled) {
+			break;
+		}
 
-	const std::shared_ptr<Symbol> symbol = edb::v1::symbol_manager().find(address);
-	if (symbol) {
 		const QString symname   = symbol->name_no_prefix;
 		const QString func_name = symname.mid(0, symname.indexOf("@"));
 
 		if (const edb::Prototype *const info = edb::v1::get_function_info(func_name)) {
 			if (info->noreturn) {
-				return false;
+				results.insert(symbol->address);
 			}
 		}
 	}
 
-	return true;
+	return results;
+}
+
+/**
+ * @brief page_hashes
+ * @param memory
+ * @param page_size
+ * @return a hash of every page of <memory>
+ */
+QVector<uint64_t> page_hashes(const QVector<uint8_t> &memory, size_t page_size) {
+
+	QVector<uint64_t> hashes;
+	hashes.reserve(static_cast<int>(memory.size() / page_size));
+
+	for (size_t offset = 0; offset + page_size <= static_cast<size_t>(memory.size()); offset += page_size) {
+
+		// FNV-1a over 64-bit words. Every step of it can be undone,
+		// so a page which differs in a single word always hashes differently
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (size_t i = 0; i < page_size; i += sizeof(uint64_t)) {
+			uint64_t word;
+			std::memcpy(&word, memory.data() + offset + i, sizeof(word));
+			hash = (hash ^ word) * 0x100000001b3ull;
+		}
+
+		hashes.push_back(hash);
+	}
+
+	return hashes;
 }
 
 /**
@@ -94,30 +137,31 @@ bool is_entrypoint(const Symbol &sym) {
 
 /**
  * @brief is_thunk
- * @param address
+ * @param function
  * @return true if the first instruction of the function is a jmp
  */
-bool is_thunk(edb::address_t address) {
-
-	uint8_t buf[edb::Instruction::MaxSize];
-	if (const int buf_size = edb::v1::get_instruction_bytes(address, buf)) {
-		const edb::Instruction inst(buf, buf + buf_size, address);
-		return is_unconditional_jump(inst);
-	}
-
-	return false;
+bool is_thunk(const Function &function) {
+	const BasicBlock &entry = function.front();
+	return entry.record(0).flow == InstructionFlow::Jump;
 }
 
 /**
  * @brief set_function_types
  * @param results
+ * @param functions the entry points of the functions in <results> to look at
+ * @param cancelled
  */
-void set_function_types(IAnalyzer::FunctionMap *results) {
+void set_function_types(IAnalyzer::FunctionMap *results, const QList<edb::address_t> &functions, const std::atomic<bool> &cancelled) {
 
 	Q_ASSERT(results);
 
 	// give bonus if we have a symbol for the address
-	for (auto it = results->begin(); it != results->end(); ++it) {
+	for (auto entry = functions.begin(); entry != functions.end() && !cancelled; ++entry) {
+
+		auto it = results->find(*entry);
+		if (it == results->end()) {
+			continue;
+		}
 
 		Function &function = it.value();
 
@@ -126,7 +170,7 @@ void set_function_types(IAnalyzer::FunctionMap *results) {
 		}
 
 		Q_ASSERT(!function.empty());
-		if (is_thunk(function.entryAddress())) {
+		if (is_thunk(function)) {
 			function.setType(Function::Thunk);
 		} else {
 			function.setType(Function::Standard);
@@ -134,6 +178,105 @@ void set_function_types(IAnalyzer::FunctionMap *results) {
 	}
 }
 
+/**
+ * @brief index_references
+ * @param data
+ * @param cancelled
+ */
+void index_references(RegionData *data, const std::atomic<bool> &cancelled) {
+
+	Q_ASSERT(data);
+
+	data->references.clear();
+
+	for (const BasicBlock &bb : data->basicBlocks) {
+		if (cancelled) {
+			return;
+		}
+
+		for (const std::pair<edb::address_t, edb::address_t> &ref : bb.references()) {
+			data->references.push_back({ref.second, ref.first});
+		}
+	}
+
+	std::sort(data->references.begin(), data->references.end());
+	data->references.squeeze();
+}
+
+/**
+ * @brief set_reference_counts
+ * @param functions
+ * @param references
+ * @param cancelled
+ */
+void set_reference_counts(IAnalyzer::FunctionMap *functions, const QVector<Reference> &references, const std::atomic<bool> &cancelled) {
+
+	Q_ASSERT(functions);
+
+	for (auto it = functions->begin(); it != functions->end() && !cancelled; ++it) {
+
+		// an instruction which is in more than one block is still
+		// only one reference
+		auto first = std::lower_bound(references.begin(), references.end(), std::make_pair(it.key(), edb::address_t(0)));
+
+		int count = 0;
+		for (auto ref = first; ref != references.end() && ref->first == it.key(); ++ref) {
+			if (ref == first || ref->second != std::prev(ref)->second) {
+				++count;
+			}
+		}
+
+		it->setReferenceCount(count);
+	}
+}
+
+/**
+ * @brief move_block
+ * @param block
+ * @param memory a copy of the region
+ * @param arena
+ * @param moved where the record of every instruction which was moved so far
+ * went, by its address
+ * @return <block>, with its records in <arena>
+ */
+BasicBlock move_block(const BasicBlock &block, const QVector<uint8_t> &memory, const std::shared_ptr<InstructionArena> &arena, QHash<edb::address_t, size_t> *moved) {
+
+	Q_ASSERT(moved);
+
+	// the blocks of a function may be pieces of the blocks of the
+	// region, those can share the records which were moved for the whole block
+	auto it     = moved->find(block.firstAddress());
+	bool shared = it != moved->end() && it.value() + block.size() <= arena->size();
+	for (BasicBlock::size_type i = 0; shared && i < block.size(); ++i) {
+		shared = (*arena)[it.value() + i].offset == block.record(i).offset;
+	}
+
+	size_t first;
+	if (shared) {
+		first = it.value();
+	} else {
+		std::vector<InstructionRecord> records;
+		records.reserve(block.size());
+		for (BasicBlock::size_type i = 0; i < block.size(); ++i) {
+			records.push_back(block.record(i));
+		}
+
+		first = arena->append(records, memory.data());
+		for (BasicBlock::size_type i = 0; i < block.size(); ++i) {
+			if (!moved->contains(block.instructionAddress(i))) {
+				moved->insert(block.instructionAddress(i), first + i);
+			}
+		}
+	}
+
+	BasicBlock result(arena, first, block.size());
+	for (const auto &reference : block.references()) {
+		result.addReference(reference.first, reference.second);
+	}
+
+	return result;
+}
+
 /**
  * @brief module_entry_point
  * @param region
@@ -142,7 +285,7 @@ void set_function_types(IAnalyzer::FunctionMap *results) {
 edb::address_t module_entry_point(const std::shared_ptr<IRegion> &region) {
 	// NOTE(eteran): because modern ELF files actually have the ELF header in its
 	// own, non-executable section that precedes the main one, so this may fail...
-	if (std::unique_ptr<IBinary> binary_info = edb::v1::get_binary_info(region)) {
+	if (std::shared_ptr<IBinary> binary_info = edb::v1::cached_binary_info(region)) {
 		return binary_info->entryPoint();
 	}
 
@@ -151,7 +294,7 @@ edb::address_t module_entry_point(const std::shared_ptr<IRegion> &region) {
 	const size_t page_size          = edb::v1::debugger_core->pageSize();
 	const edb::address_t prevRegion = region->start() - page_size;
 	if (std::shared_ptr<IRegion> region = edb::v1::memory_regions().findRegion(prevRegion)) {
-		if (std::unique_ptr<IBinary> binary_info = edb::v1::get_binary_info(region)) {
+		if (std::shared_ptr<IBinary> binary_info = edb::v1::cached_binary_info(region)) {
 			return binary_info->entryPoint();
 		}
 	}
@@ -169,6 +312,13 @@ Analyzer::Analyzer(QObject *parent)
 	: QObject(parent) {
 }
 
+/**
+ * @brief Analyzer::~Analyzer
+ */
+Analyzer::~Analyzer() {
+	cancelAnalysis();
+}
+
 /**
  * @brief Analyzer::optionsPage
  * @return
@@ -224,6 +374,13 @@ QMenu *Analyzer::menu(QWidget *parent) {
  */
 void Analyzer::privateInit() {
 	edb::v1::set_analyzer(this);
+
+	// emitted from the worker thread, so this is a queued connection
+	connect(this, &Analyzer::analysisFinished, this, &Analyzer::finishAnalysis);
+
+	// once the debuggee runs, the memory we are looking at is stale anyway
+	connect(edb::v1::debugger_ui, SIGNAL(resumeEvent()), this, SLOT(cancelAnalysis()));
+	connect(edb::v1::debugger_ui, SIGNAL(detachEvent()), this, SLOT(cancelAnalysis()));
 }
 
 /**
@@ -280,16 +437,8 @@ void Analyzer::showXrefs() {
 
 	auto dialog = new DialogXRefs(edb::v1::debugger_ui);
 
-	for (const RegionData &data : analysisInfo_) {
-		for (const BasicBlock &bb : data.basicBlocks) {
-			const std::vector<std::pair<edb::address_t, edb::address_t>> refs = bb.references();
-
-			for (auto it = refs.begin(); it != refs.end(); ++it) {
-				if (it->second == address) {
-					dialog->addReference(*it);
-				}
-			}
-		}
+	for (const edb::address_t source : referencesTo(address)) {
+		dialog->addReference({source, address});
 	}
 
 	dialog->setWindowTitle(tr("X-Refs For %1").arg(address.toPointerString()));
@@ -363,12 +512,75 @@ QList<QAction *> Analyzer::cpuContextMenu() {
  */
 void Analyzer::doAnalysis(const std::shared_ptr<IRegion> &region) {
 	if (region && region->size() != 0) {
-		QProgressDialog progress(tr("Performing Analysis"), nullptr, 0, 100, edb::v1::debugger_ui);
-		connect(this, &Analyzer::updateProgress, &progress, &QProgressDialog::setValue);
-		progress.show();
-		progress.setValue(0);
-		analyze(region);
-		edb::v1::repaint_cpu_view();
+
+		// only one analysis runs in the background at a time
+		cancelAnalysis();
+
+		std::unique_ptr<AnalysisJob> job = prepareAnalysis(region);
+
+		progress_ = new QProgressDialog(tr("Performing Analysis"), tr("Cancel"), 0, 100, edb::v1::debugger_ui);
+		connect(this, &Analyzer::updateProgress, progress_, &QProgressDialog::setValue);
+		connect(progress_, &QProgressDialog::canceled, this, &Analyzer::cancelAnalysis);
+		progress_->show();
+		progress_->setValue(0);
+
+		job_ = std::move(job);
+
+		AnalysisJob *const running = job_.get();
+		running->thread = std::thread([this, running]() {
+			runAnalysis(running);
+			running->finished = true;
+			Q_EMIT analysisFinished();
+		});
+	}
+}
+
+/**
+ * @brief Analyzer::finishAnalysis
+ */
+void Analyzer::finishAnalysis() {
+
+	// this may be the notification of a job which was cancelled
+	// in the meantime, whatever is in job_ now will send its own
+	if (!job_ || !job_->finished) {
+		return;
+	}
+
+	job_->thread.join();
+	std::unique_ptr<AnalysisJob> job = std::move(job_);
+
+	if (progress_) {
+		progress_->deleteLater();
+		progress_ = nullptr;
+	}
+
+	// the region may have been unmapped or resized while we were busy
+	const std::shared_ptr<IRegion> &analyzed = job->data.region;
+	const std::shared_ptr<IRegion> region    = edb::v1::memory_regions().findRegion(analyzed->start());
+	if (!region || region->start() != analyzed->start() || region->end() != analyzed->end()) {
+		qDebug("[Analyzer] region changed during analysis, discarding the results");
+		return;
+	}
+
+	publishAnalysis(std::move(job));
+	edb::v1::repaint_cpu_view();
+}
+
+/**
+ * @brief Analyzer::cancelAnalysis
+ */
+void Analyzer::cancelAnalysis() {
+
+	if (job_) {
+		job_->cancelled = true;
+		job_->thread.join();
+		job_ = nullptr;
+		qDebug("[Analyzer] analysis cancelled");
+	}
+
+	if (progress_) {
+		progress_->deleteLater();
+		progress_ = nullptr;
 	}
 }
 
@@ -435,7 +647,7 @@ void Analyzer::bonusMarkedFunctions(RegionData *data) {
  * @brief Analyzer::identHeader
  * @param data
  */
-void Analyzer::identHeader(Analyzer::RegionData *data) {
+void Analyzer::identHeader(RegionData *data) {
 	Q_UNUSED(data)
 }
 
@@ -448,14 +660,13 @@ bool split_function(Function &func) {
 			continue;
 		}
 
-		for (auto it = bb.begin(); it != bb.end(); ++it) {
-			const std::shared_ptr<edb::Instruction> &insn = *it;
+		for (BasicBlock::size_type i = 0; i + 1 < bb.size(); ++i) {
 
 			// if it's a call and not the last instruction of the BB
 			// then split!
-			if (is_call(*insn) && insn != bb.back()) {
+			if (bb.record(i).flow == InstructionFlow::Call) {
 
-				auto newBlocks = bb.splitBlock(insn);
+				auto newBlocks = bb.splitBlock(i);
 				func.erase(bb_it);
 
 				Q_ASSERT(!newBlocks.first.empty());
@@ -472,12 +683,23 @@ bool split_function(Function &func) {
 	return false;
 }
 
-void Analyzer::splitBlocks(RegionData *data) {
-	Q_ASSERT(data);
+/**
+ * @brief Analyzer::splitBlocks
+ * @param job
+ */
+void Analyzer::splitBlocks(AnalysisJob *job) {
+	Q_ASSERT(job);
 
-	for (auto it = data->functions.begin(); it != data->functions.end(); ++it) {
-		const edb::address_t function = it.key();
-		Function &func                = it.value();
+	RegionData *const data = &job->data;
+
+	// the functions which were kept have been split already
+	for (auto entry = job->collectedFunctions.begin(); entry != job->collectedFunctions.end() && !job->cancelled; ++entry) {
+		auto it = data->functions.find(*entry);
+		if (it == data->functions.end()) {
+			continue;
+		}
+
+		Function &func = it.value();
 
 		while (split_function(func)) {
 			continue;
@@ -485,220 +707,224 @@ void Analyzer::splitBlocks(RegionData *data) {
 	}
 }
 
-void Analyzer::computeNonReturning(Analyzer::RegionData *data) {
+void Analyzer::computeNonReturning(RegionData *data) {
 	Q_UNUSED(data);
 }
 
 /**
  * @brief Analyzer::collectFunctions
- * @param data
+ * @param job
  */
-void Analyzer::collectFunctions(Analyzer::RegionData *data) {
-	Q_ASSERT(data);
+void Analyzer::collectFunctions(AnalysisJob *job) {
+	Q_ASSERT(job);
 
-	// results
-	QHash<edb::address_t, BasicBlock> basic_blocks;
-	FunctionMap functions;
+	RegionData *const data = &job->data;
 
-	// push all known functions onto a stack
-	QStack<edb::address_t> known_functions;
+	// start with all known functions, and the fuzzy ones too...
+	QList<edb::address_t> entry_points;
 	Q_FOREACH (const edb::address_t function, data->knownFunctions) {
-		known_functions.push(function);
+		entry_points.push_back(function);
 	}
 
-	// push all fuzzy function too...
 	Q_FOREACH (const edb::address_t function, data->fuzzyFunctions) {
-		known_functions.push(function);
+		entry_points.push_back(function);
 	}
 
-	// process all functions that are known
-	while (!known_functions.empty()) {
-		const edb::address_t function_address = known_functions.pop();
+	// ... and whatever was thrown away because it changed
+	entry_points.append(job->changedFunctions);
 
-		if (!functions.contains(function_address)) {
+	FunctionCollector collector(data->region, job->memory, job->arena, job->nonReturning, job->cancelled);
 
-			QStack<edb::address_t> blocks;
-			blocks.push(function_address);
-
-			Function func;
+	// the functions we kept don't need another look
+	QSet<edb::address_t> kept_functions;
+	for (auto it = data->functions.begin(); it != data->functions.end(); ++it) {
+		kept_functions.insert(it.key());
+	}
 
-			// process are basic blocks that are known
-			while (!blocks.empty()) {
+	QSet<edb::address_t> kept_blocks;
+	for (auto it = data->basicBlocks.begin(); it != data->basicBlocks.end(); ++it) {
+		kept_blocks.insert(it.key());
+	}
 
-				const edb::address_t block_address = blocks.pop();
-				edb::address_t address             = block_address;
-				BasicBlock block;
+	collector.skip(kept_functions, kept_blocks);
+	collector.run(entry_points, std::thread::hardware_concurrency());
 
-				if (!basic_blocks.contains(block_address)) {
-					while (data->region->contains(address)) {
+	const QHash<edb::address_t, BasicBlock> &blocks = collector.basicBlocks();
+	for (auto it = blocks.begin(); it != blocks.end(); ++it) {
+		data->basicBlocks.insert(it.key(), it.value());
+		job->collectedBlocks.push_back(it.key());
+	}
 
-						uint8_t buffer[edb::Instruction::MaxSize];
-						const int buf_size = edb::v1::get_instruction_bytes(address, buffer);
-						if (buf_size == 0) {
-							break;
-						}
+	const FunctionMap &functions = collector.functions();
+	for (auto it = functions.begin(); it != functions.end(); ++it) {
+		data->functions.insert(it.key(), it.value());
+		job->collectedFunctions.push_back(it.key());
+	}
 
-						auto inst = std::make_shared<edb::Instruction>(buffer, buffer + buf_size, address);
-						if (!inst->valid()) {
-							break;
-						}
+	data->instructions = job->arena;
 
-						block.push_back(inst);
+	// every instruction used to be kept as an edb::Instruction,
+	// so this is what the records save
+	qDebug("[Analyzer] %zu instructions in %zu bytes, %zu bytes as edb::Instruction objects",
+		   data->instructions->size(),
+		   data->instructions->memoryUsage(),
+		   data->instructions->size() * sizeof(edb::Instruction));
+}
 
-						if (is_call(*inst)) {
+/**
+ * @brief Analyzer::keepUnchangedFunctions
+ *
+ * Carries over the functions of the previous analysis which don't overlap any
+ * page that changed since, along with their blocks. The ones which do are
+ * noted so that collectFunctions walks them again.
+ *
+ * The records of the blocks which are kept are copied into the arena of the
+ * job, so nothing refers to the previous one anymore. The references of the
+ * blocks which aren't are noted, so the index of the previous references can
+ * be brought up to date without going through every block again.
+ *
+ * @param job
+ */
+void Analyzer::keepUnchangedFunctions(AnalysisJob *job) {
+	Q_ASSERT(job);
 
-							// note the destination and move on
-							// we special case some simple things.
-							// also this is an opportunity to find call tables.
-							const edb::Operand op = inst->operand(0);
-							if (is_immediate(op)) {
-								const edb::address_t ea = op->imm;
+	RegionData *const data     = &job->data;
+	const RegionData &previous = job->previous;
 
-								// skip over ones which are: "call <label>; label:"
-								if (ea != address + inst->byteSize()) {
-									known_functions.push(ea);
+	data->functions.clear();
+	data->basicBlocks.clear();
+	job->changedFunctions.clear();
+	job->changedRanges.clear();
+	job->removedReferences.clear();
+	job->incremental = false;
+	job->arena       = std::make_shared<InstructionArena>(data->region->start());
 
-									if (!will_return(ea)) {
-										break;
-									}
+	if (previous.functions.isEmpty() || previous.fuzzy != data->fuzzy || previous.pageHashes.size() != data->pageHashes.size()) {
+		return;
+	}
 
-									block.addReference(address, ea);
-								}
-							} else if (is_expression(op)) {
-								// looks like: "call [...]", if it is of the form, call [C + REG]
-								// then it may be a jump table using REG as an offset
-							} else if (is_register(op)) {
-								// looks like: "call <reg>", this is this may be a callback
-								// if we can use analysis to determine that it's a constant
-								// we can figure it out...
-								// eventually, we should figure out the parameters of the function
-								// to see if we can know what the target is
-							}
+	job->incremental = true;
 
-						} else if (is_unconditional_jump(*inst)) {
+	QVector<bool> changed(data->pageHashes.size());
+	int changed_pages = 0;
+	for (int i = 0; i < data->pageHashes.size(); ++i) {
+		changed[i] = previous.pageHashes[i] != data->pageHashes[i];
+		changed_pages += changed[i];
 
-							Q_ASSERT(inst->operandCount() >= 1);
-							const edb::Operand op = inst->operand(0);
+		if (changed[i]) {
+			const size_t offset = static_cast<size_t>(i) * job->pageSize;
+			if (!job->changedRanges.empty() && job->changedRanges.back().second == offset) {
+				job->changedRanges.back().second += job->pageSize;
+			} else {
+				job->changedRanges.emplace_back(offset, offset + job->pageSize);
+			}
+		}
+	}
 
-							// TODO(eteran): we need some heuristic for detecting when this is
-							//               a call/ret -> jmp optimization
-							if (is_immediate(op)) {
-								const edb::address_t ea = op->imm;
+	const edb::address_t start = data->region->start();
 
-								if (functions.contains(ea)) {
-									functions[ea].addReference();
-								} else if ((ea - function_address) > 0x2000u) {
-									known_functions.push(ea);
-								} else {
-									blocks.push(ea);
-								}
+	auto is_changed = [&](const BasicBlock &bb) {
+		const size_t first = (bb.firstAddress() - start).toUint() / job->pageSize;
+		const size_t last  = (bb.lastAddress() - 1 - start).toUint() / job->pageSize;
+		for (size_t page = first; page <= last; ++page) {
+			if (page >= static_cast<size_t>(changed.size()) || changed[static_cast<int>(page)]) {
+				return true;
+			}
+		}
+		return false;
+	};
 
-								block.addReference(address, ea);
-							}
-							break;
-						} else if (is_conditional_jump(*inst)) {
+	QHash<edb::address_t, size_t> moved;
 
-							Q_ASSERT(inst->operandCount() == 1);
-							const edb::Operand op = inst->operand(0);
+	for (auto it = previous.functions.begin(); it != previous.functions.end(); ++it) {
+		const Function &func = it.value();
 
-							if (is_immediate(op)) {
+		const bool function_changed = std::any_of(func.begin(), func.end(), [&](const std::pair<const edb::address_t, BasicBlock> &entry) {
+			return is_changed(entry.second);
+		});
 
-								const edb::address_t ea = op->imm;
+		if (function_changed) {
+			job->changedFunctions.push_back(it.key());
+			continue;
+		}
 
-								blocks.push(ea);
-								blocks.push(address + inst->byteSize());
+		// only blocks which belong to a function we keep are kept,
+		// the walk of the others may need to pass through them again
+		for (const auto &entry : func) {
+			auto block = previous.basicBlocks.find(entry.first);
+			if (block != previous.basicBlocks.end()) {
+				data->basicBlocks.insert(block.key(), move_block(block.value(), job->memory, job->arena, &moved));
+			}
+		}
 
-								block.addReference(address, ea);
-							}
-							break;
-						} else if (is_terminator(*inst)) {
-							break;
-						}
+		Function kept;
+		for (const auto &entry : func) {
+			kept.insert(move_block(entry.second, job->memory, job->arena, &moved));
+		}
 
-						address += inst->byteSize();
-					}
-
-					if (!block.empty()) {
-						basic_blocks.insert(block_address, block);
-
-						if (block_address >= function_address) {
-							func.insert(block);
-						}
-					}
-				}
-			}
+		// the reference count is worked out again once everything
+		// is collected, others may call it from where something changed
+		kept.setType(func.type());
+		data->functions.insert(it.key(), kept);
+	}
 
-			if (!func.empty()) {
-				functions.insert(function_address, func);
+	for (auto it = previous.basicBlocks.begin(); it != previous.basicBlocks.end(); ++it) {
+		if (!data->basicBlocks.contains(it.key())) {
+			for (const std::pair<edb::address_t, edb::address_t> &ref : it->references()) {
+				job->removedReferences.emplace_back(ref.second, ref.first);
 			}
-		} else {
-			functions[function_address].addReference();
 		}
 	}
 
-	std::swap(data->basicBlocks, basic_blocks);
-	std::swap(data->functions, functions);
+	qDebug("[Analyzer] %d of %d pages changed, keeping %d of %d functions",
+		   changed_pages,
+		   static_cast<int>(changed.size()),
+		   static_cast<int>(data->functions.size()),
+		   static_cast<int>(previous.functions.size()));
 }
 
 /**
  * @brief Analyzer::collectFuzzyFunctions
  * @param data
  */
-void Analyzer::collectFuzzyFunctions(RegionData *data) {
-	Q_ASSERT(data);
+void Analyzer::collectFuzzyFunctions(AnalysisJob *job) {
+	Q_ASSERT(job);
+
+	RegionData *const data = &job->data;
 
 	data->fuzzyFunctions.clear();
+	data->fuzzyScan = nullptr;
 
 	if (data->fuzzy) {
 
-		QHash<edb::address_t, int> fuzzy_functions;
-
-		uint8_t *const first = (data->memory).data();
-		uint8_t *const last  = &first[data->memory.size()];
-
-		uint8_t *p = first;
-
-		// fuzzy_functions, known_functions
-		for (edb::address_t addr = data->region->start(); addr != data->region->end(); ++addr) {
-			if (auto inst = edb::Instruction(p, last, addr)) {
-				if (is_call(inst)) {
-
-					// note the destination and move on
-					// we special case some simple things.
-					// also this is an opportunity to find call tables.
-					const edb::Operand op = inst[0];
-					if (is_immediate(op)) {
-						const edb::address_t ea = op->imm;
-
-						// skip over ones which are: "call <label>; label:"
-						if (ea != addr + inst.byteSize()) {
-
-							if (!data->knownFunctions.contains(ea)) {
-								fuzzy_functions[ea]++;
-							}
-						}
-					}
-#if defined(EDB_X86) || defined(EDB_X86_64)
-#if CS_API_MAJOR >= 4
-				} else if (inst->id == X86_INS_ENDBR64 || inst->id == X86_INS_ENDBR32) {
-
-					// Intel's CET stuff actually helps us identify functions pretty easily
-					if (!data->knownFunctions.contains(addr)) {
-						fuzzy_functions[addr] = MinRefCount + 1;
-					}
-#endif
-#endif
-				}
-			}
-			++p;
+		FuzzyScanner scanner(data->region->start(), job->memory, job->cancelled);
+
+		// the scan of an analysis from the cache isn't kept, and
+		// the page hashes only say what changed since the previous analysis
+		// of this session
+		const RegionData &previous = job->previous;
+		if (job->incremental && job->previousFromSession && previous.fuzzyScan) {
+			scanner.update(*previous.fuzzyScan, job->changedRanges, std::thread::hardware_concurrency());
+		} else {
+			scanner.run(std::thread::hardware_concurrency());
 		}
 
+		data->fuzzyScan = std::make_shared<const FuzzyScanResults>(scanner.results());
+
 		// transfer results to data->fuzzy_functions
-		for (auto it = fuzzy_functions.begin(); it != fuzzy_functions.end(); ++it) {
-			if (it.value() > MinRefCount) {
+		const QHash<edb::address_t, int> &call_targets = scanner.callTargets();
+		for (auto it = call_targets.begin(); it != call_targets.end(); ++it) {
+			if (it.value() > MinRefCount && !data->knownFunctions.contains(it.key())) {
 				data->fuzzyFunctions.insert(it.key());
 			}
 		}
+
+		// Intel's CET stuff actually helps us identify functions pretty easily
+		Q_FOREACH (const edb::address_t address, scanner.landingPads()) {
+			if (!data->knownFunctions.contains(address)) {
+				data->fuzzyFunctions.insert(address);
+			}
+		}
 	}
 }
 
@@ -708,10 +934,27 @@ void Analyzer::collectFuzzyFunctions(RegionData *data) {
  */
 void Analyzer::analyze(const std::shared_ptr<IRegion> &region) {
 
-	QElapsedTimer t;
-	t.start();
+	// a background analysis of the same region would only replace our results
+	if (job_ && job_->data.region->start() == region->start()) {
+		cancelAnalysis();
+	}
+
+	std::unique_ptr<AnalysisJob> job = prepareAnalysis(region);
+	runAnalysis(job.get());
+	publishAnalysis(std::move(job));
+}
+
+/**
+ * @brief Analyzer::prepareAnalysis
+ *
+ * Takes a snapshot of the region and does the part of the analysis which needs
+ * the debugger core or the symbol manager. Must be called from the GUI thread.
+ *
+ * @param region
+ * @return the job for runAnalysis
+ */
+std::unique_ptr<Analyzer::AnalysisJob> Analyzer::prepareAnalysis(const std::shared_ptr<IRegion> &region) {
 
-	RegionData &region_data = analysisInfo_[region->start()];
 	qDebug() << "[Analyzer] Region name:" << region->name();
 
 	QSettings settings;
@@ -720,62 +963,240 @@ void Analyzer::analyze(const std::shared_ptr<IRegion> &region) {
 	const size_t page_size  = edb::v1::debugger_core->pageSize();
 	const size_t page_count = region->size() / page_size;
 
-	QVector<uint8_t> memory = edb::v1::read_pages(region->start(), page_count);
+	auto job         = std::make_unique<AnalysisJob>();
+	RegionData *data = &job->data;
+
+	// the debugger core isn't safe to use from another thread, so
+	// this one read of the whole region is all the analysis does here. Hashing
+	// it and looking at the cache is left to the worker
+	job->memory   = edb::v1::read_pages(region->start(), page_count);
+	job->pageSize = page_size;
+	data->region  = region;
+	data->fuzzy   = fuzzy;
+	job->symbols  = edb::v1::symbol_manager().symbols();
+	job->cache    = AnalysisCache(region);
+
+	// only if it is the same region, not just one which happens to
+	// start at the same address. The first time we see a region in this
+	// session, whatever an earlier session left behind is as good as a previous
+	// analysis
+	auto it = analysisInfo_.find(region->start());
+	if (it != analysisInfo_.end() && it->region && it->region->end() == region->end()) {
+		job->previous            = *it;
+		job->previousFromSession = true;
+	} else if (it == analysisInfo_.end()) {
+		job->loadCache = true;
+	}
 
-	const QByteArray md5      = (!memory.isEmpty()) ? edb::v1::get_md5(memory) : QByteArray();
-	const QByteArray prev_md5 = region_data.md5;
+	const struct {
+		const char *message;
+		std::function<void()> function;
+	} analysis_steps[] = {
+		{"identifying executable headers...", [this, data]() { identHeader(data); }},
+		{"adding entry points to the list...", [this, data]() { bonusEntryPoint(data); }},
+		{"attempting to add 'main' to the list...", [this, data]() { bonusMain(data); }},
+		{"attempting to add functions with symbols to the list...", [this, data]() { bonusSymbols(data); }},
+		{"attempting to add marked functions to the list...", [this, data]() { bonusMarkedFunctions(data); }},
+	};
 
-	if (md5 == prev_md5 && fuzzy == region_data.fuzzy) {
+	for (const auto &step : analysis_steps) {
+		qDebug("[Analyzer] %s", step.message);
+		step.function();
+	}
+
+	return job;
+}
+
+/**
+ * @brief Analyzer::usePreviousAnalysis
+ *
+ * Picks up the previous analysis of the region if nothing changed since, or
+ * the cached one. Otherwise the cached one becomes the previous analysis, if
+ * there wasn't one in this session.
+ *
+ * @param job
+ */
+void Analyzer::usePreviousAnalysis(AnalysisJob *job) {
+	Q_ASSERT(job);
+
+	RegionData *const data = &job->data;
+
+	if (job->previousFromSession && job->previous.pageHashes == data->pageHashes && job->previous.fuzzy == data->fuzzy) {
 		qDebug("[Analyzer] region unchanged, using previous analysis");
+		const std::shared_ptr<IRegion> region = data->region;
+		*data                                 = job->previous;
+		data->region                          = region;
+		job->upToDate                         = true;
+		return;
+	}
+
+	RegionData cached;
+	if (job->loadCache && job->cache.load(&cached, job->memory, job->pageSize)) {
+		if (cached.pageHashes == data->pageHashes && cached.fuzzy == data->fuzzy) {
+			qDebug("[Analyzer] region unchanged since it was cached, using cached analysis");
+			index_references(&cached, job->cancelled);
+			set_reference_counts(&cached.functions, cached.references, job->cancelled);
+			*data         = std::move(cached);
+			job->upToDate = true;
+			return;
+		}
+
+		if (!cached.functions.isEmpty()) {
+			job->previous = std::move(cached);
+		}
+	}
+}
+
+/**
+ * @brief Analyzer::indexReferences
+ * @param job
+ */
+void Analyzer::indexReferences(AnalysisJob *job) {
+	Q_ASSERT(job);
+
+	RegionData *const data     = &job->data;
+	const RegionData &previous = job->previous;
+
+	if (!job->incremental || !job->previousFromSession) {
+		index_references(data, job->cancelled);
 		return;
 	}
 
-	region_data.basicBlocks.clear();
-	region_data.functions.clear();
-	region_data.fuzzyFunctions.clear();
-	region_data.knownFunctions.clear();
+	// the previous index has the references of every previous
+	// block, so taking away those of the blocks which weren't kept leaves the
+	// ones of the kept blocks. Both are sorted, and a reference which is in
+	// more than one block is taken away as often as it was removed
+	std::vector<Reference> removed = job->removedReferences;
+	std::sort(removed.begin(), removed.end());
+
+	std::vector<Reference> added;
+	for (const edb::address_t address : job->collectedBlocks) {
+		if (job->cancelled) {
+			return;
+		}
+
+		auto it = data->basicBlocks.find(address);
+		if (it != data->basicBlocks.end()) {
+			for (const std::pair<edb::address_t, edb::address_t> &ref : it->references()) {
+				added.emplace_back(ref.second, ref.first);
+			}
+		}
+	}
+
+	std::sort(added.begin(), added.end());
+
+	std::vector<Reference> kept;
+	kept.reserve(static_cast<size_t>(previous.references.size()));
+	std::set_difference(previous.references.begin(), previous.references.end(), removed.begin(), removed.end(), std::back_inserter(kept));
+
+	QVector<Reference> references;
+	references.reserve(static_cast<int>(kept.size() + added.size()));
+	std::merge(kept.begin(), kept.end(), added.begin(), added.end(), std::back_inserter(references));
+
+	qDebug("[Analyzer] references: %d kept, %d removed, %d added",
+		   static_cast<int>(kept.size()),
+		   static_cast<int>(removed.size()),
+		   static_cast<int>(added.size()));
+
+	data->references = references;
+}
+
+/**
+ * @brief Analyzer::runAnalysis
+ *
+ * The expensive part of the analysis, it only works on the job so it is safe
+ * to call from any thread. Stops early if the job is cancelled.
+ *
+ * @param job
+ */
+void Analyzer::runAnalysis(AnalysisJob *job) {
 
-	region_data.memory = memory;
-	region_data.region = region;
-	region_data.md5    = md5;
-	region_data.fuzzy  = fuzzy;
+	Q_ASSERT(job);
+
+	QElapsedTimer t;
+	t.start();
+
+	RegionData *const data = &job->data;
 
 	const struct {
 		const char *message;
 		std::function<void()> function;
 	} analysis_steps[] = {
-		{"identifying executable headers...", [this, &region_data]() { identHeader(&region_data); }},
-		{"adding entry points to the list...", [this, &region_data]() { bonusEntryPoint(&region_data); }},
-		{"attempting to add 'main' to the list...", [this, &region_data]() { bonusMain(&region_data); }},
-		{"attempting to add functions with symbols to the list...", [this, &region_data]() { bonusSymbols(&region_data); }},
-		{"attempting to add marked functions to the list...", [this, &region_data]() { bonusMarkedFunctions(&region_data); }},
-		{"attempting to collect functions with fuzzy analysis...", [this, &region_data]() { collectFuzzyFunctions(&region_data); }},
-		{"collecting basic blocks...", [this, &region_data]() { collectFunctions(&region_data); }},
-		{"splitting basic blocks...", [this, &region_data]() { splitBlocks(&region_data); }},
-		{"computing non-returning functions...", [this, &region_data]() { computeNonReturning(&region_data); }},
+		{"hashing the pages of the region...", [job, data]() { data->pageHashes = page_hashes(job->memory, job->pageSize); }},
+		{"looking for a previous analysis...", [this, job]() { usePreviousAnalysis(job); }},
+		{"looking for functions which don't return...", [job]() { job->nonReturning = non_returning_functions(job->symbols, job->cancelled); }},
+		{"looking for functions which are unchanged...", [this, job]() { keepUnchangedFunctions(job); }},
+		{"attempting to collect functions with fuzzy analysis...", [this, job]() { collectFuzzyFunctions(job); }},
+		{"collecting basic blocks...", [this, job]() { collectFunctions(job); }},
+		{"splitting basic blocks...", [this, job]() { splitBlocks(job); }},
+		{"computing non-returning functions...", [this, data]() { computeNonReturning(data); }},
+		{"determining function types...", [job, data]() { set_function_types(&data->functions, job->collectedFunctions, job->cancelled); }},
+		{"indexing references...", [this, job]() { indexReferences(job); }},
+		{"counting references...", [job, data]() { set_reference_counts(&data->functions, data->references, job->cancelled); }},
+
+		// the cache is about the module as it is loaded, whatever
+		// changed in the region during this session is of no use to the next
+		// one, so only the first analysis of it in a session is saved
+		{"saving the results...", [job]() { if (!job->incremental || !job->previousFromSession) { job->cache.save(job->data, job->pageSize, job->cancelled); } }},
 	};
 
 	const int total_steps = sizeof(analysis_steps) / sizeof(analysis_steps[0]);
 
 	Q_EMIT updateProgress(util::percentage(0, total_steps));
-	for (int i = 0; i < total_steps; ++i) {
+	for (int i = 0; i < total_steps && !job->upToDate; ++i) {
+		if (job->cancelled) {
+			return;
+		}
+
 		qDebug("[Analyzer] %s", analysis_steps[i].message);
 		analysis_steps[i].function();
 		Q_EMIT updateProgress(util::percentage(i + 1, total_steps));
 	}
 
-	qDebug("[Analyzer] determining function types...");
+	qDebug("[Analyzer] complete");
+	qDebug("[Analyzer] elapsed: %lld ms", t.elapsed());
+}
 
-	set_function_types(&region_data.functions);
+/**
+ * @brief Analyzer::publishAnalysis
+ *
+ * Replaces the previous results for the job's region. Must be called from the
+ * GUI thread.
+ *
+ * @param job
+ */
+void Analyzer::publishAnalysis(std::unique_ptr<AnalysisJob> job) {
 
-	qDebug("[Analyzer] complete");
-	Q_EMIT updateProgress(100);
+	Q_ASSERT(job);
+
+	analysisInfo_[job->data.region->start()] = std::move(job->data);
 
 	if (analyzerWidget_) {
 		analyzerWidget_->update();
 	}
+}
 
-	qDebug("[Analyzer] elapsed: %lld ms", t.elapsed());
+/**
+ * @brief Analyzer::referencesTo
+ * @param target
+ * @return the addresses of the instructions which jump to or call <target>,
+ * in ascending order
+ */
+std::vector<edb::address_t> Analyzer::referencesTo(edb::address_t target) const {
+
+	std::vector<edb::address_t> results;
+
+	for (const RegionData &data : analysisInfo_) {
+		auto it = std::lower_bound(data.references.begin(), data.references.end(), std::make_pair(target, edb::address_t(0)));
+		for (; it != data.references.end() && it->first == target; ++it) {
+			results.push_back(it->second);
+		}
+	}
+
+	// overlapping blocks have some references in common
+	std::sort(results.begin(), results.end());
+	results.erase(std::unique(results.begin(), results.end()), results.end());
+	return results;
 }
 
 /**
@@ -806,7 +1227,14 @@ IAnalyzer::AddressCategory Analyzer::category(edb::address_t address) const {
  * @return
  */
 IAnalyzer::FunctionMap Analyzer::functions(const std::shared_ptr<IRegion> &region) const {
-	return analysisInfo_[region->start()].functions;
+	// operator[] of a const QHash hands out a copy of the whole
+	// RegionData, find doesn't
+	auto it = analysisInfo_.find(region->start());
+	if (it != analysisInfo_.end()) {
+		return it->functions;
+	}
+
+	return {};
 }
 
 /**
@@ -948,6 +1376,10 @@ void Analyzer::invalidateAnalysis(const std::shared_ptr<IRegion> &region) {
  */
 void Analyzer::invalidateDynamicAnalysis(const std::shared_ptr<IRegion> &region) {
 
+	if (job_ && job_->data.region->start() == region->start()) {
+		cancelAnalysis();
+	}
+
 	RegionData info;
 	info.region = region;
 	info.fuzzy  = false;
@@ -959,6 +1391,7 @@ void Analyzer::invalidateDynamicAnalysis(const std::shared_ptr<IRegion> &region)
  * @brief Analyzer::invalidateAnalysis
  */
 void Analyzer::invalidateAnalysis() {
+	cancelAnalysis();
 	analysisInfo_.clear();
 	specifiedFunctions_.clear();
 }
@@ -19,10 +19,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef ANALYZER_H_20080630_
 #define ANALYZER_H_20080630_
 
+#include "AnalysisCache.h"
 #include "BasicBlock.h"
 #include "IAnalyzer.h"
 #include "IPlugin.h"
 #include "IRegion.h"
+#include "RegionData.h"
 #include "Symbol.h"
 #include "Types.h"
 
@@ -32,7 +34,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QSet>
 #include <QVector>
 
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
 class QMenu;
+class QProgressDialog;
 
 namespace AnalyzerPlugin {
 
@@ -46,10 +55,11 @@ class Analyzer final : public QObject, public IAnalyzer, public IPlugin {
 	Q_CLASSINFO("url", "http://www.codef00.com")
 
 private:
-	struct RegionData;
+	struct AnalysisJob;
 
 public:
 	explicit Analyzer(QObject *parent = nullptr);
+	~Analyzer() override;
 
 public:
 	[[nodiscard]] QMenu *menu(QWidget *parent = nullptr) override;
@@ -64,6 +74,7 @@ public:
 	[[nodiscard]] FunctionMap functions() const override;
 	[[nodiscard]] FunctionMap functions(const std::shared_ptr<IRegion> &region) const override;
 	[[nodiscard]] QSet<edb::address_t> specifiedFunctions() const override { return specifiedFunctions_; }
+	[[nodiscard]] std::vector<edb::address_t> referencesTo(edb::address_t target) const override;
 	[[nodiscard]] Result<edb::address_t, QString> findContainingFunction(edb::address_t address) const override;
 	bool forFuncsInRange(edb::address_t start, edb::address_t end, std::function<bool(const Function *)> functor) const override;
 	void analyze(const std::shared_ptr<IRegion> &region) override;
@@ -76,16 +87,27 @@ private:
 	void bonusMain(RegionData *data) const;
 	void bonusMarkedFunctions(RegionData *data);
 	void bonusSymbols(RegionData *data);
-	void collectFunctions(RegionData *data);
+	void collectFunctions(AnalysisJob *job);
+	void keepUnchangedFunctions(AnalysisJob *job);
+	void usePreviousAnalysis(AnalysisJob *job);
+	void indexReferences(AnalysisJob *job);
 	void computeNonReturning(RegionData *data);
-	void splitBlocks(RegionData *data);
-	void collectFuzzyFunctions(RegionData *data);
+	void splitBlocks(AnalysisJob *job);
+	void collectFuzzyFunctions(AnalysisJob *job);
 	void doAnalysis(const std::shared_ptr<IRegion> &region);
-	void identHeader(Analyzer::RegionData *data);
+	void identHeader(RegionData *data);
 	void invalidateDynamicAnalysis(const std::shared_ptr<IRegion> &region);
+	[[nodiscard]] std::unique_ptr<AnalysisJob> prepareAnalysis(const std::shared_ptr<IRegion> &region);
+	void runAnalysis(AnalysisJob *job);
+	void publishAnalysis(std::unique_ptr<AnalysisJob> job);
 
 Q_SIGNALS:
 	void updateProgress(int);
+	void analysisFinished();
+
+private Q_SLOTS:
+	void finishAnalysis();
+	void cancelAnalysis();
 
 public Q_SLOTS:
 	void doIpAnalysis();
@@ -97,23 +119,60 @@ public Q_SLOTS:
 	void showSpecified();
 
 private:
-	struct RegionData {
-		QSet<edb::address_t> knownFunctions;
-		QSet<edb::address_t> fuzzyFunctions;
-
-		FunctionMap functions;
-		QHash<edb::address_t, BasicBlock> basicBlocks;
-
-		QByteArray md5;
-		bool fuzzy;
-		std::shared_ptr<IRegion> region;
+	// everything a background analysis works on, the worker thread touches
+	// nothing else. The results replace the ones in analysisInfo_ in one go
+	// once it is done, until then everyone keeps seeing the previous ones
+	struct AnalysisJob {
+		RegionData data;
 
-		// a copy of the whole region
+		// a copy of the whole region, only kept while the analysis runs
 		QVector<uint8_t> memory;
+		size_t pageSize = 0;
+
+		// the last results for the region, functions which don't touch any of
+		// the pages which changed since are kept as they are. They are either
+		// from earlier in this session, or from the cache if there are none
+		RegionData previous;
+		bool previousFromSession = false;
+		bool loadCache           = false;
+		QList<edb::address_t> changedFunctions;
+
+		// set once some of the previous results are kept, the rest of the
+		// analysis then only has to look at what changed: the byte ranges of
+		// the pages which changed, the references of the blocks which weren't
+		// kept as (target, source), and what was collected again
+		bool incremental = false;
+		std::vector<std::pair<size_t, size_t>> changedRanges;
+		std::vector<std::pair<edb::address_t, edb::address_t>> removedReferences;
+		QList<edb::address_t> collectedFunctions;
+		QList<edb::address_t> collectedBlocks;
+
+		// the previous results, or the cached ones, are still good and are in
+		// data already, nothing is left to do
+		bool upToDate = false;
+
+		// where the instructions of the kept blocks and the new ones go, so the
+		// arena of the previous results can be let go of
+		std::shared_ptr<InstructionArena> arena;
+
+		// the symbol manager may only be used from the GUI thread, so we take a
+		// copy of the symbols ahead of time and work out which of them don't
+		// return from that
+		std::vector<std::shared_ptr<Symbol>> symbols;
+		QSet<edb::address_t> nonReturning;
+
+		// where the results are kept for the next session
+		AnalysisCache cache;
+
+		std::atomic<bool> cancelled{false};
+		std::atomic<bool> finished{false};
+		std::thread thread;
 	};
 
 	QMenu *menu_                    = nullptr;
 	AnalyzerWidget *analyzerWidget_ = nullptr;
+	QProgressDialog *progress_      = nullptr;
+	std::unique_ptr<AnalysisJob> job_;
 	QHash<edb::address_t, RegionData> analysisInfo_;
 	QSet<edb::address_t> specifiedFunctions_;
 };
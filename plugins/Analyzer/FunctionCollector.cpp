@@ -0,0 +1,494 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FunctionCollector.h"
+#include "Function.h"
+#include "Instruction.h"
+
+#include <QStack>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace AnalyzerPlugin {
+
+/**
+ * @brief FunctionCollector::TaskQueue::push
+ * @param address
+ */
+void FunctionCollector::TaskQueue::push(edb::address_t address) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	tasks_.push_back(address);
+}
+
+/**
+ * @brief FunctionCollector::TaskQueue::pop
+ * @param address
+ * @return true if a task was taken, the owner works on the newest one first
+ */
+bool FunctionCollector::TaskQueue::pop(edb::address_t *address) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (tasks_.empty()) {
+		return false;
+	}
+
+	*address = tasks_.back();
+	tasks_.pop_back();
+	return true;
+}
+
+/**
+ * @brief FunctionCollector::TaskQueue::steal
+ * @param address
+ * @return true if a task was taken, thieves take the oldest one
+ */
+bool FunctionCollector::TaskQueue::steal(edb::address_t *address) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (tasks_.empty()) {
+		return false;
+	}
+
+	*address = tasks_.front();
+	tasks_.pop_front();
+	return true;
+}
+
+/**
+ * @brief FunctionCollector::FunctionCollector
+ * @param region
+ * @param memory a copy of the whole region
+ * @param arena where the instructions of the blocks go, its base must be the
+ * start of the region
+ * @param nonReturning the functions which are known to never return
+ * @param cancelled when this becomes true, the workers stop as soon as they can
+ */
+FunctionCollector::FunctionCollector(const std::shared_ptr<IRegion> &region, const QVector<uint8_t> &memory, std::shared_ptr<InstructionArena> arena, const QSet<edb::address_t> &nonReturning, const std::atomic<bool> &cancelled)
+	: region_(region), memory_(memory), nonReturning_(nonReturning), cancelled_(cancelled), arena_(std::move(arena)) {
+	Q_ASSERT(arena_ && arena_->base() == region->start());
+}
+
+/**
+ * treats the given functions and blocks as if they had been walked already,
+ * so they won't be again. Must be called before run
+ *
+ * @brief FunctionCollector::skip
+ * @param functions
+ * @param blocks
+ */
+void FunctionCollector::skip(const QSet<edb::address_t> &functions, const QSet<edb::address_t> &blocks) {
+	claimedFunctions_ = functions;
+	skippedBlocks_    = blocks;
+}
+
+/**
+ * @brief FunctionCollector::run
+ * @param entryPoints
+ * @param threadCount
+ */
+void FunctionCollector::run(const QList<edb::address_t> &entryPoints, unsigned int threadCount) {
+
+	threadCount = std::max(1u, threadCount);
+
+	std::vector<TaskQueue> queues(threadCount);
+	queues_.swap(queues);
+
+	// deal the entry points out round robin, the stealing evens out the rest
+	std::size_t n = 0;
+	for (const edb::address_t address : entryPoints) {
+		submit(n++ % threadCount, address);
+	}
+
+	std::vector<Results> results(threadCount);
+	std::vector<std::thread> workers;
+
+	// the calling thread is a worker too
+	for (unsigned int i = 1; i < threadCount; ++i) {
+		workers.emplace_back(&FunctionCollector::work, this, i, &results[i]);
+	}
+
+	work(0, &results[0]);
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	merge(results);
+}
+
+/**
+ * puts the blocks the workers found into the arena, and gives each of them to
+ * the function it belongs to
+ *
+ * @brief FunctionCollector::merge
+ * @param results
+ */
+void FunctionCollector::merge(const std::vector<Results> &results) {
+
+	// a block belongs to the closest function which starts at or before it and
+	// reaches it. Only the functions found by now count, so this doesn't depend
+	// on the order in which they were found
+	QHash<edb::address_t, edb::address_t> owners;
+	for (const Results &result : results) {
+		for (const auto &function : result.functions) {
+			for (const edb::address_t address : function.second) {
+				if (address < function.first) {
+					continue;
+				}
+
+				auto it = owners.find(address);
+				if (it == owners.end()) {
+					owners.insert(address, function.first);
+				} else if (it.value() < function.first) {
+					it.value() = function.first;
+				}
+			}
+		}
+	}
+
+	// which worker decoded what, and when, depends on timing, so
+	// the blocks go into the arena in order of their address
+	std::vector<edb::address_t> addresses;
+	addresses.reserve(static_cast<size_t>(decodedBlocks_.size()));
+	for (auto it = decodedBlocks_.begin(); it != decodedBlocks_.end(); ++it) {
+		addresses.push_back(it.key());
+	}
+
+	std::sort(addresses.begin(), addresses.end());
+
+	for (const edb::address_t address : addresses) {
+		const DecodedBlock &decoded = *decodedBlocks_[address];
+		if (decoded.records.empty()) {
+			continue;
+		}
+
+		BasicBlock block(arena_, arena_->append(decoded.records, memory_.data()), decoded.records.size());
+		for (const auto &reference : decoded.references) {
+			block.addReference(reference.first, reference.second);
+		}
+
+		basicBlocks_.insert(address, block);
+
+		auto owner = owners.find(address);
+		if (owner != owners.end()) {
+			functions_[owner.value()].insert(std::move(block));
+		}
+	}
+
+	decodedBlocks_.clear();
+}
+
+/**
+ * @brief FunctionCollector::submit
+ * @param worker
+ * @param address
+ */
+void FunctionCollector::submit(std::size_t worker, edb::address_t address) {
+	{
+		// counted before it is visible to anyone, otherwise a worker
+		// could see no pending work while this one is still on its way
+		std::lock_guard<std::mutex> lock(idleMutex_);
+		++pending_;
+		++queued_;
+		queues_[worker].push(address);
+	}
+
+	idle_.notify_one();
+}
+
+/**
+ * @brief FunctionCollector::finishTask
+ */
+void FunctionCollector::finishTask() {
+	std::lock_guard<std::mutex> lock(idleMutex_);
+	if (--pending_ == 0) {
+		idle_.notify_all();
+	}
+}
+
+/**
+ * @brief FunctionCollector::nextTask
+ * @param worker
+ * @param address
+ * @return false once there is no work left anywhere, or the job was cancelled
+ */
+bool FunctionCollector::nextTask(std::size_t worker, edb::address_t *address) {
+
+	while (!cancelled_) {
+
+		bool found = queues_[worker].pop(address);
+		for (std::size_t i = 1; !found && i < queues_.size(); ++i) {
+			found = queues_[(worker + i) % queues_.size()].steal(address);
+		}
+
+		std::unique_lock<std::mutex> lock(idleMutex_);
+		if (found) {
+			--queued_;
+			return true;
+		}
+
+		// nothing queued and nobody busy means nothing new can show up
+		if (pending_ == 0) {
+			return false;
+		}
+
+		// whoever cancels the job doesn't know about idle_, so we
+		// have to take a look at the flag every now and then
+		idle_.wait_for(lock, std::chrono::milliseconds(10), [this]() {
+			return queued_ > 0 || pending_ == 0 || cancelled_;
+		});
+	}
+
+	return false;
+}
+
+/**
+ * @brief FunctionCollector::work
+ * @param worker
+ * @param results
+ */
+void FunctionCollector::work(std::size_t worker, Results *results) {
+
+	edb::address_t address;
+	while (nextTask(worker, &address)) {
+		collectFunction(worker, address, results);
+		finishTask();
+	}
+}
+
+/**
+ * @brief FunctionCollector::claimFunction
+ * @param address
+ * @return true if no other task has processed this function
+ */
+bool FunctionCollector::claimFunction(edb::address_t address) {
+	std::lock_guard<std::mutex> lock(claimMutex_);
+	if (claimedFunctions_.contains(address)) {
+		return false;
+	}
+
+	claimedFunctions_.insert(address);
+	return true;
+}
+
+/**
+ * @brief FunctionCollector::instructionBytes
+ * @param address
+ * @param last set to the end of the bytes available for the instruction
+ * @return a pointer to the bytes at <address> in the copy of the region, or
+ * nullptr if it isn't part of it
+ */
+const uint8_t *FunctionCollector::instructionBytes(edb::address_t address, const uint8_t **last) const {
+
+	Q_ASSERT(last);
+
+	if (address < region_->start() || (address - region_->start()) >= static_cast<uint64_t>(memory_.size())) {
+		return nullptr;
+	}
+
+	const uint8_t *const first = memory_.data() + (address - region_->start()).toUint();
+	*last                      = std::min(first + edb::Instruction::MaxSize, memory_.data() + memory_.size());
+	return first;
+}
+
+/**
+ * decodes the block at <address>, every block is only decoded once no matter
+ * how many functions reach it
+ *
+ * @brief FunctionCollector::decodeBlock
+ * @param blockAddress
+ * @return
+ */
+std::shared_ptr<const FunctionCollector::DecodedBlock> FunctionCollector::decodeBlock(edb::address_t blockAddress) {
+
+	{
+		std::lock_guard<std::mutex> lock(decodeMutex_);
+		auto it = decodedBlocks_.find(blockAddress);
+		if (it != decodedBlocks_.end()) {
+			return it.value();
+		}
+	}
+
+	auto block = std::make_shared<DecodedBlock>();
+
+	auto &records          = block->records;
+	auto &references       = block->references;
+	edb::address_t address = blockAddress;
+
+	while (region_->contains(address)) {
+
+		const uint8_t *last  = nullptr;
+		const uint8_t *first = instructionBytes(address, &last);
+		if (!first) {
+			break;
+		}
+
+		const edb::Instruction inst(first, last, address);
+		if (!inst.valid()) {
+			break;
+		}
+
+		InstructionRecord record;
+		record.offset = static_cast<uint32_t>((address - region_->start()).toUint());
+		record.size   = static_cast<uint8_t>(inst.byteSize());
+
+		if (is_call(inst)) {
+
+			record.flow = InstructionFlow::Call;
+
+			// note the destination and move on
+			// we special case some simple things.
+			// also this is an opportunity to find call tables.
+			const edb::Operand op = inst.operand(0);
+			if (is_immediate(op)) {
+				const edb::address_t ea = op->imm;
+				record.target           = ea;
+
+				// skip over ones which are: "call <label>; label:"
+				if (ea != address + inst.byteSize()) {
+					if (nonReturning_.contains(ea)) {
+						records.push_back(record);
+						break;
+					}
+
+					references.emplace_back(address, ea);
+				}
+			}
+
+		} else if (is_unconditional_jump(inst)) {
+
+			record.flow = InstructionFlow::Jump;
+			records.push_back(record);
+
+			Q_ASSERT(inst.operandCount() >= 1);
+			const edb::Operand op = inst.operand(0);
+
+			if (is_immediate(op)) {
+				const edb::address_t ea = op->imm;
+				records.back().target   = ea;
+				references.emplace_back(address, ea);
+			}
+			break;
+		} else if (is_conditional_jump(inst)) {
+
+			record.flow = InstructionFlow::ConditionalJump;
+			records.push_back(record);
+
+			Q_ASSERT(inst.operandCount() == 1);
+			const edb::Operand op = inst.operand(0);
+
+			if (is_immediate(op)) {
+				const edb::address_t ea = op->imm;
+				records.back().target   = ea;
+				references.emplace_back(address, ea);
+			}
+			break;
+		} else if (is_terminator(inst)) {
+			record.flow = InstructionFlow::Terminator;
+			records.push_back(record);
+			break;
+		}
+
+		records.push_back(record);
+		address += inst.byteSize();
+	}
+
+	// two workers may decode the same block at once, they come up
+	// with the same thing so it doesn't matter whose is kept
+	std::lock_guard<std::mutex> lock(decodeMutex_);
+	auto it = decodedBlocks_.find(blockAddress);
+	if (it == decodedBlocks_.end()) {
+		it = decodedBlocks_.insert(blockAddress, block);
+	}
+
+	return it.value();
+}
+
+/**
+ * @brief FunctionCollector::collectFunction
+ * @param worker
+ * @param functionAddress
+ * @param results
+ */
+void FunctionCollector::collectFunction(std::size_t worker, edb::address_t functionAddress, Results *results) {
+
+	if (!claimFunction(functionAddress)) {
+		return;
+	}
+
+	QStack<edb::address_t> blocks;
+	blocks.push(functionAddress);
+
+	// blocks which other functions reach too are walked through
+	// all the same, which function keeps them is decided once everyone is done
+	QSet<edb::address_t> visited;
+	std::vector<edb::address_t> reached;
+
+	// process are basic blocks that are known
+	while (!blocks.empty()) {
+
+		const edb::address_t block_address = blocks.pop();
+
+		if (visited.contains(block_address) || skippedBlocks_.contains(block_address)) {
+			continue;
+		}
+
+		visited.insert(block_address);
+
+		const std::shared_ptr<const DecodedBlock> block = decodeBlock(block_address);
+		if (block->records.empty()) {
+			continue;
+		}
+
+		reached.push_back(block_address);
+
+		const edb::address_t start = region_->start();
+
+		for (const InstructionRecord &record : block->records) {
+			if (record.flow == InstructionFlow::Call && record.target && record.target != start + record.offset + record.size) {
+				submit(worker, record.target);
+			}
+		}
+
+		const InstructionRecord &last = block->records.back();
+		const edb::address_t ea       = last.target;
+
+		if (last.flow == InstructionFlow::Jump && ea) {
+			// TODO(eteran): we need some heuristic for detecting when this is
+			//               a call/ret -> jmp optimization
+			//
+			// a jump close by is followed even if it lands on another function
+			// (a tail call), whether other workers found that one yet depends
+			// on timing. If it is a function in the end, merge gives it its
+			// own blocks back since it starts closer to them
+			if ((ea - functionAddress) > 0x2000u) {
+				submit(worker, ea);
+			} else {
+				blocks.push(ea);
+			}
+		} else if (last.flow == InstructionFlow::ConditionalJump && ea) {
+			blocks.push(ea);
+			blocks.push(start + last.offset + last.size);
+		}
+	}
+
+	if (!reached.empty()) {
+		results->functions.emplace_back(functionAddress, std::move(reached));
+	}
+}
+
+}
@@ -0,0 +1,131 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FUNCTION_COLLECTOR_H_20240301_
+#define FUNCTION_COLLECTOR_H_20240301_
+
+#include "BasicBlock.h"
+#include "IAnalyzer.h"
+#include "IRegion.h"
+#include "Types.h"
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QVector>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace AnalyzerPlugin {
+
+// Finds the functions and basic blocks which are reachable from a set of
+// entry points. Every function is a task for a pool of worker threads, each of
+// which decodes straight out of a copy of the region. Call targets found along
+// the way become new tasks for the worker which found them, and a worker which
+// runs out of tasks steals from the others.
+//
+// The instructions of all blocks are kept as compact records in one arena
+// for the region, they are decoded again whenever somebody needs the details.
+//
+// A block which is reached from more than one function belongs to the closest
+// of them which starts at or before it, no matter which worker got there first.
+class FunctionCollector {
+public:
+	FunctionCollector(const std::shared_ptr<IRegion> &region, const QVector<uint8_t> &memory, std::shared_ptr<InstructionArena> arena, const QSet<edb::address_t> &nonReturning, const std::atomic<bool> &cancelled);
+	FunctionCollector(const FunctionCollector &)            = delete;
+	FunctionCollector &operator=(const FunctionCollector &) = delete;
+
+public:
+	void skip(const QSet<edb::address_t> &functions, const QSet<edb::address_t> &blocks);
+	void run(const QList<edb::address_t> &entryPoints, unsigned int threadCount);
+
+public:
+	[[nodiscard]] const IAnalyzer::FunctionMap &functions() const { return functions_; }
+	[[nodiscard]] const QHash<edb::address_t, BasicBlock> &basicBlocks() const { return basicBlocks_; }
+
+private:
+	// what a worker found, every function it walked along with the address
+	// of every block which was reached from it
+	struct Results {
+		std::vector<std::pair<edb::address_t, std::vector<edb::address_t>>> functions;
+	};
+
+	// the instructions of a block, these don't depend on who reached it
+	struct DecodedBlock {
+		std::vector<InstructionRecord> records;
+		std::vector<std::pair<edb::address_t, edb::address_t>> references;
+	};
+
+	class TaskQueue {
+	public:
+		void push(edb::address_t address);
+		bool pop(edb::address_t *address);
+		bool steal(edb::address_t *address);
+
+	private:
+		std::mutex mutex_;
+		std::deque<edb::address_t> tasks_;
+	};
+
+private:
+	void work(std::size_t worker, Results *results);
+	void collectFunction(std::size_t worker, edb::address_t functionAddress, Results *results);
+	void merge(const std::vector<Results> &results);
+	void submit(std::size_t worker, edb::address_t address);
+	void finishTask();
+	[[nodiscard]] bool nextTask(std::size_t worker, edb::address_t *address);
+	[[nodiscard]] bool claimFunction(edb::address_t address);
+	[[nodiscard]] std::shared_ptr<const DecodedBlock> decodeBlock(edb::address_t blockAddress);
+	[[nodiscard]] const uint8_t *instructionBytes(edb::address_t address, const uint8_t **last) const;
+
+private:
+	std::shared_ptr<IRegion> region_;
+	const QVector<uint8_t> &memory_;
+	const QSet<edb::address_t> &nonReturning_;
+	const std::atomic<bool> &cancelled_;
+	std::shared_ptr<InstructionArena> arena_;
+
+	std::vector<TaskQueue> queues_;
+
+	// idle workers sleep until a task is queued or the last one is done
+	std::mutex idleMutex_;
+	std::condition_variable idle_;
+	int64_t pending_ = 0; // queued or being worked on
+	int64_t queued_  = 0;
+
+	std::mutex claimMutex_;
+	QSet<edb::address_t> claimedFunctions_;
+
+	// the blocks of the functions which are skipped, nobody walks into them
+	QSet<edb::address_t> skippedBlocks_;
+
+	std::mutex decodeMutex_;
+	QHash<edb::address_t, std::shared_ptr<const DecodedBlock>> decodedBlocks_;
+
+	IAnalyzer::FunctionMap functions_;
+	QHash<edb::address_t, BasicBlock> basicBlocks_;
+};
+
+}
+
+#endif
@@ -0,0 +1,431 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FuzzyScanner.h"
+#include "Instruction.h"
+#include "LengthDecoder.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace AnalyzerPlugin {
+
+namespace {
+
+// below this, starting threads costs more than it saves
+constexpr std::size_t MinChunkSize = 64 * 1024;
+
+// how often a chunk checks if the analysis was cancelled
+constexpr std::size_t CancelCheckInterval = 64 * 1024;
+
+#if defined(EDB_X86) || defined(EDB_X86_64)
+/**
+ * @brief is_endbr
+ * @param p
+ * @param last
+ * @return true if <p> points at an endbr32 or endbr64
+ */
+bool is_endbr(const uint8_t *p, const uint8_t *last) {
+	return last - p >= 4 && p[0] == 0xf3 && p[1] == 0x0f && p[2] == 0x1e && (p[3] == 0xfa || p[3] == 0xfb);
+}
+
+/**
+ * @brief is_prefix
+ * @param byte
+ * @param x86_64
+ * @return true if <byte> may precede an opcode as a prefix
+ */
+bool is_prefix(uint8_t byte, bool x86_64) {
+	switch (byte) {
+	case 0x26:
+	case 0x2e:
+	case 0x36:
+	case 0x3e:
+	case 0x64:
+	case 0x65:
+	case 0x66:
+	case 0x67:
+	case 0xf0:
+	case 0xf2:
+	case 0xf3:
+		return true;
+	default:
+		return x86_64 && (byte & 0xf0) == 0x40;
+	}
+}
+
+/**
+ * @brief lowest_bit
+ * @param mask must not be 0
+ * @return the index of the lowest set bit of <mask>
+ */
+int lowest_bit(unsigned int mask) {
+#if defined(__GNUC__)
+	return __builtin_ctz(mask);
+#else
+	int n = 0;
+	while (!(mask & 1)) {
+		mask >>= 1;
+		++n;
+	}
+	return n;
+#endif
+}
+
+/**
+ * calls <func> with the offset of every byte in [first, last) which is an
+ * e8, f3 or (if <far_calls> is true) 9a, in ascending order
+ *
+ * @brief for_each_candidate
+ * @param first
+ * @param last
+ * @param far_calls
+ * @param func
+ */
+template <class F>
+void for_each_candidate(const uint8_t *first, const uint8_t *last, bool far_calls, F func) {
+
+	const uint8_t *p = first;
+
+#if defined(__SSE2__) || defined(_M_X64)
+	const __m128i call     = _mm_set1_epi8(static_cast<char>(0xe8));
+	const __m128i rep      = _mm_set1_epi8(static_cast<char>(0xf3));
+	const __m128i far_call = _mm_set1_epi8(static_cast<char>(far_calls ? 0x9a : 0xe8));
+
+	for (; last - p >= 16; p += 16) {
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		const __m128i hits  = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, call), _mm_cmpeq_epi8(bytes, rep)), _mm_cmpeq_epi8(bytes, far_call));
+
+		auto mask = static_cast<unsigned int>(_mm_movemask_epi8(hits));
+		while (mask) {
+			func(static_cast<std::size_t>(p - first) + lowest_bit(mask));
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for (; p != last; ++p) {
+		if (*p == 0xe8 || *p == 0xf3 || (far_calls && *p == 0x9a)) {
+			func(static_cast<std::size_t>(p - first));
+		}
+	}
+}
+#endif
+
+}
+
+/**
+ * @brief FuzzyScanner::FuzzyScanner
+ * @param base the address of the first byte of <memory>
+ * @param memory a copy of the whole region
+ * @param cancelled when this becomes true, the scan stops as soon as it can
+ */
+FuzzyScanner::FuzzyScanner(edb::address_t base, const QVector<uint8_t> &memory, const std::atomic<bool> &cancelled)
+	: base_(base), memory_(memory), cancelled_(cancelled) {
+}
+
+/**
+ * scans the whole region
+ *
+ * @brief FuzzyScanner::run
+ * @param threadCount
+ */
+void FuzzyScanner::run(unsigned int threadCount) {
+	scanRanges({{0, static_cast<std::size_t>(memory_.size())}}, threadCount);
+}
+
+/**
+ * scans only around the parts of the region which changed since <previous>,
+ * the results are the same as those of a scan of the whole region
+ *
+ * @brief FuzzyScanner::update
+ * @param previous the results of a scan of the region as it was before
+ * @param changed the ranges of the region which changed since, in order of
+ * their offset
+ * @param threadCount
+ */
+void FuzzyScanner::update(const FuzzyScanResults &previous, const std::vector<Range> &changed, unsigned int threadCount) {
+
+	const auto size = static_cast<std::size_t>(memory_.size());
+
+	// an instruction which starts a few bytes in front of a change
+	// may be affected by it too, one which starts further away can't be
+	std::vector<Range> windows;
+	for (const Range &range : changed) {
+		const std::size_t begin = range.first > edb::Instruction::MaxSize - 1 ? range.first - (edb::Instruction::MaxSize - 1) : 0;
+		const std::size_t end   = std::min(range.second, size);
+
+		if (!windows.empty() && begin <= windows.back().second) {
+			windows.back().second = std::max(windows.back().second, end);
+		} else if (begin < end) {
+			windows.emplace_back(begin, end);
+		}
+	}
+
+	scanRanges(windows, threadCount);
+
+	FuzzyScanResults scanned = std::move(results_);
+	results_                 = FuzzyScanResults();
+
+	auto in_window = [&windows](std::size_t offset) {
+		auto it = std::upper_bound(windows.begin(), windows.end(), offset, [](std::size_t value, const Range &window) {
+			return value < window.second;
+		});
+		return it != windows.end() && offset >= it->first;
+	};
+
+	// whatever the previous scan found in the windows is replaced by what was
+	// found there now, the new call sites go in between the old ones in order
+	results_.callTargets = previous.callTargets;
+	results_.callSites.reserve(previous.callSites.size() + scanned.callSites.size());
+
+	auto next = scanned.callSites.cbegin();
+	for (const FuzzyScanResults::CallSite &site : previous.callSites) {
+		if (in_window(site.offset)) {
+			auto it = results_.callTargets.find(site.target);
+			if (it != results_.callTargets.end() && --it.value() == 0) {
+				results_.callTargets.erase(it);
+			}
+			continue;
+		}
+
+		for (; next != scanned.callSites.cend() && next->offset < site.offset; ++next) {
+			results_.callSites.push_back(*next);
+		}
+
+		results_.callSites.push_back(site);
+	}
+
+	for (; next != scanned.callSites.cend(); ++next) {
+		results_.callSites.push_back(*next);
+	}
+
+	for (const FuzzyScanResults::CallSite &site : scanned.callSites) {
+		results_.callTargets[site.target]++;
+	}
+
+	for (const edb::address_t address : previous.landingPads) {
+		if (!in_window((address - base_).toUint())) {
+			results_.landingPads.insert(address);
+		}
+	}
+
+	results_.landingPads.unite(scanned.landingPads);
+}
+
+/**
+ * @brief FuzzyScanner::scanRanges
+ * @param ranges the parts of the region to scan, in order of their offset
+ * @param threadCount
+ */
+void FuzzyScanner::scanRanges(const std::vector<Range> &ranges, unsigned int threadCount) {
+
+	std::size_t total = 0;
+	for (const Range &range : ranges) {
+		total += range.second - range.first;
+	}
+
+	const std::size_t chunks = std::max<std::size_t>(1, std::min<std::size_t>(threadCount, total / MinChunkSize));
+	const std::size_t step   = (total + chunks - 1) / chunks;
+
+	// cut the ranges into about the same amount of work for every chunk
+	std::vector<std::vector<Range>> pieces(chunks);
+	std::size_t chunk  = 0;
+	std::size_t filled = 0;
+	for (const Range &range : ranges) {
+		for (std::size_t begin = range.first; begin < range.second;) {
+			const std::size_t room = (chunk + 1 < chunks) ? step - filled : range.second - begin;
+			const std::size_t n    = std::min(range.second - begin, room);
+
+			pieces[chunk].emplace_back(begin, begin + n);
+			begin += n;
+			filled += n;
+
+			if (chunk + 1 < chunks && filled == step) {
+				++chunk;
+				filled = 0;
+			}
+		}
+	}
+
+	std::vector<Results> results(chunks);
+	std::vector<std::thread> workers;
+
+	auto scan_pieces = [this, &pieces, &results](std::size_t i) {
+		for (const Range &piece : pieces[i]) {
+			scan(piece.first, piece.second, &results[i]);
+		}
+	};
+
+	// the calling thread takes the first chunk
+	for (std::size_t i = 1; i < chunks; ++i) {
+		workers.emplace_back(scan_pieces, i);
+	}
+
+	scan_pieces(0);
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	// every chunk finds its call sites in order, and the chunks
+	// are in order too
+	results_ = FuzzyScanResults();
+	for (const Results &result : results) {
+		for (const FuzzyScanResults::CallSite &site : result.callSites) {
+			results_.callSites.push_back(site);
+			results_.callTargets[site.target]++;
+		}
+
+		results_.landingPads.unite(result.landingPads);
+	}
+}
+
+/**
+ * scans the instructions which start in [begin, end), they may extend past
+ * <end> though
+ *
+ * @brief FuzzyScanner::scan
+ * @param begin
+ * @param end
+ * @param results
+ */
+void FuzzyScanner::scan(std::size_t begin, std::size_t end, Results *results) const {
+
+	std::size_t next_check = begin + CancelCheckInterval;
+
+#if defined(EDB_X86) || defined(EDB_X86_64)
+	const bool x86_64    = CapstoneEDB::architecture() == CapstoneEDB::Architecture::ARCH_AMD64;
+	const uint8_t *first = memory_.data();
+
+	// an instruction starting in this chunk may have its opcode
+	// in the next one, so we look a little further for those
+	const std::size_t limit = std::min(static_cast<std::size_t>(memory_.size()), end + edb::Instruction::MaxSize);
+
+	// the lowest offset which hasn't been checked yet
+	std::size_t floor = begin;
+	bool cancelled    = false;
+
+	for_each_candidate(first + begin, first + limit, !x86_64, [&](std::size_t hit) {
+		hit += begin;
+
+		if (cancelled) {
+			return;
+		}
+
+		if (hit >= next_check) {
+			if (cancelled_) {
+				cancelled = true;
+				return;
+			}
+			next_check = hit + CancelCheckInterval;
+		}
+
+		// any prefixes in front of the opcode make a longer instruction which
+		// ends in the same place, so those offsets need a look too
+		std::size_t start = hit;
+		while (start > floor && hit - start < edb::Instruction::MaxSize - 1 && is_prefix(first[start - 1], x86_64)) {
+			--start;
+		}
+
+		for (std::size_t offset = start; offset <= hit && offset < end; ++offset) {
+			check(offset, results);
+		}
+
+		floor = hit + 1;
+	});
+#else
+	for (std::size_t offset = begin; offset != end; ++offset) {
+		if (offset >= next_check) {
+			if (cancelled_) {
+				return;
+			}
+			next_check = offset + CancelCheckInterval;
+		}
+
+		check(offset, results);
+	}
+#endif
+}
+
+/**
+ * does what the fuzzy function detection has always done for every byte
+ * offset of the region
+ *
+ * @brief FuzzyScanner::check
+ * @param offset
+ * @param results
+ */
+void FuzzyScanner::check(std::size_t offset, Results *results) const {
+
+	const uint8_t *const p    = memory_.data() + offset;
+	const uint8_t *const last = memory_.data() + memory_.size();
+	const edb::address_t addr = base_ + offset;
+
+#if defined(EDB_X86) || defined(EDB_X86_64)
+	// for plain direct near calls the length decoder knows
+	// everything we need, so capstone is only asked about what is left. With
+	// prefixes capstone is the judge of whether it is valid at all
+	const CapstoneEDB::LengthInfo info = CapstoneEDB::decode_length(p, last, addr);
+	if (info.size != 0) {
+		if (info.flow == CapstoneEDB::Flow::Call && info.hasTarget && p[0] == 0xe8) {
+			// skip over ones which are: "call <label>; label:"
+			if (info.target != addr + info.size) {
+				results->callSites.push_back({static_cast<uint32_t>(offset), info.target});
+			}
+			return;
+		}
+
+		if (info.flow != CapstoneEDB::Flow::Call && !is_endbr(p, last)) {
+			return;
+		}
+	}
+#endif
+
+	if (auto inst = edb::Instruction(p, last, addr)) {
+		if (is_call(inst)) {
+
+			// note the destination and move on
+			// we special case some simple things.
+			// also this is an opportunity to find call tables.
+			const edb::Operand op = inst[0];
+			if (is_immediate(op)) {
+				const edb::address_t ea = op->imm;
+
+				// skip over ones which are: "call <label>; label:"
+				if (ea != addr + inst.byteSize()) {
+					results->callSites.push_back({static_cast<uint32_t>(offset), ea});
+				}
+			}
+#if defined(EDB_X86) || defined(EDB_X86_64)
+#if CS_API_MAJOR >= 4
+		} else if (inst->id == X86_INS_ENDBR64 || inst->id == X86_INS_ENDBR32) {
+
+			// Intel's CET stuff actually helps us identify functions pretty easily
+			results->landingPads.insert(addr);
+#endif
+#endif
+		}
+	}
+}
+
+}
@@ -0,0 +1,101 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FUZZY_SCANNER_H_20240301_
+#define FUZZY_SCANNER_H_20240301_
+
+#include "Types.h"
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace AnalyzerPlugin {
+
+// what a fuzzy scan of a region found
+struct FuzzyScanResults {
+	struct CallSite {
+		uint32_t offset = 0; // from the start of the region
+		edb::address_t target;
+	};
+
+	// every direct call, in order of their offset
+	QVector<CallSite> callSites;
+
+	// how often each address is the target of one of them
+	QHash<edb::address_t, int> callTargets;
+
+	// the addresses of endbr32/endbr64 instructions
+	QSet<edb::address_t> landingPads;
+};
+
+// Looks at every byte offset of a copy of a region for direct calls and
+// endbr32/endbr64, which is what the fuzzy function detection is based on.
+//
+// On x86 only the offsets near a byte which can start one of those (e8, f3
+// and 9a for 32-bit code) are decoded at all, and those bytes are found 16 at
+// a time with SSE2. The region is split into one chunk per thread, and the
+// results of the chunks are merged at the end.
+//
+// When only some pages of the region changed since the last scan, update()
+// takes the results of that one and only scans around the changed pages.
+class FuzzyScanner {
+public:
+	using Range = std::pair<std::size_t, std::size_t>;
+
+public:
+	FuzzyScanner(edb::address_t base, const QVector<uint8_t> &memory, const std::atomic<bool> &cancelled);
+	FuzzyScanner(const FuzzyScanner &)            = delete;
+	FuzzyScanner &operator=(const FuzzyScanner &) = delete;
+
+public:
+	void run(unsigned int threadCount);
+	void update(const FuzzyScanResults &previous, const std::vector<Range> &changed, unsigned int threadCount);
+
+public:
+	[[nodiscard]] const FuzzyScanResults &results() const { return results_; }
+	[[nodiscard]] const QHash<edb::address_t, int> &callTargets() const { return results_.callTargets; }
+	[[nodiscard]] const QSet<edb::address_t> &landingPads() const { return results_.landingPads; }
+
+private:
+	struct Results {
+		std::vector<FuzzyScanResults::CallSite> callSites;
+		QSet<edb::address_t> landingPads;
+	};
+
+private:
+	void scanRanges(const std::vector<Range> &ranges, unsigned int threadCount);
+	void scan(std::size_t begin, std::size_t end, Results *results) const;
+	void check(std::size_t offset, Results *results) const;
+
+private:
+	edb::address_t base_;
+	const QVector<uint8_t> &memory_;
+	const std::atomic<bool> &cancelled_;
+
+	FuzzyScanResults results_;
+};
+
+}
+
+#endif
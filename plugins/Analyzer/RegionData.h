@@ -0,0 +1,65 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REGION_DATA_H_20240301_
+#define REGION_DATA_H_20240301_
+
+#include "BasicBlock.h"
+#include "IAnalyzer.h"
+#include "IRegion.h"
+#include "Types.h"
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include <memory>
+#include <utility>
+
+namespace AnalyzerPlugin {
+
+struct FuzzyScanResults;
+
+// the results of the analysis of one region
+struct RegionData {
+	QSet<edb::address_t> knownFunctions;
+	QSet<edb::address_t> fuzzyFunctions;
+
+	IAnalyzer::FunctionMap functions;
+	QHash<edb::address_t, BasicBlock> basicBlocks;
+
+	// every reference out of the basic blocks as (target, source), sorted so
+	// the ones to an address can be found with a binary search. Blocks may
+	// overlap, a reference is in here once for every block which has it
+	QVector<std::pair<edb::address_t, edb::address_t>> references;
+
+	// what the fuzzy scan found, if there was one in this session, so the next
+	// one only has to look at the pages which changed
+	std::shared_ptr<const FuzzyScanResults> fuzzyScan;
+
+	// a hash of every page of the region, to tell which parts of it changed
+	QVector<uint64_t> pageHashes;
+	bool fuzzy = false;
+	std::shared_ptr<IRegion> region;
+
+	// what the basic blocks are made of
+	std::shared_ptr<const InstructionArena> instructions;
+};
+
+}
+
+#endif
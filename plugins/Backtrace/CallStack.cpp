@@ -26,6 +26,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "MemoryRegions.h"
 #include "State.h"
 #include "edb.h"
+#include <array>
+#include <cstring>
+#include <vector>
 
 // TODO: This may be specific to x86... Maybe abstract this in the future.
 
@@ -78,23 +81,56 @@ void CallStack::getCallStack() {
 			constexpr uint8_t CallMinSize = 2;
 			constexpr uint8_t CallMaxSize = 7;
 
-			uint8_t buffer[edb::Instruction::MaxSize];
-			for (edb::address_t addr = rbp; region_rbp->contains(addr); addr += edb::v1::pointer_size()) {
+			// Read the whole stack above rbp at once, and then the bytes preceding
+			// every candidate return address in a single batch, rather than
+			// issuing two reads per stack slot.
+			const std::size_t pointerSize = edb::v1::pointer_size();
 
+			std::vector<uint8_t> stack(region_rbp->end() - rbp);
+			const std::size_t slotCount = process->readBytes(rbp, stack.data(), stack.size()) / pointerSize;
+
+			std::vector<edb::address_t> returnAddresses;
+
+			// a return address points into code, so anything that
+			// doesn't is dropped here. process_vm_readv gives up at the first range
+			// it can't read, so leaving them in would send most of the batch down
+			// the slow path
+			std::shared_ptr<IRegion> region;
+			for (std::size_t slot = 0; slot < slotCount; ++slot) {
 				// Get the stack value so that we can see if it's a pointer
-				bool ok;
-				ExpressionError err;
-				edb::address_t possible_ret = edb::v1::get_value(addr, &ok, &err);
+				edb::address_t possible_ret = 0;
+				std::memcpy(&possible_ret, &stack[slot * pointerSize], pointerSize);
+
+				if (!region || !region->contains(possible_ret)) {
+					region = edb::v1::memory_regions().findRegion(possible_ret);
+				}
+
+				if (region && region->executable()) {
+					returnAddresses.push_back(possible_ret);
+				}
+			}
+
+			using Buffer = std::array<uint8_t, edb::Instruction::MaxSize>;
+			std::vector<Buffer> buffers(returnAddresses.size());
+
+			std::vector<IProcess::ReadRequest> requests(returnAddresses.size());
+			for (std::size_t i = 0; i < returnAddresses.size(); ++i) {
+				requests[i] = {returnAddresses[i] - CallMaxSize, buffers[i].data(), buffers[i].size(), 0};
+			}
+
+			process->readBytesV(requests.data(), requests.size());
 
-				if (process->readBytes(possible_ret - CallMaxSize, buffer, sizeof(buffer))) { // 0xfffff... if not a ptr.
+			for (std::size_t slot = 0; slot < requests.size(); ++slot) {
+				if (requests[slot].read) { // 0xfffff... if not a ptr.
+					const Buffer &buffer = buffers[slot];
 					for (int i = (CallMaxSize - CallMinSize); i >= 0; --i) {
-						edb::Instruction inst(buffer + i, buffer + sizeof(buffer), 0);
+						edb::Instruction inst(buffer.data() + i, buffer.data() + buffer.size(), 0);
 
 						// If it's a call, then make a frame
 						if (is_call(inst)) {
 							StackFrame frame;
-							frame.ret    = possible_ret;
-							frame.caller = possible_ret - CallMaxSize + i;
+							frame.ret    = returnAddresses[slot];
+							frame.caller = returnAddresses[slot] - CallMaxSize + i;
 							stackFrames_.push_back(frame);
 							break;
 						}
@@ -158,7 +158,7 @@ void BookmarkWidget::addConditionalBreakpoint() {
 		if (ok) {
 			if (std::shared_ptr<IBreakpoint> bp = edb::v1::create_breakpoint(item->address)) {
 				if (!condition.isEmpty()) {
-					bp->condition = condition;
+					bp->setCondition(condition);
 				}
 			}
 		}
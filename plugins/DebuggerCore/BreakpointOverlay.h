@@ -0,0 +1,89 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BREAKPOINT_OVERLAY_H_20260301_
+#define BREAKPOINT_OVERLAY_H_20260301_
+
+#include "IBreakpoint.h"
+#include "Types.h"
+#include <QMap>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace DebuggerCorePlugin {
+
+// the software breakpoints ordered by address, so that the ones overlapping a
+// range can be found without visiting all of them
+using BreakpointIndex = QMap<edb::address_t, std::shared_ptr<IBreakpoint>>;
+
+/**
+ * @brief breakpoints_overlapping
+ * @param index
+ * @param address
+ * @param len
+ * @param maxSize the largest number of bytes any breakpoint occupies
+ * @return a [first, last) range of <index> holding every breakpoint which
+ * may overlap the <len> bytes at <address>
+ */
+inline std::pair<BreakpointIndex::const_iterator, BreakpointIndex::const_iterator> breakpoints_overlapping(const BreakpointIndex &index, edb::address_t address, std::size_t len, std::size_t maxSize) {
+
+	const edb::address_t first = (address >= maxSize) ? address - (maxSize - 1) : edb::address_t(0);
+	const edb::address_t last  = address + len;
+
+	auto begin = index.lowerBound(first);
+
+	// a range ending at the top of the address space wraps around to 0
+	if (last < address) {
+		return {begin, index.cend()};
+	}
+
+	return {begin, index.lowerBound(last)};
+}
+
+/**
+ * replaces the bytes of the breakpoints in <range> found in the <len> bytes of
+ * <buf> (which were read from <address>) with the original bytes that they
+ * replaced
+ *
+ * @brief restore_breakpoint_bytes
+ * @param range
+ * @param address
+ * @param buf
+ * @param len
+ */
+inline void restore_breakpoint_bytes(const std::pair<BreakpointIndex::const_iterator, BreakpointIndex::const_iterator> &range, edb::address_t address, void *buf, std::size_t len) {
+
+	auto ptr = reinterpret_cast<uint8_t *>(buf);
+
+	for (auto it = range.first; it != range.second; ++it) {
+		const std::shared_ptr<IBreakpoint> &bp = it.value();
+		auto bpBytes                           = bp->originalBytes();
+		const edb::address_t bpAddr            = bp->address();
+		// show the original bytes in the buffer..
+		for (size_t i = 0; i < bp->size(); ++i) {
+			if (bpAddr + i >= address && bpAddr + i < address + len) {
+				ptr[bpAddr + i - address] = bpBytes[i];
+			}
+		}
+	}
+}
+
+}
+
+#endif
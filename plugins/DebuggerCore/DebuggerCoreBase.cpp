@@ -19,6 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DebuggerCoreBase.h"
 #include "Breakpoint.h"
 #include "Configuration.h"
+#include "IProcess.h"
+#include "InstructionCache.h"
 #include "edb.h"
 #include <QtDebug>
 
@@ -31,6 +33,7 @@ namespace DebuggerCorePlugin {
  */
 void DebuggerCoreBase::clearBreakpoints() {
 	if (attached()) {
+		breakpointIndex_.clear();
 		breakpoints_.clear();
 	}
 }
@@ -50,8 +53,10 @@ std::shared_ptr<IBreakpoint> DebuggerCoreBase::addBreakpoint(edb::address_t addr
 				return bp;
 			}
 
-			auto bp               = std::make_shared<Breakpoint>(address);
-			breakpoints_[address] = bp;
+			auto bp                   = std::make_shared<Breakpoint>(address);
+			breakpoints_[address]     = bp;
+			breakpointIndex_[address] = bp;
+			edb::v1::instruction_cache().invalidate(address, bp->size());
 			return bp;
 		}
 
@@ -114,7 +119,10 @@ void DebuggerCoreBase::removeBreakpoint(edb::address_t address) {
 	if (attached()) {
 		auto it = breakpoints_.find(address);
 		if (it != breakpoints_.end()) {
+			const size_t size = it.value()->size();
+			breakpointIndex_.remove(address);
 			breakpoints_.erase(it);
+			edb::v1::instruction_cache().invalidate(address, size);
 		}
 	}
 }
@@ -144,6 +152,29 @@ void DebuggerCoreBase::endDebugSession() {
 	}
 }
 
+/**
+ * programs the debug registers of every thread of the process
+ *
+ * @brief DebuggerCoreBase::setDebugRegisters
+ * @param regs
+ * @return the first error encountered, the remaining threads are still updated
+ */
+Status DebuggerCoreBase::setDebugRegisters(const IThread::DebugRegisters &regs) {
+
+	Status result = Status::Ok;
+
+	if (IProcess *process = this->process()) {
+		for (const std::shared_ptr<IThread> &thread : process->threads()) {
+			Status status = thread->setDebugRegisters(regs);
+			if (!status && result) {
+				result = status;
+			}
+		}
+	}
+
+	return result;
+}
+
 /**
  * returns a copy of the BP list, these count as references to the BPs
  * preventing full removal until this list is destructed.
@@ -163,6 +194,20 @@ bool DebuggerCoreBase::attached() const {
 	return process() != nullptr;
 }
 
+/**
+ * finds the breakpoints which may overlap [address, address + len). Since a
+ * breakpoint can start a few bytes before <address>, callers still need to
+ * check each one's bytes against the range.
+ *
+ * @brief DebuggerCoreBase::breakpointsOverlapping
+ * @param address
+ * @param len
+ * @return a [first, last) range of breakpointIndex_
+ */
+auto DebuggerCoreBase::breakpointsOverlapping(edb::address_t address, size_t len) const -> std::pair<BreakpointIndex::const_iterator, BreakpointIndex::const_iterator> {
+	return breakpoints_overlapping(breakpointIndex_, address, len, Breakpoint::MaxSize);
+}
+
 /**
  * @brief DebuggerCoreBase::supportedBreakpointTypes
  * @return
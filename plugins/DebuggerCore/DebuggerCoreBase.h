@@ -19,7 +19,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DEBUGGER_CORE_BASE_H_20090529_
 #define DEBUGGER_CORE_BASE_H_20090529_
 
+#include "BreakpointOverlay.h"
 #include "IDebugger.h"
+#include <utility>
 
 class Status;
 
@@ -46,14 +48,19 @@ public:
 	void clearBreakpoints() override;
 	void removeBreakpoint(edb::address_t address) override;
 	void endDebugSession() override;
+	Status setDebugRegisters(const IThread::DebugRegisters &regs) override;
 
 	[[nodiscard]] std::vector<IBreakpoint::BreakpointType> supportedBreakpointTypes() const override;
 
 protected:
 	[[nodiscard]] bool attached() const;
+	[[nodiscard]] std::pair<BreakpointIndex::const_iterator, BreakpointIndex::const_iterator> breakpointsOverlapping(edb::address_t address, size_t len) const;
 
 protected:
 	BreakpointList breakpoints_;
+
+	// the same breakpoints as breakpoints_, but ordered by address
+	BreakpointIndex breakpointIndex_;
 };
 
 }
@@ -42,6 +42,9 @@ public:
 
 	using Type = util::AbstractEnumData<IBreakpoint::TypeId, TypeId>;
 
+	// the largest number of bytes any breakpoint type occupies
+	static constexpr std::size_t MaxSize = 4;
+
 public:
 	explicit Breakpoint(edb::address_t address);
 	~Breakpoint() override;
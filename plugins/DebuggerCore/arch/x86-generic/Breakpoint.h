@@ -49,6 +49,9 @@ public:
 
 	using Type = util::AbstractEnumData<IBreakpoint::TypeId, TypeId>;
 
+	// the largest number of bytes any breakpoint type occupies
+	static constexpr std::size_t MaxSize = 2;
+
 public:
 	explicit Breakpoint(edb::address_t address);
 	~Breakpoint() override;
@@ -18,7 +18,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DebuggerCore.h"
 #include "Configuration.h"
+#include "DebugEventNotifier.h"
 #include "DialogMemoryAccess.h"
+#include "Expression.h"
 #include "FeatureDetect.h"
 #include "MemoryRegions.h"
 #include "PlatformCommon.h"
@@ -30,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Posix.h"
 #include "State.h"
 #include "Unix.h"
+#include "WaitThread.h"
 #include "edb.h"
 #include "string_hash.h"
 #include "util/Container.h"
@@ -39,6 +42,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDir>
 #include <QSettings>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 
@@ -201,6 +205,10 @@ DebuggerCore::DebuggerCore()
 			settings.setValue("DebuggerCore/warn_on_broken_proc_mem.enabled", dialog->warnNextTime());
 		}
 	}
+
+	eventNotifier_ = new DebugEventNotifier(this);
+	waitThread_    = new WaitThread(eventNotifier_, this);
+	waitThread_->start();
 }
 
 /**
@@ -278,6 +286,7 @@ std::size_t DebuggerCore::pointerSize() const {
  */
 DebuggerCore::~DebuggerCore() {
 	endDebugSession();
+	waitThread_->shutdown();
 }
 
 /**
@@ -318,6 +327,9 @@ Status DebuggerCore::ptraceContinue(edb::tid_t tid, long status) {
 	//               in the first place if we aren't stopped on this TID :-(
 	if (util::contains(waitedThreads_, tid)) {
 		Q_ASSERT(tid != 0);
+		releaseHeldThreads();
+		invalidateMemoryCache();
+		invalidateRegisterCaches();
 		if (ptrace(PTRACE_CONT, tid, 0, status) == -1) {
 			const char *const strError = strerror(errno);
 			qWarning() << "Unable to continue thread" << tid << ": PTRACE_CONT failed:" << strError;
@@ -341,6 +353,10 @@ Status DebuggerCore::ptraceStep(edb::tid_t tid, long status) {
 	//               in the first place if we aren't stopped on this TID :-(
 	if (util::contains(waitedThreads_, tid)) {
 		Q_ASSERT(tid != 0);
+		releaseHeldThreads();
+		holdThreadsForStep(tid);
+		invalidateMemoryCache();
+		invalidateRegisterCaches();
 		if (ptrace(PTRACE_SINGLESTEP, tid, 0, status) == -1) {
 			const char *const strError = strerror(errno);
 			qWarning() << "Unable to step thread" << tid << ": PTRACE_SINGLESTEP failed:" << strError;
@@ -388,6 +404,36 @@ Status DebuggerCore::ptraceGetEventMessage(edb::tid_t tid, unsigned long *messag
 	return Status::Ok;
 }
 
+/**
+ * @brief DebuggerCore::allThreadsStopped
+ * @return true if every thread of the process is currently in the wait list
+ */
+bool DebuggerCore::allThreadsStopped() const {
+	return !threads_.empty() && waitedThreads_.size() == static_cast<std::size_t>(threads_.size());
+}
+
+/**
+ * once any thread gets to run, anything we know about the contents of memory
+ * may be out of date
+ *
+ * @brief DebuggerCore::invalidateMemoryCache
+ */
+void DebuggerCore::invalidateMemoryCache() {
+	if (auto process = static_cast<PlatformProcess *>(process_.get())) {
+		process->invalidateCache();
+	}
+}
+
+/**
+ * starts a new stop generation, the registers which the threads have cached
+ * so far are considered out of date from now on
+ *
+ * @brief DebuggerCore::invalidateRegisterCaches
+ */
+void DebuggerCore::invalidateRegisterCaches() {
+	++stopGeneration_;
+}
+
 /**
  * @brief DebuggerCore::ptraceOptions
  * @return
@@ -430,6 +476,13 @@ void DebuggerCore::handleThreadExit(edb::tid_t tid, int status) {
 
 	threads_.remove(tid);
 	waitedThreads_.erase(tid);
+	waitThread_->unwatch(tid);
+	heldThreads_.erase(std::remove(heldThreads_.begin(), heldThreads_.end(), tid), heldThreads_.end());
+
+	strayEvents_.erase(std::remove_if(strayEvents_.begin(), strayEvents_.end(), [tid](const StrayEvent &event) {
+						   return event.tid == tid;
+					   }),
+					   strayEvents_.end());
 }
 
 /**
@@ -450,6 +503,7 @@ std::shared_ptr<IDebugEvent> DebuggerCore::handleThreadCreate(edb::tid_t tid, in
 		auto new_thread = std::make_shared<PlatformThread>(this, process_, new_tid);
 
 		threads_.insert(new_tid, new_thread);
+		waitThread_->watch(new_tid);
 
 		int thread_status = 0;
 		if (!util::contains(waitedThreads_, new_tid)) {
@@ -470,8 +524,11 @@ std::shared_ptr<IDebugEvent> DebuggerCore::handleThreadCreate(edb::tid_t tid, in
 
 		new_thread->status_ = thread_status;
 
-		// copy the hardware debug registers from the current thread to the new thread
-		if (process_) {
+		// arm the hardware breakpoints in the new thread, if nobody told us what
+		// they should be, copy whatever the current thread has
+		if (debugRegisters_) {
+			new_thread->setDebugRegisters(*debugRegisters_);
+		} else if (process_) {
 			if (auto cur_thread = process_->currentThread()) {
 				auto old_thread = std::static_pointer_cast<PlatformThread>(cur_thread);
 				for (size_t i = 0; i < 8; ++i) {
@@ -535,9 +592,16 @@ std::shared_ptr<IDebugEvent> DebuggerCore::handleEvent(edb::tid_t tid, int statu
 		return nullptr;
 	}
 
+	// conditional breakpoints which shouldn't stop are dealt with right here,
+	// the rest of the debugger never gets to see these events
+	if (skipBreakpoint(tid, *e)) {
+		return nullptr;
+	}
+
 	/* NOTE(eteran): OK, so when we get an event, we generally want to stop
 	 * any other threads as well. So we will call stopThreads() below
-	 * which sends a SIGSTOP.
+	 * which sends a SIGSTOP. (Unless we are in non-stop mode, in which case
+	 * only this thread is halted and the rest are left running.)
 	 *
 	 * We need to be very careful to avoid those future events causing the
 	 * active thread to be set, because we want it to remain set to the thread
@@ -546,8 +610,13 @@ std::shared_ptr<IDebugEvent> DebuggerCore::handleEvent(edb::tid_t tid, int statu
 	 * get signaled, and the rest get resumed properly.
 	 *
 	 * To do this, we simply only alter the activeThread_ variable if this
-	 * event was the first we saw after a resume/run (phew!).*/
-	if (waitedThreads_.size() == 1) {
+	 * event was the first we saw after a resume/run (phew!).
+	 *
+	 * In non-stop mode there are no such follow up events, every event we
+	 * get here is one the user will see, so it always becomes active. */
+	const bool nonStop = edb::v1::config().nonStopMode;
+
+	if (nonStop || waitedThreads_.size() == 1) {
 		activeThread_ = tid;
 	}
 
@@ -556,7 +625,9 @@ std::shared_ptr<IDebugEvent> DebuggerCore::handleEvent(edb::tid_t tid, int statu
 		it.value()->status_ = status;
 	}
 
-	stopThreads();
+	if (!nonStop) {
+		stopThreads();
+	}
 
 	// Some breakpoint types result in SIGILL or SIGSEGV. We'll transform the
 	// event into breakpoint event if such a breakpoint has triggered.
@@ -591,6 +662,177 @@ std::shared_ptr<IDebugEvent> DebuggerCore::handleEvent(edb::tid_t tid, int statu
 	return e;
 }
 
+/**
+ * if <event> is a hit on a conditional breakpoint whose condition is false,
+ * steps the thread past the breakpoint and lets it continue
+ *
+ * @brief DebuggerCore::skipBreakpoint
+ * @param tid
+ * @param event
+ * @return true if the thread was resumed and the event should be dropped
+ */
+bool DebuggerCore::skipBreakpoint(edb::tid_t tid, const PlatformEvent &event) {
+#if defined(EDB_X86) || defined(EDB_X86_64)
+	if (!event.isTrap() || event.trapReason() != IDebugEvent::TRAP_BREAKPOINT) {
+		return false;
+	}
+
+	auto it = threads_.find(tid);
+	if (it == threads_.end()) {
+		return false;
+	}
+
+	const std::shared_ptr<PlatformThread> &thread = it.value();
+
+	// the state object is reused from hit to hit, so that hot
+	// breakpoints don't need to allocate one each time
+	if (!hitState_) {
+		hitState_ = std::make_unique<State>();
+	}
+
+	State &state = *hitState_;
+	thread->getGeneralState(&state);
+
+	const std::shared_ptr<IBreakpoint> bp = findTriggeredBreakpoint(state.instructionPointer());
+
+	// internal and one time breakpoints always need the GUI's
+	// attention, and a condition which doesn't compile is reported there too
+	if (!bp || !bp->enabled() || bp->internal() || bp->oneTime()) {
+		return false;
+	}
+
+	Expression<edb::address_t> *expr = bp->compiledCondition();
+	if (!expr && (!bp->isTracepoint() || !bp->condition().isEmpty())) {
+		return false;
+	}
+
+	// only the general purpose registers have been read so far,
+	// which is all that most conditions look at. The first time something else
+	// is asked for, the rest of the registers are read too. The debug
+	// registers need asking for up front, they read as zero until then
+	bool full_state       = false;
+	auto fetch_full_state = [&]() {
+		if (!full_state) {
+			thread->getState(&state);
+			state.setInstructionPointer(bp->address());
+			full_state = true;
+		}
+	};
+
+	// the registers bound when the condition was compiled are read straight
+	// out of the state, only anything else is looked up by name. Both lambdas
+	// capture little enough to fit into a std::function without it allocating,
+	// this runs on every hit
+	auto bound_reader = [&state](int index, bool *ok, ExpressionError *err) {
+		return edb::v1::get_bound_state_variable(state, index, ok, err);
+	};
+
+	auto variable_reader = [&state, &fetch_full_state](const QString &name, bool *ok, ExpressionError *err) {
+		if (name.size() == 3 && name.startsWith(QLatin1String("dr"), Qt::CaseInsensitive)) {
+			fetch_full_state();
+		}
+
+		edb::address_t value = edb::v1::get_state_variable(state, name, ok, err);
+		if (!*ok) {
+			fetch_full_state();
+			value = edb::v1::get_state_variable(state, name, ok, err);
+		}
+
+		return value;
+	};
+
+	// the same as what the GUI would see, IP at the breakpoint itself
+	const edb::address_t trap_address = state.instructionPointer();
+	state.setInstructionPointer(bp->address());
+
+	bool condition_true = true;
+	if (expr) {
+		const Result<edb::address_t, ExpressionError> condition_value = expr->evaluate(variable_reader, edb::v1::get_value, bound_reader);
+		if (!condition_value) {
+			return false;
+		}
+
+		condition_true = *condition_value;
+	}
+
+	if (bp->isTracepoint()) {
+		// tracepoints never stop, they just take note of what they saw
+		if (condition_true) {
+			fetch_full_state();
+			edb::v1::record_tracepoint(*bp, tid, state);
+		}
+	} else if (condition_true) {
+		return false;
+	}
+
+	bp->hit();
+	thread->setGeneralState(state);
+
+	// the breakpoint is lifted for the whole process during the
+	// step, so any other thread which is running could pass through it without
+	// trapping. Those are stopped first and let go again once it is back, the
+	// same as when the GUI steps over a breakpoint with everything stopped
+	std::vector<edb::tid_t> stopped;
+	for (auto other = threads_.begin(); other != threads_.end(); ++other) {
+		if (other.key() != tid && !util::contains(waitedThreads_, other.key())) {
+			stopped.push_back(other.key());
+		}
+	}
+
+	if (!stopped.empty()) {
+		stopThreads();
+	}
+
+	auto resume_stopped = [this, &stopped]() {
+		for (const edb::tid_t other : stopped) {
+			auto other_thread = threads_.find(other);
+			if (other_thread != threads_.end() && util::contains(waitedThreads_, other) && !hasStrayEvent(other)) {
+				other_thread.value()->resume();
+			}
+		}
+	};
+
+	// step over the original instruction and put the breakpoint right back
+	bp->disable();
+
+	int step_status = 0;
+	if (ptraceStep(tid, 0) && Posix::waitpid(tid, &step_status, __WALL) > 0) {
+		waitedThreads_.insert(tid);
+		thread->status_ = step_status;
+		bp->enable();
+
+		if (WIFSTOPPED(step_status) && WSTOPSIG(step_status) == SIGTRAP) {
+			ptraceContinue(tid, 0);
+		} else {
+			// something else happened to the thread during the step, that's
+			// for the regular event path to deal with
+			strayEvents_.push_back({tid, step_status});
+		}
+
+		resume_stopped();
+		deliverStrayEvents();
+		return true;
+	}
+
+	bp->enable();
+	resume_stopped();
+	deliverStrayEvents();
+
+	if (util::contains(waitedThreads_, tid)) {
+		// the step never started, so let the regular event path have it
+		state.setInstructionPointer(trap_address);
+		thread->setGeneralState(state);
+		return false;
+	}
+
+	return true;
+#else
+	Q_UNUSED(tid)
+	Q_UNUSED(event)
+	return false;
+#endif
+}
+
 /**
  * @brief DebuggerCore::stopThreads
  * @return
@@ -600,33 +842,53 @@ Status DebuggerCore::stopThreads() {
 	QString errorMessage;
 
 	if (process_) {
+
+		// first send SIGSTOP to every thread which is still
+		// running, and only then collect the stops. This way all of the
+		// threads are stopping at the same time instead of one round trip
+		// after another.
+		std::vector<edb::tid_t> stopping;
+
 		for (auto &thread : process_->threads()) {
 			const edb::tid_t tid = thread->tid();
 
 			if (!util::contains(waitedThreads_, tid)) {
+				if (syscall(SYS_tgkill, process_->pid(), tid, SIGSTOP) == -1) {
+					const char *const error = strerror(errno);
+					errorMessage += tr("Failed to stop thread %1: %2\n").arg(tid).arg(error);
+				} else {
+					stopping.push_back(tid);
+				}
+			}
+		}
 
-				if (auto thread_ptr = std::static_pointer_cast<PlatformThread>(thread)) {
+		// we deliberately don't use waitpid(-1) here, it would
+		// also reap children which aren't debuggee threads at all (such as
+		// the terminal we launched). Since every thread has already been
+		// signaled, these waits complete back to back anyway.
+		for (const edb::tid_t tid : stopping) {
 
-					if (syscall(SYS_tgkill, process_->pid(), thread->tid(), SIGSTOP) == -1) {
-						const char *const error = strerror(errno);
-						errorMessage += tr("Failed to stop thread %1: %2\n").arg(tid).arg(error);
-					}
+			int thread_status;
+			if (Posix::waitpid(tid, &thread_status, __WALL) > 0) {
+				waitedThreads_.insert(tid);
 
-					int thread_status;
-					if (Posix::waitpid(thread->tid(), &thread_status, __WALL /* | WNOHANG*/) > 0) {
-						waitedThreads_.insert(tid);
-						thread_ptr->status_ = thread_status;
+				// A thread could have exited between previous waitpid and the latest one...
+				if (WIFEXITED(thread_status)) {
+					handleThreadExit(tid, thread_status);
+					continue;
+				}
 
-						// A thread could have exited between previous waitpid and the latest one...
-						if (WIFEXITED(thread_status)) {
-							handleThreadExit(tid, thread_status);
-						}
+				auto it = threads_.find(tid);
+				if (it != threads_.end()) {
+					it.value()->status_ = thread_status;
+				}
 
-						// ..., otherwise it must have stopped.
-						else if (!WIFSTOPPED(thread_status) || WSTOPSIG(thread_status) != SIGSTOP) {
-							qWarning("stop_threads(): paused thread [%d] received an event besides SIGSTOP: status=0x%x", tid, thread_status);
-						}
-					}
+				// ..., otherwise it should have stopped because of our SIGSTOP. If it
+				// stopped for some other reason first, hold on to that event so that
+				// it can be reported once the current one has been dealt with.
+				if (WIFSTOPPED(thread_status) && WSTOPSIG(thread_status) != SIGSTOP) {
+					qDebug("stop_threads(): paused thread [%d] received an event besides SIGSTOP: status=0x%x, deferring it", tid, thread_status);
+					strayEvents_.push_back({tid, thread_status});
 				}
 			}
 		}
@@ -640,6 +902,93 @@ Status DebuggerCore::stopThreads() {
 	return Status("\n" + errorMessage);
 }
 
+/**
+ * stepping over a breakpoint means lifting it for the whole process for the
+ * duration of the step. In non-stop mode the other threads are still running
+ * at that point and could pass through it without trapping, so they are
+ * stopped until the next time a thread is let go, by which point the
+ * breakpoint has been put back
+ *
+ * @brief DebuggerCore::holdThreadsForStep
+ * @param tid the thread about to be stepped
+ */
+void DebuggerCore::holdThreadsForStep(edb::tid_t tid) {
+
+	if (!edb::v1::config().nonStopMode || !process_) {
+		return;
+	}
+
+	auto it = threads_.find(tid);
+	if (it == threads_.end()) {
+		return;
+	}
+
+	const std::shared_ptr<IBreakpoint> bp = findBreakpoint(it.value()->instructionPointer());
+	if (!bp || bp->enabled()) {
+		return;
+	}
+
+	for (auto other = threads_.begin(); other != threads_.end(); ++other) {
+		if (!util::contains(waitedThreads_, other.key())) {
+			heldThreads_.push_back(other.key());
+		}
+	}
+
+	if (!heldThreads_.empty()) {
+		stopThreads();
+	}
+}
+
+/**
+ * lets go of the threads which holdThreadsForStep() stopped
+ *
+ * @brief DebuggerCore::releaseHeldThreads
+ */
+void DebuggerCore::releaseHeldThreads() {
+
+	if (heldThreads_.empty()) {
+		return;
+	}
+
+	// resuming them comes back through here, so the list has
+	// to be out of the way first
+	std::vector<edb::tid_t> held;
+	held.swap(heldThreads_);
+
+	for (const edb::tid_t tid : held) {
+		auto it = threads_.find(tid);
+		if (it != threads_.end() && util::contains(waitedThreads_, tid) && !hasStrayEvent(tid)) {
+			it.value()->resume();
+		}
+	}
+
+	deliverStrayEvents();
+}
+
+/**
+ * @brief DebuggerCore::hasStrayEvent
+ * @param tid
+ * @return true if an event for <tid> was collected by stopThreads() and is
+ * yet to be reported
+ */
+bool DebuggerCore::hasStrayEvent(edb::tid_t tid) const {
+	return std::any_of(strayEvents_.begin(), strayEvents_.end(), [tid](const StrayEvent &event) {
+		return event.tid == tid;
+	});
+}
+
+/**
+ * makes sure that any events which stopThreads() held back get reported,
+ * called once the user lets the process continue
+ *
+ * @brief DebuggerCore::deliverStrayEvents
+ */
+void DebuggerCore::deliverStrayEvents() {
+	if (!strayEvents_.empty()) {
+		QMetaObject::invokeMethod(eventNotifier_, "debugEventPending", Qt::QueuedConnection);
+	}
+}
+
 /**
  * waits for a debug event, witha timeout specified in milliseconds
  *
@@ -649,20 +998,86 @@ Status DebuggerCore::stopThreads() {
  */
 std::shared_ptr<IDebugEvent> DebuggerCore::waitDebugEvent(std::chrono::milliseconds msecs) {
 
+	// when the wait thread is doing the waiting for us, we only
+	// get called once it has seen something, so there is no need to sleep
+	if (waitThread_->isRunning()) {
+		std::shared_ptr<IDebugEvent> e = collectDebugEvent(waitThread_->pendingTid());
+		waitThread_->acknowledge();
+		return e;
+	}
+
+	if (process_) {
+		if (!strayEvents_.empty() || !Posix::wait_for_sigchld(msecs)) {
+			return collectDebugEvent(0);
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * collects a pending event (if any) without blocking, looking at <hint> first
+ *
+ * @brief DebuggerCore::collectDebugEvent
+ * @param hint the thread most likely to have an event waiting
+ * @return nullptr if there was no event
+ */
+std::shared_ptr<IDebugEvent> DebuggerCore::collectDebugEvent(edb::tid_t hint) {
+
 	if (process_) {
-		if (!Posix::wait_for_sigchld(msecs)) {
-			for (auto &thread : process_->threads()) {
-				int status;
-				const edb::tid_t tid = Posix::waitpid(thread->tid(), &status, __WALL | WNOHANG);
-				if (tid > 0) {
-					return handleEvent(tid, status);
+
+		// events which stopThreads() held back go first, that thread has
+		// been sitting stopped since then
+		while (!strayEvents_.empty()) {
+			const StrayEvent event = strayEvents_.front();
+			strayEvents_.pop_front();
+			if (threads_.contains(event.tid)) {
+				if (std::shared_ptr<IDebugEvent> e = handleEvent(event.tid, event.status)) {
+					return e;
 				}
 			}
 		}
+
+		int status;
+
+		if (threads_.contains(hint)) {
+			const edb::tid_t tid = Posix::waitpid(hint, &status, __WALL | WNOHANG);
+			if (tid > 0) {
+				return handleEvent(tid, status);
+			}
+		}
+
+		for (auto &thread : process_->threads()) {
+			const edb::tid_t tid = Posix::waitpid(thread->tid(), &status, __WALL | WNOHANG);
+			if (tid > 0) {
+				return handleEvent(tid, status);
+			}
+		}
 	}
 	return nullptr;
 }
 
+/**
+ * programs the debug registers of every thread and remembers them, so that
+ * threads created later on get the same hardware breakpoints
+ *
+ * @brief DebuggerCore::setDebugRegisters
+ * @param regs
+ * @return
+ */
+Status DebuggerCore::setDebugRegisters(const IThread::DebugRegisters &regs) {
+	debugRegisters_ = regs;
+	return DebuggerCoreBase::setDebugRegisters(regs);
+}
+
+/**
+ * @brief DebuggerCore::eventNotifier
+ * @return the object which emits debugEventPending() when there is something
+ * for waitDebugEvent() to collect
+ */
+DebugEventNotifier *DebuggerCore::eventNotifier() const {
+	return eventNotifier_;
+}
+
 /**
  * @brief DebuggerCore::attachThread
  * @param tid
@@ -681,6 +1096,7 @@ int DebuggerCore::attachThread(edb::tid_t tid) {
 
 			threads_.insert(tid, newThread);
 			waitedThreads_.insert(tid);
+			waitThread_->watch(tid);
 
 			const long options = ptraceOptions();
 
@@ -746,6 +1162,7 @@ Status DebuggerCore::attach(edb::pid_t pid) {
 	if (!threads_.empty()) {
 		activeThread_ = pid;
 		detectCpuMode();
+		waitThread_->arm();
 		return Status::Ok;
 	}
 
@@ -987,9 +1404,11 @@ Status DebuggerCore::open(const QString &path, const QString &cwd, const QList<Q
 			newThread->status_ = status;
 
 			threads_.insert(pid, newThread);
+			waitThread_->watch(pid);
 
 			activeThread_ = pid;
 			detectCpuMode();
+			waitThread_->arm();
 
 			return Status::Ok;
 		}
@@ -1010,6 +1429,10 @@ DebuggerCore::MeansOfCapture DebuggerCore::lastMeansOfCapture() const {
 void DebuggerCore::reset() {
 	threads_.clear();
 	waitedThreads_.clear();
+	waitThread_->unwatchAll();
+	strayEvents_.clear();
+	heldThreads_.clear();
+	debugRegisters_.reset();
 	activeThread_ = 0;
 }
 
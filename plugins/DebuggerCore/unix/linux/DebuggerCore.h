@@ -23,15 +23,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QHash>
 #include <QObject>
 #include <csignal>
+#include <deque>
+#include <memory>
+#include <optional>
 #include <set>
 #include <unistd.h>
+#include <vector>
 
 class IBinary;
+class State;
 class Status;
 
 namespace DebuggerCorePlugin {
 
 class PlatformThread;
+class WaitThread;
 
 class DebuggerCore final : public DebuggerCoreBase {
 	Q_OBJECT
@@ -60,6 +66,7 @@ public:
 	std::shared_ptr<IDebugEvent> waitDebugEvent(std::chrono::milliseconds msecs) override;
 	void kill() override;
 	void setIgnoredExceptions(const QList<qlonglong> &exceptions) override;
+	Status setDebugRegisters(const IThread::DebugRegisters &regs) override;
 
 public:
 	[[nodiscard]] QMap<qlonglong, QString> exceptions() const override;
@@ -68,6 +75,7 @@ public:
 
 public:
 	[[nodiscard]] edb::pid_t parentPid(edb::pid_t pid) const override;
+	[[nodiscard]] DebugEventNotifier *eventNotifier() const override;
 
 public:
 	[[nodiscard]] std::unique_ptr<IState> createState() const override;
@@ -96,30 +104,51 @@ private:
 	long ptraceTraceme();
 
 private:
+	[[nodiscard]] bool allThreadsStopped() const;
 	[[nodiscard]] long ptraceOptions() const;
 	int attachThread(edb::tid_t tid);
 	Status stopThreads();
+	void holdThreadsForStep(edb::tid_t tid);
+	void releaseHeldThreads();
+	bool skipBreakpoint(edb::tid_t tid, const PlatformEvent &event);
+	[[nodiscard]] bool hasStrayEvent(edb::tid_t tid) const;
+	void deliverStrayEvents();
+	std::shared_ptr<IDebugEvent> collectDebugEvent(edb::tid_t hint);
 	std::shared_ptr<IDebugEvent> handleEvent(edb::tid_t tid, int status);
 	std::shared_ptr<IDebugEvent> handleThreadCreate(edb::tid_t tid, int status);
 	void detectCpuMode();
+	void invalidateMemoryCache();
+	void invalidateRegisterCaches();
 	void handleThreadExit(edb::tid_t tid, int status);
 	void reset();
 
 private:
 	using threads_type = QHash<edb::tid_t, std::shared_ptr<PlatformThread>>;
 
+	struct StrayEvent {
+		edb::tid_t tid;
+		int status;
+	};
+
 private:
 	// TODO(eteran): a few of these logically belong in PlatformProcess...
 	CpuMode cpuMode_                   = CpuMode::Unknown;
 	MeansOfCapture lastMeansOfCapture_ = MeansOfCapture::NeverCaptured;
 	QList<qlonglong> ignoredExceptions_;
 	std::set<edb::tid_t> waitedThreads_;
+	std::deque<StrayEvent> strayEvents_;
+	std::vector<edb::tid_t> heldThreads_;
+	std::unique_ptr<State> hitState_;
+	std::optional<IThread::DebugRegisters> debugRegisters_;
 	edb::tid_t activeThread_;
 	std::shared_ptr<IProcess> process_;
 	threads_type threads_;
 	bool procMemReadBroken_  = true;
 	bool procMemWriteBroken_ = true;
 	std::size_t pointerSize_ = sizeof(void *);
+	DebugEventNotifier *eventNotifier_ = nullptr;
+	WaitThread *waitThread_            = nullptr;
+	uint64_t stopGeneration_ = 1;
 #if defined(EDB_X86) || defined(EDB_X86_64)
 	const bool osIs64Bit_;
 	const edb::seg_reg_t userCodeSegment32_;
@@ -0,0 +1,132 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PageCache.h"
+
+namespace DebuggerCorePlugin {
+
+/**
+ * @brief PageCache::PageCache
+ * @param pageSize - must be a power of two
+ * @param capacity - the maximum number of pages held at once
+ */
+PageCache::PageCache(std::size_t pageSize, std::size_t capacity)
+	: pageSize_(pageSize), capacity_(capacity) {
+	Q_ASSERT(pageSize_ != 0 && (pageSize_ & (pageSize_ - 1)) == 0);
+	Q_ASSERT(capacity_ != 0);
+}
+
+/**
+ * @brief PageCache::find
+ * @param page - the page aligned address to look up
+ * @return the cached contents of the page, or nullptr if it isn't cached
+ */
+const uint8_t *PageCache::find(edb::address_t page) {
+
+	auto it = index_.find(page);
+	if (it == index_.end()) {
+		return nullptr;
+	}
+
+	// mark it as the most recently used
+	entries_.splice(entries_.begin(), entries_, it.value());
+	return it.value()->data.data();
+}
+
+/**
+ * makes room for <page> in the cache, evicting the least recently used page
+ * if necessary. The caller is expected to fill the returned buffer
+ * (of pageSize() bytes), or remove() the page again if it couldn't.
+ *
+ * @brief PageCache::insert
+ * @param page - the page aligned address to insert
+ * @return a buffer for the page's contents
+ */
+uint8_t *PageCache::insert(edb::address_t page) {
+
+	Q_ASSERT((page & (pageSize_ - 1)) == 0);
+
+	auto it = index_.find(page);
+	if (it != index_.end()) {
+		entries_.splice(entries_.begin(), entries_, it.value());
+		return it.value()->data.data();
+	}
+
+	if (static_cast<std::size_t>(index_.size()) >= capacity_) {
+		auto last = std::prev(entries_.end());
+		index_.remove(last->page);
+		free_.splice(free_.begin(), entries_, last);
+	}
+
+	if (free_.empty()) {
+		entries_.push_front(Entry{page, std::vector<uint8_t>(pageSize_)});
+	} else {
+		entries_.splice(entries_.begin(), free_, free_.begin());
+		entries_.front().page = page;
+	}
+
+	index_.insert(page, entries_.begin());
+	return entries_.front().data.data();
+}
+
+/**
+ * @brief PageCache::remove
+ * @param page
+ */
+void PageCache::remove(edb::address_t page) {
+	auto it = index_.find(page);
+	if (it != index_.end()) {
+		free_.splice(free_.begin(), entries_, it.value());
+		index_.erase(it);
+	}
+}
+
+/**
+ * drops every page which overlaps [address, address + len)
+ *
+ * @brief PageCache::invalidate
+ * @param address
+ * @param len
+ */
+void PageCache::invalidate(edb::address_t address, std::size_t len) {
+
+	if (len == 0 || index_.isEmpty()) {
+		return;
+	}
+
+	const edb::address_t first = address & ~(pageSize_ - 1);
+	const edb::address_t last  = (address + len - 1) & ~(pageSize_ - 1);
+
+	for (edb::address_t page = first; page <= last; page += pageSize_) {
+		remove(page);
+
+		// don't loop forever if the range ends at the top of the address space
+		if (page == last) {
+			break;
+		}
+	}
+}
+
+/**
+ * @brief PageCache::clear
+ */
+void PageCache::clear() {
+	free_.splice(free_.begin(), entries_);
+	index_.clear();
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PAGE_CACHE_H_20240301_
+#define PAGE_CACHE_H_20240301_
+
+#include "Types.h"
+#include <QHash>
+#include <cstdint>
+#include <list>
+#include <vector>
+
+namespace DebuggerCorePlugin {
+
+// A small LRU cache of whole pages of debuggee memory. It knows nothing about
+// when its contents become stale, that is up to the owner to decide.
+class PageCache {
+public:
+	PageCache(std::size_t pageSize, std::size_t capacity);
+	~PageCache()                            = default;
+	PageCache(const PageCache &)            = delete;
+	PageCache &operator=(const PageCache &) = delete;
+
+public:
+	[[nodiscard]] const uint8_t *find(edb::address_t page);
+	[[nodiscard]] uint8_t *insert(edb::address_t page);
+	void clear();
+	void invalidate(edb::address_t address, std::size_t len);
+	void remove(edb::address_t page);
+
+public:
+	[[nodiscard]] std::size_t pageSize() const { return pageSize_; }
+
+private:
+	struct Entry {
+		edb::address_t page;
+		std::vector<uint8_t> data;
+	};
+
+	using entry_list = std::list<Entry>;
+
+private:
+	std::size_t pageSize_;
+	std::size_t capacity_;
+	entry_list entries_; // most recently used first
+	entry_list free_;    // recycled entries, so steady state does no allocation
+	QHash<edb::address_t, entry_list::iterator> index_;
+};
+
+}
+
+#endif
@@ -22,8 +22,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "PlatformProcess.h"
 #include "ByteShiftArray.h"
+#include "Configuration.h"
 #include "DebuggerCore.h"
 #include "IBreakpoint.h"
+#include "InstructionCache.h"
 #include "MemoryRegions.h"
 #include "Module.h"
 #include "PlatformCommon.h"
@@ -40,13 +42,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QFile>
 #include <QFileInfo>
 #include <QTextStream>
+#include <climits>
+#include <csignal>
 #include <elf.h>
 #include <fstream>
 #include <linux/limits.h>
 #include <pwd.h>
 #include <sys/mman.h>
 #include <sys/ptrace.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace DebuggerCorePlugin {
@@ -55,6 +61,16 @@ namespace {
 // Used as size of ptrace word
 constexpr size_t WordSize = sizeof(long);
 
+// The maximum number of ranges handed to a single process_vm_readv call
+constexpr size_t IovBatchSize = IOV_MAX;
+
+// How many pages of memory we keep around between resumes
+constexpr size_t PageCacheCapacity = 256;
+
+// Reads larger than this go straight to the process, they would just
+// push everything else out of the cache
+constexpr size_t MaxCachedReadPages = 16;
+
 template <class T>
 void hash_combine(std::size_t &seed, const T &v) {
 	std::hash<T> hasher;
@@ -274,7 +290,7 @@ bool get_program_headers(const IProcess *process, edb::address_t *phdr_memaddr,
  * @param pid
  */
 PlatformProcess::PlatformProcess(DebuggerCore *core, edb::pid_t pid)
-	: core_(core), pid_(pid) {
+	: core_(core), pid_(pid), pageCache_(core->pageSize(), PageCacheCapacity) {
 
 	if (!core_->procMemReadBroken_) {
 		char path[PATH_MAX];
@@ -304,8 +320,6 @@ std::size_t PlatformProcess::readBytes(edb::address_t address, void *buf, std::s
 	// NOTE(eteran): returns the number of bytes read <N>
 	// NOTE(eteran): if the read is short, only the first <N> bytes are defined
 
-	quint64 read = 0;
-
 	Q_ASSERT(buf);
 	Q_ASSERT(core_->process_.get() == this);
 
@@ -322,61 +336,196 @@ std::size_t PlatformProcess::readBytes(edb::address_t address, void *buf, std::s
 				return 1;
 			}
 
-			if (readOnlyMemFile_) {
-				read = readOnlyMemFile_->readAt(ptr, 1, address);
-				if (read == 1) {
-					return 1;
-				}
-				return 0;
-			}
+			return readCached(address, ptr, 1);
+		}
 
-			bool ok;
-			uint8_t x = ptraceReadByte(address, &ok);
-			if (ok) {
-				*ptr = x;
-				return 1;
-			}
-			return 0;
+		const std::size_t read = readCached(address, ptr, len);
+
+		// replace any breakpoints
+		restoreBreakpointBytes(address, ptr, read);
+		return read;
+	}
+
+	return 0;
+}
+
+/**
+ * reads a batch of (possibly discontiguous) ranges, preferring a single
+ * process_vm_readv call per IOV_MAX requests over one syscall per range.
+ * Anything that process_vm_readv can't read (for example pages which are not
+ * readable by the debuggee itself) falls back to the regular path.
+ *
+ * @brief PlatformProcess::readBytesV
+ * @param requests
+ * @param count
+ * @return the total number of bytes read
+ */
+std::size_t PlatformProcess::readBytesV(ReadRequest *requests, std::size_t count) const {
+
+	Q_ASSERT(requests || count == 0);
+	Q_ASSERT(core_->process_.get() == this);
+
+	std::size_t index = 0;
+
+	while (index < count && !processVmReadBroken_) {
+
+		iovec local[IovBatchSize];
+		iovec remote[IovBatchSize];
+
+		std::size_t n = 0;
+		for (; n < IovBatchSize && index + n < count; ++n) {
+			const ReadRequest &request = requests[index + n];
+			local[n].iov_base          = request.buf;
+			local[n].iov_len           = request.len;
+			remote[n].iov_base         = reinterpret_cast<void *>(request.address.toUint());
+			remote[n].iov_len          = request.len;
 		}
 
-		if (readOnlyMemFile_) {
-			read = readOnlyMemFile_->readAt(ptr, len, address);
-			if (read == 0 || read == quint64(-1)) {
-				return 0;
+		const ssize_t ret = ::process_vm_readv(pid_, local, n, remote, n, 0);
+		if (ret == -1) {
+			if (errno == ENOSYS || errno == EPERM) {
+				qDebug() << "[PlatformProcess] process_vm_readv is unavailable, falling back to per range reads";
+				processVmReadBroken_ = true;
+				break;
 			}
-		} else {
-			for (std::size_t index = 0; index < len; ++index) {
 
-				// read a byte, if we failed, we are done
-				bool ok;
-				const uint8_t x = ptraceReadByte(address + index, &ok);
-				if (!ok) {
-					break;
-				}
+			// the very first range failed, let the slow path have a go at it
+			ReadRequest &request = requests[index++];
+			request.read         = readMemory(request.address, request.buf, request.len);
+			continue;
+		}
 
-				// store it
-				static_cast<char *>(buf)[index] = x;
+		// the kernel stops at the first range it can't fully
+		// read, so everything before that point is complete
+		auto remaining = static_cast<std::size_t>(ret);
+		std::size_t i  = 0;
+		for (; i < n && requests[index + i].len <= remaining; ++i) {
+			requests[index + i].read = requests[index + i].len;
+			remaining -= requests[index + i].len;
+		}
 
-				++read;
-			}
+		if (i < n) {
+			ReadRequest &request = requests[index + i];
+			request.read         = std::max(remaining, readMemory(request.address, request.buf, request.len));
+			++i;
 		}
 
-		// replace any breakpoints
-		Q_FOREACH (const std::shared_ptr<IBreakpoint> &bp, core_->breakpoints_) {
-			auto bpBytes                = bp->originalBytes();
-			const edb::address_t bpAddr = bp->address();
-			// show the original bytes in the buffer..
-			for (size_t i = 0; i < bp->size(); ++i) {
-				if (bpAddr + i >= address && bpAddr + i < address + read) {
-					ptr[bpAddr + i - address] = bpBytes[i];
-				}
+		index += i;
+	}
+
+	for (; index < count; ++index) {
+		ReadRequest &request = requests[index];
+		request.read         = (request.len != 0) ? readMemory(request.address, request.buf, request.len) : 0;
+	}
+
+	// replace any breakpoints, once for the whole batch
+	std::size_t total = 0;
+	for (std::size_t i = 0; i < count; ++i) {
+		restoreBreakpointBytes(requests[i].address, requests[i].buf, requests[i].read);
+		total += requests[i].read;
+	}
+
+	return total;
+}
+
+/**
+ * reads <len> bytes of raw process memory, without hiding breakpoints
+ *
+ * @brief PlatformProcess::readMemory
+ * @param address
+ * @param buf
+ * @param len
+ * @return the number of bytes read
+ */
+std::size_t PlatformProcess::readMemory(edb::address_t address, void *buf, std::size_t len) const {
+
+	if (readOnlyMemFile_) {
+		const ssize_t read = readOnlyMemFile_->readAt(buf, len, address);
+		if (read <= 0) {
+			return 0;
+		}
+		return static_cast<std::size_t>(read);
+	}
+
+	return ptraceReadBytes(address, buf, len);
+}
+
+/**
+ * reads <len> bytes of raw process memory through the page cache. While every
+ * thread is stopped, the same pages tend to be read over and over again by
+ * the various views, so we only go to the process once per page per stop.
+ *
+ * @brief PlatformProcess::readCached
+ * @param address
+ * @param buf
+ * @param len
+ * @return the number of bytes read
+ */
+std::size_t PlatformProcess::readCached(edb::address_t address, void *buf, std::size_t len) const {
+
+	const std::size_t pageSize = pageCache_.pageSize();
+
+	// when we are stuck with ptrace, filling a whole page costs
+	// far more than the read itself, so it's not worth it
+	if (!readOnlyMemFile_ || len > MaxCachedReadPages * pageSize || !core_->allThreadsStopped()) {
+		return readMemory(address, buf, len);
+	}
+
+	auto ptr         = static_cast<uint8_t *>(buf);
+	std::size_t read = 0;
+
+	while (read < len) {
+		const edb::address_t current = address + read;
+		const edb::address_t page    = current & ~(pageSize - 1);
+		const std::size_t offset     = current - page;
+		const std::size_t n          = std::min(pageSize - offset, len - read);
+
+		const uint8_t *data = pageCache_.find(page);
+		if (!data) {
+			uint8_t *const entry = pageCache_.insert(page);
+			if (readMemory(page, entry, pageSize) != pageSize) {
+				// only part of this page is readable, so just do it the slow way
+				pageCache_.remove(page);
+				return read + readMemory(current, ptr + read, len - read);
 			}
+			data = entry;
 		}
+
+		std::memcpy(ptr + read, data + offset, n);
+		read += n;
 	}
 
 	return read;
 }
 
+/**
+ * drops everything we've cached about the contents of the process,
+ * needs to be called whenever any thread gets to run again
+ *
+ * @brief PlatformProcess::invalidateCache
+ */
+void PlatformProcess::invalidateCache() {
+	pageCache_.clear();
+}
+
+/**
+ * replaces the bytes of any breakpoints in the <len> bytes of <buf> (which
+ * were read from <address>) with the original bytes that they replaced
+ *
+ * @brief PlatformProcess::restoreBreakpointBytes
+ * @param address
+ * @param buf
+ * @param len
+ */
+void PlatformProcess::restoreBreakpointBytes(edb::address_t address, void *buf, std::size_t len) const {
+
+	if (len == 0) {
+		return;
+	}
+
+	restore_breakpoint_bytes(core_->breakpointsOverlapping(address, len), address, buf, len);
+}
+
 /**
  * same as writeBytes, except that it also records the original data that was
  * found at the address being written to.
@@ -429,6 +578,10 @@ std::size_t PlatformProcess::writeBytes(edb::address_t address, const void *buf,
 	Q_ASSERT(buf);
 	Q_ASSERT(core_->process_.get() == this);
 
+	// this covers patches and breakpoints being enabled/disabled too
+	pageCache_.invalidate(address, len);
+	edb::v1::instruction_cache().invalidate(address, len);
+
 	if (len != 0) {
 		if (readWriteMemFile_) {
 			written = readWriteMemFile_->writeAt(reinterpret_cast<const char *>(buf), len, address);
@@ -436,15 +589,7 @@ std::size_t PlatformProcess::writeBytes(edb::address_t address, const void *buf,
 				return 0;
 			}
 		} else {
-			// TODO write whole words at a time using ptrace_poke.
-			for (std::size_t byteIndex = 0; byteIndex < len; ++byteIndex) {
-				bool ok = false;
-				ptraceWriteByte(address + byteIndex, *(reinterpret_cast<const char *>(buf) + byteIndex), &ok);
-				if (!ok) {
-					return written;
-				}
-				++written;
-			}
+			written = ptraceWriteBytes(address, buf, len);
 		}
 	}
 
@@ -629,83 +774,120 @@ QList<std::shared_ptr<IRegion>> PlatformProcess::regions() const {
 }
 
 /**
- * @brief PlatformProcess::ptraceReadByte
+ * reads <len> bytes starting at <address> a machine word at a time via the
+ * ptrace API.
+ *
+ * @brief PlatformProcess::ptraceReadBytes
  * @param address
- * @param ok
- * @return
+ * @param buf
+ * @param len
+ * @return the number of bytes read
  */
-uint8_t PlatformProcess::ptraceReadByte(edb::address_t address, bool *ok) const {
+std::size_t PlatformProcess::ptraceReadBytes(edb::address_t address, void *buf, std::size_t len) const {
 	// TODO(eteran): assert that we are paused
 
-	Q_ASSERT(ok);
+	Q_ASSERT(buf);
 	Q_ASSERT(core_->process_.get() == this);
 
-	*ok = false;
+	auto ptr         = static_cast<char *>(buf);
+	std::size_t read = 0;
 
-	// if this spot is unreadable, then just return 0xff, otherwise
-	// continue as normal.
+	// we only ever peek at word aligned addresses. Since page
+	// sizes are always a multiple of the word size, an aligned word never
+	// straddles a page boundary, so the next page being unreadable can't make
+	// us fail to read bytes from this one
+	edb::address_t wordAddress = address & ~(WordSize - 1);
+	std::size_t offset         = address - wordAddress;
 
-	// core_->page_size() - 1 will always be 0xf* because pagesizes
-	// are always 0x10*, so the masking works
-	// range of nBytesToNextPage is [1..n] where n=pagesize, and we have to adjust
-	// if nByteToNextPage < wordsize
-	const size_t nBytesToNextPage = core_->pageSize() - (address & (core_->pageSize() - 1));
-
-	// Avoid crossing page boundary, since next page may be unreadable
-	const size_t addressShift = nBytesToNextPage < WordSize ? WordSize - nBytesToNextPage : 0;
-	address -= addressShift;
+	while (read < len) {
+		bool ok;
+		const long word = ptracePeek(wordAddress, &ok);
+		if (!ok) {
+			break;
+		}
 
-	const long value = ptracePeek(address, ok);
+		// We aren't interested in `word` as in number, it's just a buffer, so no endianness magic.
+		const std::size_t n = std::min(WordSize - offset, len - read);
+		std::memcpy(ptr + read, reinterpret_cast<const char *>(&word) + offset, n);
 
-	if (*ok) {
-		uint8_t result;
-		// We aren't interested in `value` as in number, it's just a buffer, so no endianness magic.
-		// Just have to compensate for `addressShift` when reading it.
-		std::memcpy(&result, reinterpret_cast<const char *>(&value) + addressShift, sizeof(result));
-		return result;
+		read += n;
+		wordAddress += WordSize;
+		offset = 0;
 	}
 
-	return 0xff;
+	return read;
 }
 
 /**
- * writes a single byte at a given address via ptrace API.
+ * writes <len> bytes starting at <address> a machine word at a time via the
+ * ptrace API. Words which are only partially covered by the write are read
+ * first, so that the bytes around the write are preserved.
  *
- * @brief PlatformProcess::ptraceWriteByte
+ * @brief PlatformProcess::ptraceWriteBytes
  * @param address
- * @param value
- * @param ok
+ * @param buf
+ * @param len
+ * @return the number of bytes written
  */
-void PlatformProcess::ptraceWriteByte(edb::address_t address, uint8_t value, bool *ok) {
+std::size_t PlatformProcess::ptraceWriteBytes(edb::address_t address, const void *buf, std::size_t len) {
 	// TODO(eteran): assert that we are paused
 	// NOTE(eteran): assumes the this will not trample any breakpoints, must
 	// be handled in calling code!
 
-	Q_ASSERT(ok);
+	Q_ASSERT(buf);
 	Q_ASSERT(core_->process_.get() == this);
 
-	*ok = false;
+	auto ptr            = static_cast<const char *>(buf);
+	std::size_t written = 0;
 
-	// core_->page_size() - 1 will always be 0xf* because pagesizes
-	// are always 0x10*, so the masking works
-	// range of nBytesToNextPage is [1..n] where n=pagesize, and we have to adjust
-	// if nBytesToNextPage < wordsize
-	const size_t nBytesToNextPage = core_->pageSize() - (address & (core_->pageSize() - 1));
+	// see ptraceReadBytes for why we stick to word aligned addresses
+	edb::address_t wordAddress = address & ~(WordSize - 1);
+	std::size_t offset         = address - wordAddress;
 
-	// Avoid crossing page boundary, since next page may be inaccessible
-	const size_t addressShift = nBytesToNextPage < WordSize ? WordSize - nBytesToNextPage : 0;
-	address -= addressShift;
+	while (written < len) {
+		const std::size_t n = std::min(WordSize - offset, len - written);
 
-	long word = ptracePeek(address, ok);
-	if (!*ok) {
-		return;
+		long word = 0;
+		if (n != WordSize) {
+			bool ok;
+			word = ptracePeek(wordAddress, &ok);
+			if (!ok) {
+				break;
+			}
+		}
+
+		std::memcpy(reinterpret_cast<char *>(&word) + offset, ptr + written, n);
+
+		if (!ptracePoke(wordAddress, word)) {
+			break;
+		}
+
+		written += n;
+		wordAddress += WordSize;
+		offset = 0;
 	}
 
-	// We aren't interested in `value` as in number, it's just a buffer, so no endianness magic.
-	// Just have to compensate for `addressShift` when writing it.
-	std::memcpy(reinterpret_cast<char *>(&word) + addressShift, &value, sizeof(value));
+	return written;
+}
+
+/**
+ * ptrace only works on a thread which is stopped, and in non-stop mode that
+ * need not be the main thread, so this picks one which is
+ *
+ * @brief PlatformProcess::ptraceTarget
+ * @return the thread to direct ptrace requests for memory at
+ */
+edb::tid_t PlatformProcess::ptraceTarget() const {
+
+	if (util::contains(core_->waitedThreads_, core_->activeThread_)) {
+		return core_->activeThread_;
+	}
 
-	*ok = ptracePoke(address, word);
+	if (!core_->waitedThreads_.empty()) {
+		return *core_->waitedThreads_.begin();
+	}
+
+	return pid_;
 }
 
 /**
@@ -732,7 +914,7 @@ long PlatformProcess::ptracePeek(edb::address_t address, bool *ok) const {
 	// NOTE: on some Linux systems ptrace prototype has ellipsis instead of third and fourth arguments
 	// Thus we can't just pass address as is on IA32 systems: it'd put 64 bit integer on stack and cause UB
 	auto nativeAddress = reinterpret_cast<const void *>(address.toUint());
-	const long v       = ptrace(PTRACE_PEEKTEXT, pid_, nativeAddress, 0);
+	const long v       = ptrace(PTRACE_PEEKTEXT, ptraceTarget(), nativeAddress, 0);
 	*ok                = set_ok(v);
 	return v;
 }
@@ -755,7 +937,7 @@ bool PlatformProcess::ptracePoke(edb::address_t address, long value) {
 	// NOTE: on some Linux systems ptrace prototype has ellipsis instead of third and fourth arguments
 	// Thus we can't just pass address as is on IA32 systems: it'd put 64 bit integer on stack and cause UB
 	auto nativeAddress = reinterpret_cast<const void *>(address.toUint());
-	return ptrace(PTRACE_POKETEXT, pid_, nativeAddress, value) != -1;
+	return ptrace(PTRACE_POKETEXT, ptraceTarget(), nativeAddress, value) != -1;
 }
 
 /**
@@ -855,6 +1037,16 @@ QList<Module> PlatformProcess::loadedModules() const {
  * @return
  */
 Status PlatformProcess::pause() {
+
+	// in non-stop mode a SIGSTOP to the whole process would
+	// have every thread report a stop of its own, so we just interrupt the
+	// current thread and leave the others be
+	if (edb::v1::config().nonStopMode) {
+		if (syscall(SYS_tgkill, pid_, core_->activeThread_, SIGSTOP) != -1) {
+			return Status::Ok;
+		}
+	}
+
 	// belive it or not, I belive that this is sufficient for all threads.
 	// This is because in the debug event handler, a SIGSTOP is sent
 	// to all threads when any event arrives, so no need to explicitly do
@@ -897,14 +1089,17 @@ Status PlatformProcess::resume(edb::EventStatus status) {
 			}
 
 			// resume the other threads passing the signal they originally reported had
+			// (threads with an event which hasn't been reported yet stay put)
 			for (auto &other_thread : threads()) {
-				if (util::contains(core_->waitedThreads_, other_thread->tid())) {
+				if (util::contains(core_->waitedThreads_, other_thread->tid()) && !core_->hasStrayEvent(other_thread->tid())) {
 					const auto resumeStatus = other_thread->resume();
 					if (!resumeStatus) {
 						errorMessage += tr("Failed to resume thread %1: %2\n").arg(thread->tid()).arg(resumeStatus.error());
 					}
 				}
 			}
+
+			core_->deliverStrayEvents();
 		}
 	}
 
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PLATFORM_PROCESS_H_20150517_
 
 #include "IProcess.h"
+#include "PageCache.h"
 #include "PlatformFile.h"
 #include "Status.h"
 
@@ -31,6 +32,7 @@ class DebuggerCore;
 
 class PlatformProcess final : public IProcess {
 	Q_DECLARE_TR_FUNCTIONS(PlatformProcess)
+	friend class DebuggerCore;
 	friend class PlatformThread;
 
 public:
@@ -75,13 +77,23 @@ public:
 	std::size_t patchBytes(edb::address_t address, const void *buf, size_t len) override;
 	std::size_t readBytes(edb::address_t address, void *buf, size_t len) const override;
 	std::size_t readPages(edb::address_t address, void *buf, size_t count) const override;
+	std::size_t readBytesV(ReadRequest *requests, std::size_t count) const override;
 	[[nodiscard]] QMap<edb::address_t, Patch> patches() const override;
 
 private:
+	void invalidateCache();
+
+private:
+	std::size_t readCached(edb::address_t address, void *buf, std::size_t len) const;
+	std::size_t readMemory(edb::address_t address, void *buf, std::size_t len) const;
+	void restoreBreakpointBytes(edb::address_t address, void *buf, std::size_t len) const;
+
+private:
+	[[nodiscard]] edb::tid_t ptraceTarget() const;
 	bool ptracePoke(edb::address_t address, long value);
 	long ptracePeek(edb::address_t address, bool *ok) const;
-	uint8_t ptraceReadByte(edb::address_t address, bool *ok) const;
-	void ptraceWriteByte(edb::address_t address, uint8_t value, bool *ok);
+	std::size_t ptraceReadBytes(edb::address_t address, void *buf, std::size_t len) const;
+	std::size_t ptraceWriteBytes(edb::address_t address, const void *buf, std::size_t len);
 
 private:
 	DebuggerCore *core_ = nullptr;
@@ -91,6 +103,8 @@ private:
 	QMap<edb::address_t, Patch> patches_;
 	QString input_;
 	QString output_;
+	mutable PageCache pageCache_;
+	mutable bool processVmReadBroken_ = false;
 };
 
 }
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "DebuggerCore.h"
 #include "IProcess.h"
 #include "PlatformCommon.h"
+#include "PlatformState.h"
 #include "util/Container.h"
 
 #include <QDebug>
@@ -43,6 +44,11 @@ PlatformThread::PlatformThread(DebuggerCore *core, std::shared_ptr<IProcess> &pr
 	assert(core);
 }
 
+/**
+ * @brief PlatformThread::~PlatformThread
+ */
+PlatformThread::~PlatformThread() = default;
+
 /**
  * @brief PlatformThread::tid
  * @return
@@ -22,7 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IBreakpoint.h"
 #include "IThread.h"
 #include <QCoreApplication>
+#include <cstdint>
 #include <memory>
+#include <optional>
 
 class IProcess;
 
@@ -37,7 +39,7 @@ class PlatformThread final : public IThread {
 
 public:
 	PlatformThread(DebuggerCore *core, std::shared_ptr<IProcess> &process, edb::tid_t tid);
-	~PlatformThread() override                        = default;
+	~PlatformThread() override;
 	PlatformThread(const PlatformThread &)            = delete;
 	PlatformThread &operator=(const PlatformThread &) = delete;
 
@@ -51,6 +53,9 @@ public:
 public:
 	void getState(State *state) override;
 	void setState(const State &state) override;
+#if defined(EDB_X86) || defined(EDB_X86_64)
+	Status setDebugRegisters(const DebugRegisters &regs) override;
+#endif
 
 public:
 	Status step() override;
@@ -72,6 +77,16 @@ private:
 private:
 	[[nodiscard]] unsigned long getDebugRegister(std::size_t n) const;
 	long setDebugRegister(std::size_t n, unsigned long value) const;
+#if defined(EDB_X86) || defined(EDB_X86_64)
+	[[nodiscard]] PlatformState *cachedState();
+	[[nodiscard]] const PlatformState *cachedState(unsigned int classes) const;
+	bool fetchGeneralRegisters(PlatformState *state);
+	bool fetchFpuRegisters(PlatformState *state);
+	bool fetchDebugRegisters(PlatformState *state);
+	void getGeneralState(State *state);
+	void setGeneralState(const State &state);
+	void storeGeneralRegisters(const PlatformState &state);
+#endif
 
 private:
 	DebuggerCore *core_ = nullptr;
@@ -79,6 +94,25 @@ private:
 	edb::tid_t tid_;
 	int status_ = 0;
 
+#if defined(EDB_X86) || defined(EDB_X86_64)
+private:
+	// register classes which can be fetched (and invalidated) independently
+	enum RegisterClass : unsigned int {
+		GeneralRegisterClass = 0x01,
+		FpuRegisterClass     = 0x02,
+		DebugRegisterClass   = 0x04,
+	};
+
+	// what we know about the registers during the current stop, only the
+	// classes present in cachedClasses_ are meaningful
+	std::unique_ptr<PlatformState> cachedState_;
+	uint64_t cachedGeneration_  = 0;
+	unsigned int cachedClasses_ = 0;
+
+	// what setDebugRegisters() last wrote, nothing but us changes DR0-DR3/DR7
+	std::optional<DebugRegisters> programmedDebugRegisters_;
+#endif
+
 #if defined(EDB_ARM32) || defined(EDB_ARM64)
 private:
 	Status doStep(edb::tid_t tid, long status);
@@ -0,0 +1,344 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "WaitThread.h"
+#include "DebugEventNotifier.h"
+#include <QMutexLocker>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace DebuggerCorePlugin {
+
+namespace {
+
+// written to by the SIGCHLD handler, so that the wait thread can sleep until
+// any child has news instead of polling while one which isn't ours is pending
+int sigchld_pipe[2]               = {-1, -1};
+struct sigaction previous_sigchld = {};
+
+// how often we look again if the pipe couldn't be created
+constexpr int FallbackInterval = 5;
+
+/**
+ * @brief wake_signal
+ * @return the signal we use to knock the wait thread out of waitid()
+ */
+int wake_signal() {
+	return SIGRTMIN;
+}
+
+/**
+ * @brief wake_handler
+ */
+void wake_handler(int) {
+	// intentionally empty, we just want waitid() to fail with EINTR
+}
+
+/**
+ * wakes up waitForWatched() if it is sleeping
+ *
+ * @brief wake_waiter
+ */
+void wake_waiter() {
+	if (sigchld_pipe[1] != -1) {
+		const char ch = 0;
+		// if the pipe is full, there is a wake up pending anyway
+		[[maybe_unused]] const ssize_t n = ::write(sigchld_pipe[1], &ch, 1);
+	}
+}
+
+/**
+ * @brief sigchld_handler
+ * @param sig
+ * @param info
+ * @param context
+ */
+void sigchld_handler(int sig, siginfo_t *info, void *context) {
+
+	const int saved_errno = errno;
+	wake_waiter();
+
+	// whoever had the signal before us (QProcess for one) still gets it
+	if (previous_sigchld.sa_flags & SA_SIGINFO) {
+		if (previous_sigchld.sa_sigaction) {
+			previous_sigchld.sa_sigaction(sig, info, context);
+		}
+	} else if (previous_sigchld.sa_handler != SIG_DFL && previous_sigchld.sa_handler != SIG_IGN) {
+		previous_sigchld.sa_handler(sig);
+	}
+
+	errno = saved_errno;
+}
+
+/**
+ * @brief install_sigchld_handler
+ */
+void install_sigchld_handler() {
+
+	if (sigchld_pipe[0] != -1 || ::pipe2(sigchld_pipe, O_NONBLOCK | O_CLOEXEC) == -1) {
+		return;
+	}
+
+	struct sigaction action = {};
+	action.sa_sigaction     = sigchld_handler;
+	action.sa_flags         = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGCHLD, &action, &previous_sigchld);
+}
+
+/**
+ * with SA_NOCLDSTOP set, the stops of our threads don't raise SIGCHLD at all.
+ * Some SIGCHLD handlers installed after ours (QProcess's for one) ask for it,
+ * and then call ours in turn, so we just take the flag away again
+ *
+ * @brief ensure_stop_notifications
+ */
+void ensure_stop_notifications() {
+
+	struct sigaction current = {};
+	if (sigaction(SIGCHLD, nullptr, &current) == 0 && (current.sa_flags & SA_NOCLDSTOP)) {
+		current.sa_flags &= ~SA_NOCLDSTOP;
+		sigaction(SIGCHLD, &current, nullptr);
+	}
+}
+
+}
+
+/**
+ * @brief WaitThread::WaitThread
+ * @param notifier
+ * @param parent
+ */
+WaitThread::WaitThread(DebugEventNotifier *notifier, QObject *parent)
+	: QThread(parent), notifier_(notifier) {
+
+	// no SA_RESTART, otherwise the kernel would just restart the waitid()
+	// call we are trying to interrupt
+	struct sigaction action = {};
+	action.sa_handler       = wake_handler;
+	sigemptyset(&action.sa_mask);
+	sigaction(wake_signal(), &action, nullptr);
+
+	install_sigchld_handler();
+}
+
+/**
+ * @brief WaitThread::~WaitThread
+ */
+WaitThread::~WaitThread() {
+	shutdown();
+}
+
+/**
+ * @brief WaitThread::pendingTid
+ * @return the thread which the last notification was about
+ */
+edb::tid_t WaitThread::pendingTid() const {
+	return pendingTid_;
+}
+
+/**
+ * called once the event we notified about has been handled, so that we
+ * can go back to waiting for the next one
+ *
+ * @brief WaitThread::acknowledge
+ */
+void WaitThread::acknowledge() {
+	if (waiting_.exchange(false)) {
+		acknowledged_.release();
+	}
+}
+
+/**
+ * lets the thread know that there is (again) a child to wait for
+ *
+ * @brief WaitThread::arm
+ */
+void WaitThread::arm() {
+	QMutexLocker locker(&mutex_);
+	++generation_;
+	armed_.wakeAll();
+	wake_waiter();
+}
+
+/**
+ * @brief WaitThread::watch
+ * @param tid a thread whose events should be reported
+ */
+void WaitThread::watch(edb::tid_t tid) {
+	QMutexLocker locker(&mutex_);
+	watched_.insert(tid);
+
+	// it may have had its first event before it was added
+	wake_waiter();
+}
+
+/**
+ * @brief WaitThread::unwatch
+ * @param tid
+ */
+void WaitThread::unwatch(edb::tid_t tid) {
+	QMutexLocker locker(&mutex_);
+	watched_.remove(tid);
+}
+
+/**
+ * @brief WaitThread::unwatchAll
+ */
+void WaitThread::unwatchAll() {
+	QMutexLocker locker(&mutex_);
+	watched_.clear();
+}
+
+/**
+ * @brief WaitThread::isWatched
+ * @param tid
+ * @return
+ */
+bool WaitThread::isWatched(edb::tid_t tid) {
+	QMutexLocker locker(&mutex_);
+	return watched_.contains(tid);
+}
+
+/**
+ * waits for one of the watched threads to have an event, while <other> (which
+ * isn't ours) has one pending. Since we don't reap anything, waiting on all
+ * children would just report <other> again right away. So we look at our
+ * threads one at a time, and in between sleep until SIGCHLD says that some
+ * child has news, or until its owner has collected <other>
+ *
+ * @brief WaitThread::waitForWatched
+ * @param other
+ * @return the watched thread which has an event, or 0 once <other> doesn't
+ * have one anymore
+ */
+edb::tid_t WaitThread::waitForWatched(edb::tid_t other) {
+
+	ensure_stop_notifications();
+
+	while (!stopping_) {
+
+		// anything that happens after this wakes us up again below
+		char buffer[64];
+		while (sigchld_pipe[0] != -1 && ::read(sigchld_pipe[0], buffer, sizeof(buffer)) > 0) {
+		}
+
+		QSet<edb::tid_t> watched;
+		{
+			QMutexLocker locker(&mutex_);
+			watched = watched_;
+		}
+
+		for (const edb::tid_t tid : watched) {
+			siginfo_t info = {};
+			if (::waitid(P_PID, tid, &info, WEXITED | WSTOPPED | __WALL | WNOWAIT | WNOHANG) == 0 && info.si_pid != 0) {
+				return tid;
+			}
+		}
+
+		siginfo_t info = {};
+		if (::waitid(P_PID, other, &info, WEXITED | WSTOPPED | __WALL | WNOWAIT | WNOHANG) != 0 || info.si_pid == 0) {
+			return 0;
+		}
+
+		// without the pipe there is nothing to sleep on, so we fall back to
+		// looking again every now and then. EINTR just means another look
+		struct pollfd fd = {sigchld_pipe[0], POLLIN, 0};
+		::poll(&fd, 1, sigchld_pipe[0] != -1 ? -1 : FallbackInterval);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief WaitThread::shutdown
+ */
+void WaitThread::shutdown() {
+
+	if (!isRunning()) {
+		return;
+	}
+
+	stopping_ = true;
+
+	{
+		QMutexLocker locker(&mutex_);
+		armed_.wakeAll();
+	}
+
+	acknowledged_.release();
+	wake_waiter();
+
+	// the signal may land just before the thread enters
+	// waitid(), so keep knocking until it notices
+	while (!wait(10)) {
+		pthread_kill(handle_, wake_signal());
+	}
+}
+
+/**
+ * @brief WaitThread::run
+ */
+void WaitThread::run() {
+
+	handle_ = pthread_self();
+
+	while (!stopping_) {
+
+		quint64 generation;
+		{
+			QMutexLocker locker(&mutex_);
+			generation = generation_;
+		}
+
+		siginfo_t info = {};
+
+		// WNOWAIT leaves the event where it is, the GUI thread
+		// will collect it as usual once it hears from us
+		if (::waitid(P_ALL, 0, &info, WEXITED | WSTOPPED | __WALL | WNOWAIT) == -1) {
+
+			if (errno == ECHILD) {
+				// nothing to wait for (yet), sleep until we've been armed again
+				QMutexLocker locker(&mutex_);
+				while (generation_ == generation && !stopping_) {
+					armed_.wait(&mutex_);
+				}
+			}
+
+			continue;
+		}
+
+		edb::tid_t tid = info.si_pid;
+		if (!isWatched(tid)) {
+			tid = waitForWatched(tid);
+			if (tid == 0) {
+				continue;
+			}
+		}
+
+		pendingTid_ = tid;
+		waiting_    = true;
+		Q_EMIT notifier_->debugEventPending();
+		acknowledged_.acquire();
+	}
+}
+
+}
@@ -0,0 +1,79 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WAIT_THREAD_H_20240301_
+#define WAIT_THREAD_H_20240301_
+
+#include "OSTypes.h"
+#include <QMutex>
+#include <QSemaphore>
+#include <QSet>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <pthread.h>
+
+class DebugEventNotifier;
+
+namespace DebuggerCorePlugin {
+
+// Blocks until one of our children has a state change waiting to be
+// collected and then tells the GUI thread about it through <notifier>. It never reaps anything
+// itself (all ptrace and waitpid work stays on the thread which attached),
+// it simply parks until the event has been consumed, and then waits again.
+//
+// Only the threads it was told to watch are reported, the GUI may have
+// children of its own (the terminal for example) which aren't ours to touch.
+class WaitThread final : public QThread {
+	Q_OBJECT
+
+public:
+	explicit WaitThread(DebugEventNotifier *notifier, QObject *parent = nullptr);
+	~WaitThread() override;
+
+public:
+	[[nodiscard]] edb::tid_t pendingTid() const;
+	void acknowledge();
+	void arm();
+	void shutdown();
+	void watch(edb::tid_t tid);
+	void unwatch(edb::tid_t tid);
+	void unwatchAll();
+
+protected:
+	void run() override;
+
+private:
+	[[nodiscard]] bool isWatched(edb::tid_t tid);
+	[[nodiscard]] edb::tid_t waitForWatched(edb::tid_t other);
+
+private:
+	DebugEventNotifier *notifier_;
+	QMutex mutex_;
+	QWaitCondition armed_;
+	QSemaphore acknowledged_;
+	std::atomic<edb::tid_t> pendingTid_{0};
+	std::atomic<bool> stopping_{false};
+	std::atomic<bool> waiting_{false};
+	quint64 generation_ = 0; // bumped by arm(), guarded by mutex_
+	QSet<edb::tid_t> watched_; // guarded by mutex_
+	pthread_t handle_   = {};
+};
+
+}
+
+#endif
@@ -73,6 +73,14 @@ public:
 		return Register();
 	}
 
+	int registerIndex(const QString &reg) const override {
+		return -1;
+	}
+
+	bool registerValue(int index, edb::reg_t *value) const override {
+		return false;
+	}
+
 	void fillFrom(const user_regs &regs);
 	void fillFrom(const user_vfp &regs);
 	void fillStruct(user_regs &regs) const;
@@ -1277,6 +1277,125 @@ Register PlatformState::gpRegister(size_t n) const {
 	return Register();
 }
 
+/**
+ * @brief PlatformState::registerIndex
+ * @param reg
+ * @return an index which registerValue can read <reg> by, -1 if there isn't one
+ */
+int PlatformState::registerIndex(const QString &reg) const {
+
+	const QString regName = reg.toLower();
+
+	auto find = [&regName](const auto &names, RegisterIndexKind kind) {
+		for (size_t i = 0; i < names.size(); ++i) {
+			if (regName == names[i]) {
+				return (kind << 8) | static_cast<int>(i);
+			}
+		}
+		return -1;
+	};
+
+	auto match = [&regName](const char *name, RegisterIndexKind kind) {
+		return (regName == name) ? (kind << 8) : -1;
+	};
+
+	// the same order as value() looks for them in
+	for (const int index : {find(X86::GPReg64Names, GPR64),
+							find(X86::GPReg32Names, GPR32),
+							find(X86::GPReg16Names, GPR16),
+							find(X86::GPReg8LNames, GPR8L),
+							find(X86::GPReg8HNames, GPR8H),
+							match(X86::flags64Name, FLAGS64),
+							match(X86::flags32Name, FLAGS32),
+							match(X86::flags16Name, FLAGS16),
+							match(X86::IP64Name, IP64),
+							match(X86::IP32Name, IP32),
+							match(X86::IP16Name, IP16)}) {
+		if (index != -1) {
+			return index;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief PlatformState::registerValue
+ * @param index
+ * @param value
+ * @return true if the register at <index> has been filled in
+ */
+bool PlatformState::registerValue(int index, edb::reg_t *value) const {
+
+	assert(value);
+
+	// the same checks as value() does
+	if (!x86.gpr32Filled || index < 0) {
+		return false;
+	}
+
+	const auto n = static_cast<size_t>(index & 0xff);
+
+	switch (index >> 8) {
+	case GPR64:
+		if (!x86.gpr64Filled || !is64Bit() || n >= gpr64_count()) {
+			return false;
+		}
+		*value = x86.GPRegs[n];
+		return true;
+	case GPR32:
+		if (n >= gpr_count()) {
+			return false;
+		}
+		*value = x86.GPRegs[n].toUint() & 0xffffffff;
+		return true;
+	case GPR16:
+		if (n >= gpr_count()) {
+			return false;
+		}
+		*value = x86.GPRegs[n].toUint() & 0xffff;
+		return true;
+	case GPR8L:
+		if (n >= gpr_low_addressable_count()) {
+			return false;
+		}
+		*value = x86.GPRegs[n].toUint() & 0xff;
+		return true;
+	case GPR8H:
+		if (n >= gpr_high_addressable_count()) {
+			return false;
+		}
+		*value = (x86.GPRegs[n].toUint() >> 8) & 0xff;
+		return true;
+	case FLAGS64:
+		if (!is64Bit()) {
+			return false;
+		}
+		*value = x86.flags;
+		return true;
+	case FLAGS32:
+		*value = x86.flags.toUint() & 0xffffffff;
+		return true;
+	case FLAGS16:
+		*value = x86.flags.toUint() & 0xffff;
+		return true;
+	case IP64:
+		if (!is64Bit()) {
+			return false;
+		}
+		*value = x86.IP.toUint();
+		return true;
+	case IP32:
+		*value = x86.IP.toUint() & 0xffffffff;
+		return true;
+	case IP16:
+		*value = x86.IP.toUint() & 0xffff;
+		return true;
+	default:
+		return false;
+	}
+}
+
 /**
  * @brief PlatformState::setRegister
  * @param reg
@@ -259,6 +259,8 @@ public:
 
 	[[nodiscard]] Register archRegister(uint64_t type, size_t n) const override;
 	[[nodiscard]] Register gpRegister(size_t n) const override;
+	[[nodiscard]] int registerIndex(const QString &reg) const override;
+	[[nodiscard]] bool registerValue(int index, edb::reg_t *value) const override;
 
 	[[nodiscard]] bool is64Bit() const {
 		return edb::v1::debuggeeIs64Bit();
@@ -324,6 +326,23 @@ public:
 		return is64Bit() ? X86::GPReg64Names : X86::GPReg32Names;
 	}
 
+private:
+	// the kinds of register registerIndex hands out an index for, the index is
+	// the kind shifted left by 8 with the register's number below it
+	enum RegisterIndexKind : int {
+		GPR64 = 1,
+		GPR32,
+		GPR16,
+		GPR8L,
+		GPR8H,
+		IP64,
+		IP32,
+		IP16,
+		FLAGS64,
+		FLAGS32,
+		FLAGS16
+	};
+
 private:
 	[[nodiscard]] Register mmx_register(size_t n) const;
 	[[nodiscard]] Register xmm_register(size_t n) const;
@@ -23,6 +23,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "PlatformState.h"
 #include "State.h"
 #include <QtDebug>
+#include <cerrno>
+#include <cstring>
 
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE /* or _BSD_SOURCE or _SVID_SOURCE */
@@ -157,72 +159,275 @@ bool PlatformThread::fillStateFromSimpleRegs(PlatformState *state) {
 }
 
 /**
+ * @brief PlatformThread::cachedState
+ * @return the register cache for the current stop, if the debuggee has run
+ * since it was last filled, it is emptied first
+ */
+PlatformState *PlatformThread::cachedState() {
+
+	if (!cachedState_) {
+		cachedState_ = std::make_unique<PlatformState>();
+	}
+
+	if (cachedGeneration_ != core_->stopGeneration_) {
+		cachedGeneration_ = core_->stopGeneration_;
+		cachedClasses_    = 0;
+	}
+
+	return cachedState_.get();
+}
+
+/**
+ * @brief PlatformThread::cachedState
+ * @param classes
+ * @return the register cache for the current stop if it holds all of the
+ * requested register classes, nullptr otherwise
+ */
+const PlatformState *PlatformThread::cachedState(unsigned int classes) const {
+
+	if (!cachedState_ || cachedGeneration_ != core_->stopGeneration_) {
+		return nullptr;
+	}
+
+	if ((cachedClasses_ & classes) != classes) {
+		return nullptr;
+	}
+
+	return cachedState_.get();
+}
+
+/**
+ * @brief PlatformThread::fetchGeneralRegisters
+ * @param state
+ * @return true if the general purpose registers were read successfully
+ */
+bool PlatformThread::fetchGeneralRegisters(PlatformState *state) {
+
+	// the debug registers share the X86 block, but are fetched separately
+	const auto dbgRegs = state->x86.dbgRegs;
+	state->x86.clear();
+	state->x86.dbgRegs = dbgRegs;
+
+	if (EDB_IS_64_BIT) {
+		// 64-bit GETREGS call always returns 64-bit state, so use it
+		return fillStateFromSimpleRegs(state);
+	}
+
+	// if EDB is 32 bit, use GETREGSET so that we get 64-bit state for 64-bit debuggee
+	// failing that, try to just get what we can
+	return fillStateFromPrStatus(state) || fillStateFromSimpleRegs(state);
+}
+
+/**
+ * @brief PlatformThread::fetchFpuRegisters
+ * @param state
+ * @return true if the FPU/SSE/AVX registers were read successfully
+ */
+bool PlatformThread::fetchFpuRegisters(PlatformState *state) {
+
+	state->x87.clear();
+	state->avx.clear();
+
+	// First try to get full XSTATE
+	X86XState xstate;
+	struct iovec iov = {&xstate, sizeof(xstate)};
+
+	long status = ptrace(PTRACE_GETREGSET, tid_, NT_X86_XSTATE, &iov);
+
+	if (status != -1 && state->fillFrom(xstate, iov.iov_len)) {
+		return true;
+	}
+
+	// No XSTATE available, get just floating point and SSE registers
+	static bool getFPXRegsSupported = EDB_IS_32_BIT;
+
+	UserFPXRegsStructX86 fpxregs;
+
+	// This should be automatically optimized out on amd64. If not, not a big deal.
+	// Avoiding conditional compilation to facilitate syntax error checking
+	if (getFPXRegsSupported) {
+		getFPXRegsSupported = (ptrace(PTRACE_GETFPXREGS, tid_, 0, &fpxregs) != -1);
+	}
+
+	if (getFPXRegsSupported) {
+		state->fillFrom(fpxregs);
+		return true;
+	}
+
+	// No GETFPXREGS: on x86 this means SSE is not supported
+	//                on x86_64 FPREGS already contain SSE state
+	struct user_fpregs_struct fpregs;
+	status = ptrace(PTRACE_GETFPREGS, tid_, 0, &fpregs);
+
+	if (status != -1) {
+		state->fillFrom(fpregs);
+		return true;
+	}
+
+	perror("PTRACE_GETFPREGS failed");
+	return false;
+}
+
+/**
+ * @brief PlatformThread::fetchDebugRegisters
+ * @param state
+ * @return true if the debug registers were read successfully
+ */
+bool PlatformThread::fetchDebugRegisters(PlatformState *state) {
+
+	bool ok = true;
+
+	for (std::size_t i = 0; i < 8; ++i) {
+
+		// DR4 and DR5 are reserved, the kernel always reports
+		// them as zero, so there is no point in asking
+		if (i == 4 || i == 5) {
+			state->x86.dbgRegs[i] = 0;
+			continue;
+		}
+
+		errno                 = 0;
+		state->x86.dbgRegs[i] = getDebugRegister(i);
+		if (errno) {
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+/**
+ * reads the registers of this thread, each class of registers is only fetched
+ * from the kernel once per stop, repeated calls are served from the cache
+ *
  * @brief PlatformThread::getState
  * @param state
  */
 void PlatformThread::getState(State *state) {
 	// TODO: assert that we are paused
 
-	core_->detectCpuMode();
-
 	if (auto state_impl = static_cast<PlatformState *>(state->impl_.get())) {
 
-		// State must be cleared before filling to zero all presence flags, otherwise something
-		// may remain not updated. Also, this way we'll mark all the unfilled values.
-		state_impl->clear();
+		PlatformState *const cache = cachedState();
 
-		if (EDB_IS_64_BIT) {
-			// 64-bit GETREGS call always returns 64-bit state, so use it
-			fillStateFromSimpleRegs(state_impl);
-		} else if (!fillStateFromPrStatus(state_impl)) {
-			// if EDB is 32 bit, use GETREGSET so that we get 64-bit state for 64-bit debuggee
-			fillStateFromSimpleRegs(state_impl);
-			// failing that, try to just get what we can
+		if (!(cachedClasses_ & GeneralRegisterClass)) {
+			core_->detectCpuMode();
+			if (fetchGeneralRegisters(cache)) {
+				cachedClasses_ |= GeneralRegisterClass;
+			}
 		}
 
-		// First try to get full XSTATE
-		X86XState xstate;
-		struct iovec iov = {&xstate, sizeof(xstate)};
+		if (!(cachedClasses_ & FpuRegisterClass)) {
+			if (fetchFpuRegisters(cache)) {
+				cachedClasses_ |= FpuRegisterClass;
+			}
+		}
 
-		long status = ptrace(PTRACE_GETREGSET, tid_, NT_X86_XSTATE, &iov);
+		if (!(cachedClasses_ & DebugRegisterClass)) {
+			if (fetchDebugRegisters(cache)) {
+				cachedClasses_ |= DebugRegisterClass;
+			}
+		}
 
-		if (status == -1 || !state_impl->fillFrom(xstate, iov.iov_len)) {
+		*state_impl = *cache;
+	}
+}
 
-			// No XSTATE available, get just floating point and SSE registers
-			static bool getFPXRegsSupported = EDB_IS_32_BIT;
+/**
+ * like getState(), but only the general purpose registers are fetched and
+ * filled in, the rest of <state> is left empty. For paths which usually don't
+ * need more than that, such as the conditions of breakpoints
+ *
+ * @brief PlatformThread::getGeneralState
+ * @param state
+ */
+void PlatformThread::getGeneralState(State *state) {
+	// TODO: assert that we are paused
 
-			UserFPXRegsStructX86 fpxregs;
+	if (auto state_impl = static_cast<PlatformState *>(state->impl_.get())) {
+
+		PlatformState *const cache = cachedState();
 
-			// This should be automatically optimized out on amd64. If not, not a big deal.
-			// Avoiding conditional compilation to facilitate syntax error checking
-			if (getFPXRegsSupported) {
-				getFPXRegsSupported = (ptrace(PTRACE_GETFPXREGS, tid_, 0, &fpxregs) != -1);
+		if (!(cachedClasses_ & GeneralRegisterClass)) {
+			core_->detectCpuMode();
+			if (fetchGeneralRegisters(cache)) {
+				cachedClasses_ |= GeneralRegisterClass;
 			}
+		}
 
-			if (getFPXRegsSupported) {
-				state_impl->fillFrom(fpxregs);
-			} else {
-				// No GETFPXREGS: on x86 this means SSE is not supported
-				//                on x86_64 FPREGS already contain SSE state
-				struct user_fpregs_struct fpregs;
-				status = ptrace(PTRACE_GETFPREGS, tid_, 0, &fpregs);
+		state_impl->clear();
+		state_impl->x86 = cache->x86;
 
-				if (status != -1) {
-					state_impl->fillFrom(fpregs);
-				} else {
-					perror("PTRACE_GETFPREGS failed");
-				}
-			}
+		// the debug registers live in the same block, but weren't asked for
+		state_impl->x86.dbgRegs.fill(0);
+	}
+}
+
+/**
+ * writes back just the general purpose registers of <state>, which is all
+ * that getGeneralState() fills in
+ *
+ * @brief PlatformThread::setGeneralState
+ * @param state
+ */
+void PlatformThread::setGeneralState(const State &state) {
+	if (auto state_impl = static_cast<const PlatformState *>(state.impl_.get())) {
+		storeGeneralRegisters(*state_impl);
+	}
+}
+
+/**
+ * @brief PlatformThread::storeGeneralRegisters
+ * @param state
+ */
+void PlatformThread::storeGeneralRegisters(const PlatformState &state) {
+
+	const PlatformState *const cache = cachedState(GeneralRegisterClass);
+	const bool use64BitRegSet        = EDB_IS_32_BIT && state.is64Bit();
+
+	// compares what would actually be handed to the kernel
+	const auto same = [](const PlatformState &lhs, const PlatformState &rhs, auto regs) {
+		auto other = regs;
+		lhs.fillStruct(regs);
+		rhs.fillStruct(other);
+		return std::memcmp(&regs, &other, sizeof(regs)) == 0;
+	};
+
+	if (cache) {
+		if (use64BitRegSet ? same(state, *cache, PrStatus_X86_64()) : same(state, *cache, user_regs_struct())) {
+			return;
 		}
+	}
 
-		// debug registers
-		for (std::size_t i = 0; i < 8; ++i) {
-			state_impl->x86.dbgRegs[i] = getDebugRegister(i);
+	cachedClasses_ &= ~GeneralRegisterClass;
+
+	bool setPrStatusDone = false;
+
+	if (use64BitRegSet) {
+		// Try to set 64-bit state
+		PrStatus_X86_64 prstat64;
+		state.fillStruct(prstat64);
+
+		struct iovec prstat_iov = {&prstat64, sizeof(prstat64)};
+		if (ptrace(PTRACE_SETREGSET, tid_, NT_PRSTATUS, &prstat_iov) != -1) {
+			setPrStatusDone = true;
+		} else {
+			perror("PTRACE_SETREGSET failed");
 		}
 	}
+
+	// Fallback to setting 32-bit set
+	if (!setPrStatusDone) {
+		struct user_regs_struct regs;
+		state.fillStruct(regs);
+		ptrace(PTRACE_SETREGS, tid_, 0, &regs);
+	}
 }
 
 /**
+ * writes the registers of this thread, register classes which are known to
+ * be unchanged since they were read during this stop are not written at all
+ *
  * @brief PlatformThread::setState
  * @param state
  */
@@ -231,33 +436,44 @@ void PlatformThread::setState(const State &state) {
 	// TODO: assert that we are paused
 
 	if (auto state_impl = static_cast<PlatformState *>(state.impl_.get())) {
-		bool setPrStatusDone = false;
-
-		if (EDB_IS_32_BIT && state_impl->is64Bit()) {
-			// Try to set 64-bit state
-			PrStatus_X86_64 prstat64;
-			state_impl->fillStruct(prstat64);
-
-			struct iovec prstat_iov = {&prstat64, sizeof(prstat64)};
-			if (ptrace(PTRACE_SETREGSET, tid_, NT_PRSTATUS, &prstat_iov) != -1) {
-				setPrStatusDone = true;
-			} else {
-				perror("PTRACE_SETREGSET failed");
-			}
-		}
 
-		// Fallback to setting 32-bit set
-		if (!setPrStatusDone) {
-			struct user_regs_struct regs;
-			state_impl->fillStruct(regs);
-			ptrace(PTRACE_SETREGS, tid_, 0, &regs);
-		}
+		// the kernel may sanitize some of what we write (flags,
+		// selectors, DR7...), so anything which is written is dropped from the
+		// cache and gets read back the next time someone asks for it
+		const PlatformState *const cache = cachedState(0);
+
+		const auto cached = [this, cache](RegisterClass registerClass) {
+			return cache && (cachedClasses_ & registerClass);
+		};
+
+		// compares what would actually be handed to the kernel
+		const auto same = [](const PlatformState &lhs, const PlatformState &rhs, auto regs) {
+			auto other = regs;
+			lhs.fillStruct(regs);
+			rhs.fillStruct(other);
+			return std::memcmp(&regs, &other, sizeof(regs)) == 0;
+		};
+
+		storeGeneralRegisters(*state_impl);
 
 		// debug registers
+		const bool dbgCached = cached(DebugRegisterClass);
 		for (std::size_t i = 0; i < 8; ++i) {
-			setDebugRegister(i, state_impl->x86.dbgRegs[i]);
+			if (!dbgCached || state_impl->x86.dbgRegs[i] != cache->x86.dbgRegs[i]) {
+				cachedClasses_ &= ~DebugRegisterClass;
+				programmedDebugRegisters_.reset();
+				setDebugRegister(i, state_impl->x86.dbgRegs[i]);
+			}
 		}
 
+		// the XSTATE image covers everything the FXSAVE/FSAVE
+		// fallbacks below would write, so it is good enough to compare
+		if (cached(FpuRegisterClass) && same(*state_impl, *cache, X86XState())) {
+			return;
+		}
+
+		cachedClasses_ &= ~FpuRegisterClass;
+
 		// hope for the best, adjust for reality
 		static bool xsaveSupported = true;
 
@@ -294,11 +510,83 @@ void PlatformThread::setState(const State &state) {
 	}
 }
 
+/**
+ * writes just DR0-DR3 and DR7, registers which are known to already hold the
+ * requested values are left alone
+ *
+ * @brief PlatformThread::setDebugRegisters
+ * @param regs
+ * @return
+ */
+Status PlatformThread::setDebugRegisters(const DebugRegisters &regs) {
+
+	DebugRegisters current;
+	bool known = false;
+
+	if (const PlatformState *const cache = cachedState(DebugRegisterClass)) {
+		for (std::size_t i = 0; i < 4; ++i) {
+			current.address[i] = cache->x86.dbgRegs[i];
+		}
+		current.control = cache->x86.dbgRegs[7];
+		known           = true;
+	} else if (programmedDebugRegisters_) {
+		current = *programmedDebugRegisters_;
+		known   = true;
+	}
+
+	bool addressChanged[4];
+	bool anyAddressChanged = false;
+	for (std::size_t i = 0; i < 4; ++i) {
+		addressChanged[i] = !known || current.address[i] != regs.address[i];
+		anyAddressChanged |= addressChanged[i];
+	}
+
+	bool controlChanged = !known || current.control != regs.control;
+
+	if (!anyAddressChanged && !controlChanged) {
+		return Status::Ok;
+	}
+
+	cachedClasses_ &= ~DebugRegisterClass;
+	programmedDebugRegisters_.reset();
+
+	const auto failed = [this](std::size_t n) {
+		return Status(tr("Unable to set DR%1 of thread %2: %3").arg(n).arg(tid_).arg(QString::fromLocal8Bit(strerror(errno))));
+	};
+
+	// the kernel checks each address against what DR7 currently
+	// says, so anything enabled is switched off before the addresses move
+	if (anyAddressChanged && (!known || current.control != 0)) {
+		if (setDebugRegister(7, 0) == -1) {
+			return failed(7);
+		}
+		controlChanged = true;
+	}
+
+	for (std::size_t i = 0; i < 4; ++i) {
+		if (addressChanged[i] && setDebugRegister(i, regs.address[i].toUint()) == -1) {
+			return failed(i);
+		}
+	}
+
+	if (controlChanged && setDebugRegister(7, regs.control.toUint()) == -1) {
+		return failed(7);
+	}
+
+	programmedDebugRegisters_ = regs;
+	return Status::Ok;
+}
+
 /**
  * @brief PlatformThread::instructionPointer
  * @return
  */
 edb::address_t PlatformThread::instructionPointer() const {
+
+	if (const PlatformState *const cache = cachedState(GeneralRegisterClass)) {
+		return cache->x86.IP;
+	}
+
 #if defined(EDB_X86)
 	return ptrace(PTRACE_PEEKUSER, tid_, offsetof(UserRegsStructX86, eip), 0);
 #elif defined(EDB_X86_64)
@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "PlatformProcess.h"
+#include "InstructionCache.h"
 #include "PlatformRegion.h"
 #include "PlatformThread.h"
 #include "edb.h"
@@ -359,6 +360,8 @@ std::size_t PlatformProcess::writeBytes(edb::address_t address, const void *buf,
 			return 0;
 		}
 
+		edb::v1::instruction_cache().invalidate(address, len);
+
 		SIZE_T bytes_written = 0;
 		if (WriteProcessMemory(hProcess_, reinterpret_cast<LPVOID>(address.toUint()), buf, len, &bytes_written)) {
 			return bytes_written;
@@ -88,6 +88,14 @@ public:
 		return Register();
 	}
 
+	int registerIndex(const QString &reg) const override {
+		return -1;
+	}
+
+	bool registerValue(int index, edb::reg_t *value) const override {
+		return false;
+	}
+
 	int fpuStackPointer() const override {
 		qDebug("TODO: implement PlatformState::fpu_stack_pointer");
 		return 0;
@@ -121,6 +121,14 @@ void HardwareBreakpoints::setupBreakpoints() {
 			return;
 		}
 
+		// the registers we don't touch keep what the current thread has
+		State state;
+		if (std::shared_ptr<IThread> thread = process->currentThread()) {
+			thread->getState(&state);
+		}
+
+		IThread::DebugRegisters regs;
+
 		const bool enabled =
 			enabled_[Register1]->isChecked() ||
 			enabled_[Register2]->isChecked() ||
@@ -172,33 +180,32 @@ void HardwareBreakpoints::setupBreakpoints() {
 				}
 			}
 
-			for (std::shared_ptr<IThread> &thread : process->threads()) {
-				State state;
-				thread->getState(&state);
-
-				for (int i = 0; i < RegisterCount; ++i) {
-					if (ok[i]) {
-						set_breakpoint_state(
-							&state,
-							i,
-							{enabled_[i]->isChecked(),
-							 addr[i],
-							 types_[i]->currentIndex(),
-							 sizes_[i]->currentIndex()});
-					}
+			for (int i = 0; i < RegisterCount; ++i) {
+				if (ok[i]) {
+					set_breakpoint_state(
+						&state,
+						i,
+						{enabled_[i]->isChecked(),
+						 addr[i],
+						 types_[i]->currentIndex(),
+						 sizes_[i]->currentIndex()});
 				}
-
-				thread->setState(state);
 			}
 
+			regs = debug_registers(state);
 		} else {
+			regs         = debug_registers(state);
+			regs.control = 0;
+		}
 
-			for (std::shared_ptr<IThread> &thread : process->threads()) {
-				State state;
-				thread->getState(&state);
-				state.setDebugRegister(7, 0);
-				thread->setState(state);
-			}
+		// the core writes just DR0-DR3/DR7 of every thread (skipping
+		// the ones which already match) and arms threads created later as well
+		const Status status = edb::v1::debugger_core->setDebugRegisters(regs);
+		if (!status) {
+			QMessageBox::warning(
+				nullptr,
+				tr("Hardware Breakpoints"),
+				tr("Unable to update the hardware breakpoints of every thread: %1").arg(status.error()));
 		}
 	}
 
@@ -183,4 +183,20 @@ void set_breakpoint_state(State *state, int num, const BreakpointState &bp_state
 	}
 }
 
+/**
+ * @brief debug_registers
+ * @param state
+ * @return the DR0-DR3/DR7 values of the given state
+ */
+IThread::DebugRegisters debug_registers(const State &state) {
+
+	IThread::DebugRegisters regs;
+	for (int i = 0; i < RegisterCount; ++i) {
+		regs.address[i] = state.debugRegister(i);
+	}
+
+	regs.control = state.debugRegister(7);
+	return regs;
+}
+
 }
@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef LIB_HARDWARE_BREAKPOINTS_H_20191119_
 #define LIB_HARDWARE_BREAKPOINTS_H_20191119_
 
+#include "IThread.h"
 #include "edb.h"
 
 namespace HardwareBreakpointsPlugin {
@@ -45,6 +46,7 @@ enum BreakpointStatus {
 BreakpointState breakpoint_state(const State *state, int num);
 void set_breakpoint_state(State *state, int num, const BreakpointState &bp_state);
 BreakpointStatus validate_breakpoint(const BreakpointState &bp_state);
+IThread::DebugRegisters debug_registers(const State &state);
 
 }
 
@@ -45,7 +45,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector>
 #include <QtDebug>
 #include <algorithm>
+#include <cstring>
 #include <functional>
+#include <vector>
 
 namespace HeapAnalyzerPlugin {
 namespace {
@@ -280,34 +282,30 @@ void DialogHeap::on_tableView_doubleClicked(const QModelIndex &index) {
  * @brief DialogHeap::processPotentialPointers
  * @param targets
  * @param index
+ * @param data the contents of the block, as read from the process
+ * @param size the number of valid bytes in <data>
  */
-void DialogHeap::processPotentialPointers(const QHash<edb::address_t, edb::address_t> &targets, const QModelIndex &index) {
+void DialogHeap::processPotentialPointers(const QHash<edb::address_t, edb::address_t> &targets, const QModelIndex &index, const uint8_t *data, size_t size) {
 
 	if (auto result = static_cast<ResultViewModel::Result *>(index.internalPointer())) {
 
 		std::vector<edb::address_t> pointers;
 
-		if (IProcess *process = edb::v1::debugger_core->process()) {
-			if (result->dataType == ResultViewModel::Result::Unknown) {
-				edb::address_t pointer(0);
-				edb::address_t block_ptr = block_start(*result);
-				edb::address_t block_end = block_ptr + result->size;
-
-				while (block_ptr < block_end) {
+		if (result->dataType == ResultViewModel::Result::Unknown) {
+			const size_t pointer_size = edb::v1::pointer_size();
 
-					if (process->readBytes(block_ptr, &pointer, edb::v1::pointer_size())) {
-						auto it = targets.find(pointer);
-						if (it != targets.end()) {
-							pointers.push_back(it.value());
-						}
-					}
+			for (size_t offset = 0; offset + pointer_size <= size; offset += pointer_size) {
+				edb::address_t pointer(0);
+				std::memcpy(&pointer, data + offset, pointer_size);
 
-					block_ptr += edb::v1::pointer_size();
+				auto it = targets.find(pointer);
+				if (it != targets.end()) {
+					pointers.push_back(it.value());
 				}
+			}
 
-				if (!pointers.empty()) {
-					model_->setPointerData(index, pointers);
-				}
+			if (!pointers.empty()) {
+				model_->setPointerData(index, pointers);
 			}
 		}
 	}
@@ -318,6 +316,9 @@ void DialogHeap::processPotentialPointers(const QHash<edb::address_t, edb::addre
  */
 void DialogHeap::detectPointers() {
 
+	// how many blocks we read from the process with a single batched read
+	constexpr int BatchSize = 1024;
+
 	qDebug() << "[Heap Analyzer] detecting pointers in heap blocks";
 
 	QHash<edb::address_t, edb::address_t> targets;
@@ -336,9 +337,45 @@ void DialogHeap::detectPointers() {
 	}
 
 	qDebug() << "[Heap Analyzer] linking blocks to target addresses";
-	for (int row = 0; row < model_->rowCount(); ++row) {
-		QModelIndex index = model_->index(row, 0);
-		processPotentialPointers(targets, index);
+	if (IProcess *process = edb::v1::debugger_core->process()) {
+
+		std::vector<QModelIndex> indexes;
+		std::vector<IProcess::ReadRequest> requests;
+		std::vector<size_t> offsets;
+		std::vector<uint8_t> buffer;
+
+		int row = 0;
+		while (row < model_->rowCount()) {
+
+			indexes.clear();
+			requests.clear();
+			offsets.clear();
+			size_t buffer_size = 0;
+
+			for (; row < model_->rowCount() && static_cast<int>(indexes.size()) < BatchSize; ++row) {
+				QModelIndex index = model_->index(row, 0);
+				if (auto result = static_cast<ResultViewModel::Result *>(index.internalPointer())) {
+					if (result->dataType == ResultViewModel::Result::Unknown) {
+						indexes.push_back(index);
+						offsets.push_back(buffer_size);
+						requests.push_back({block_start(*result), nullptr, static_cast<size_t>(result->size), 0});
+						buffer_size += result->size;
+					}
+				}
+			}
+
+			// the buffer may move while growing, so only hand out pointers once it's settled
+			buffer.resize(buffer_size);
+			for (size_t i = 0; i < requests.size(); ++i) {
+				requests[i].buf = buffer.data() + offsets[i];
+			}
+
+			process->readBytesV(requests.data(), requests.size());
+
+			for (size_t i = 0; i < requests.size(); ++i) {
+				processPotentialPointers(targets, indexes[i], buffer.data() + offsets[i], requests[i].read);
+			}
+		}
 	}
 }
 
@@ -43,7 +43,7 @@ private:
 
 private:
 	void detectPointers();
-	void processPotentialPointers(const QHash<edb::address_t, edb::address_t> &targets, const QModelIndex &index);
+	void processPotentialPointers(const QHash<edb::address_t, edb::address_t> &targets, const QModelIndex &index, const uint8_t *data, size_t size);
 	[[nodiscard]] edb::address_t findHeapStartHeuristic(edb::address_t end_address, size_t offset) const;
 	[[nodiscard]] QMap<edb::address_t, const ResultViewModel::Result *> createResultMap() const;
 
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IProcess.h"
 #include "IRegion.h"
 #include "Instruction.h"
+#include "LengthDecoder.h"
 #include "MemoryRegions.h"
 #include "ResultsModel.h"
 #include "edb.h"
@@ -80,6 +81,12 @@ void test_deref_reg_to_ip(DialogResults *resultsDialog, const OpcodeData &data,
 	const uint8_t *p    = data.data();
 	const uint8_t *last = p + sizeof(data);
 
+	// only an indirect call or jump can match, which is cheap to rule out
+	const CapstoneEDB::LengthInfo info = CapstoneEDB::decode_length(p, last, 0);
+	if (info.size != 0 && (info.hasTarget || (info.flow != CapstoneEDB::Flow::Call && info.flow != CapstoneEDB::Flow::Jump))) {
+		return;
+	}
+
 	edb::Instruction inst(p, last, 0);
 
 	if (inst) {
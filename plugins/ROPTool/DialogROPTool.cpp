@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IDebugger.h"
 #include "IProcess.h"
 #include "IRegion.h"
+#include "LengthDecoder.h"
 #include "MemoryRegions.h"
 #include "edb.h"
 #include "util/Math.h"
@@ -282,6 +283,55 @@ bool is_effective_nop(const edb::Instruction &inst) {
 	}
 }
 
+/**
+ * every gadget we look for ends in a ret, a jmp, an int or a syscall, if a
+ * linear sweep of the window finds none of those there is no point in
+ * running capstone over it
+ *
+ * @brief may_contain_gadget
+ * @param p
+ * @param last
+ * @param rva
+ * @return
+ */
+bool may_contain_gadget(const uint8_t *p, const uint8_t *last, uint64_t rva) {
+
+	while (p < last) {
+		const CapstoneEDB::LengthInfo info = CapstoneEDB::decode_length(p, last, rva);
+		switch (info.flow) {
+		case CapstoneEDB::Flow::Return:
+		case CapstoneEDB::Flow::Jump:
+		case CapstoneEDB::Flow::Interrupt:
+		case CapstoneEDB::Flow::Syscall:
+			return true;
+		default:
+			break;
+		}
+
+		std::size_t size = info.size;
+
+		// this is usually an instruction cut short by the end of
+		// the window, which capstone can't decode either
+		if (size == 0) {
+			const edb::Instruction inst(p, last, rva);
+			if (!inst) {
+				return false;
+			}
+
+			if (is_ret(inst) || is_jump(inst) || is_interrupt(inst) || is_syscall(inst) || is_sysenter(inst)) {
+				return true;
+			}
+
+			size = inst.byteSize();
+		}
+
+		p += size;
+		rva += size;
+	}
+
+	return false;
+}
+
 }
 
 /**
@@ -391,6 +441,12 @@ void DialogROPTool::doFind() {
 							const uint8_t *const l = p + bsa.size();
 							edb::address_t rva     = start_address - bsa.size() + 1;
 
+							if (!may_contain_gadget(p, l, rva)) {
+								ui.progressBar->setValue(util::percentage(start_address - orig_start, region->size()));
+								++start_address;
+								continue;
+							}
+
 							InstructionList instruction_list;
 
 							// eat up any NOPs in front...
@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DialogReferences.h"
 #include "IDebugger.h"
+#include "LengthDecoder.h"
 #include "MemoryRegions.h"
 #include "edb.h"
 #include "util/Math.h"
@@ -33,6 +34,37 @@ enum Role {
 	AddressRole = Qt::UserRole + 1
 };
 
+namespace {
+
+/**
+ * @brief may_reference
+ * @param info
+ * @param address
+ * @return false if the instruction described by <info> certainly doesn't
+ * reference <address> through an immediate or a branch target
+ */
+bool may_reference(const CapstoneEDB::LengthInfo &info, edb::address_t address) {
+
+	if (info.size == 0) {
+		return true;
+	}
+
+	if (info.hasTarget && info.target == address) {
+		return true;
+	}
+
+	// capstone may or may not sign extend the immediate, so we only compare
+	// the bits which are actually encoded
+	if (info.immediateSize != 0) {
+		const uint64_t mask = (info.immediateSize >= 8) ? ~uint64_t(0) : (uint64_t(1) << (info.immediateSize * 8)) - 1;
+		return (static_cast<uint64_t>(info.immediate) & mask) == (address.toUint() & mask);
+	}
+
+	return false;
+}
+
+}
+
 /**
  * @brief DialogReferences::DialogReferences
  * @param parent
@@ -112,47 +144,51 @@ void DialogReferences::doFind() {
 							ui.listWidget->addItem(item);
 						}
 
-						edb::Instruction inst(p, pages_end, addr);
+						// capstone is far too slow to run on every byte offset, so
+						// we only ask it about the ones which could possibly mention the address
+						if (may_reference(CapstoneEDB::decode_length(p, pages_end, addr), address)) {
+							edb::Instruction inst(p, pages_end, addr);
+
+							if (inst) {
+								switch (inst.operation()) {
+								case X86_INS_MOV:
+									// instructions of the form: mov [ADDR], 0xNNNNNNNN
+									Q_ASSERT(inst.operandCount() == 2);
 
-						if (inst) {
-							switch (inst.operation()) {
-							case X86_INS_MOV:
-								// instructions of the form: mov [ADDR], 0xNNNNNNNN
-								Q_ASSERT(inst.operandCount() == 2);
+									if (is_expression(inst[0])) {
+										if (is_immediate(inst[1]) && static_cast<edb::address_t>(inst[1]->imm) == address) {
+											auto item = new QListWidgetItem(edb::v1::format_pointer(addr));
+											item->setData(TypeRole, 'C');
+											item->setData(AddressRole, addr.toQVariant());
+											ui.listWidget->addItem(item);
+										}
+									}
 
-								if (is_expression(inst[0])) {
-									if (is_immediate(inst[1]) && static_cast<edb::address_t>(inst[1]->imm) == address) {
+									break;
+								case X86_INS_PUSH:
+									// instructions of the form: push 0xNNNNNNNN
+									Q_ASSERT(inst.operandCount() == 1);
+
+									if (is_immediate(inst[0]) && static_cast<edb::address_t>(inst[0]->imm) == address) {
 										auto item = new QListWidgetItem(edb::v1::format_pointer(addr));
 										item->setData(TypeRole, 'C');
 										item->setData(AddressRole, addr.toQVariant());
 										ui.listWidget->addItem(item);
 									}
-								}
-
-								break;
-							case X86_INS_PUSH:
-								// instructions of the form: push 0xNNNNNNNN
-								Q_ASSERT(inst.operandCount() == 1);
-
-								if (is_immediate(inst[0]) && static_cast<edb::address_t>(inst[0]->imm) == address) {
-									auto item = new QListWidgetItem(edb::v1::format_pointer(addr));
-									item->setData(TypeRole, 'C');
-									item->setData(AddressRole, addr.toQVariant());
-									ui.listWidget->addItem(item);
-								}
-								break;
-							default:
-								if (is_jump(inst) || is_call(inst)) {
-									if (is_immediate(inst[0])) {
-										if (static_cast<edb::address_t>(inst[0]->imm) == address) {
-											auto item = new QListWidgetItem(edb::v1::format_pointer(addr));
-											item->setData(TypeRole, 'C');
-											item->setData(AddressRole, addr.toQVariant());
-											ui.listWidget->addItem(item);
+									break;
+								default:
+									if (is_jump(inst) || is_call(inst)) {
+										if (is_immediate(inst[0])) {
+											if (static_cast<edb::address_t>(inst[0]->imm) == address) {
+												auto item = new QListWidgetItem(edb::v1::format_pointer(addr));
+												item->setData(TypeRole, 'C');
+												item->setData(AddressRole, addr.toQVariant());
+												ui.listWidget->addItem(item);
+											}
 										}
 									}
+									break;
 								}
-								break;
 							}
 						}
 
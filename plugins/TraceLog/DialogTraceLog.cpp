@@ -0,0 +1,251 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DialogTraceLog.h"
+#include "IBreakpoint.h"
+#include "TraceBuffer.h"
+#include "edb.h"
+
+#include <QHeaderView>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace TraceLogPlugin {
+namespace {
+
+// how many records are shown at a time
+constexpr uint64_t PageSize = 256;
+
+// how often the view catches up with new hits while it is visible
+constexpr int RefreshInterval = 500;
+
+}
+
+/**
+ * @brief DialogTraceLog::DialogTraceLog
+ * @param parent
+ * @param f
+ */
+DialogTraceLog::DialogTraceLog(QWidget *parent, Qt::WindowFlags f)
+	: QDialog(parent, f) {
+
+	ui.setupUi(this);
+
+	timer_ = new QTimer(this);
+	timer_->setInterval(RefreshInterval);
+	connect(timer_, &QTimer::timeout, this, &DialogTraceLog::populateTable);
+}
+
+/**
+ * @brief DialogTraceLog::showEvent
+ */
+void DialogTraceLog::showEvent(QShowEvent *) {
+	timer_->start();
+	populateTable();
+	ui.tableWidget->horizontalHeader()->setSectionResizeMode(3, QHeaderView::Stretch);
+}
+
+/**
+ * @brief DialogTraceLog::hideEvent
+ */
+void DialogTraceLog::hideEvent(QHideEvent *) {
+	timer_->stop();
+}
+
+/**
+ * @brief DialogTraceLog::populateTable
+ */
+void DialogTraceLog::populateTable() {
+
+	const TraceBuffer &buffer = edb::v1::trace_buffer();
+
+	const uint64_t first = buffer.first();
+	const uint64_t end   = buffer.end();
+	const uint64_t last  = std::max(first, end > PageSize ? end - PageSize : 0);
+
+	if (followNewest_) {
+		pageStart_ = last;
+	}
+
+	pageStart_ = std::clamp(pageStart_, first, last);
+
+	const uint64_t pageEnd = std::min(pageStart_ + PageSize, end);
+
+	ui.tableWidget->setUpdatesEnabled(false);
+	ui.tableWidget->setRowCount(0);
+
+	TraceBuffer::Record record;
+	for (uint64_t sequence = pageStart_; sequence < pageEnd; ++sequence) {
+
+		// this one got overwritten while we weren't looking
+		if (!buffer.read(sequence, &record)) {
+			continue;
+		}
+
+		QStringList names;
+		if (std::shared_ptr<IBreakpoint> bp = edb::v1::find_breakpoint(record.address)) {
+			names = bp->traceExpressions();
+		}
+
+		QStringList values;
+		for (std::size_t i = 0; i < record.count; ++i) {
+			const QString name  = (static_cast<int>(i) < names.size()) ? names[static_cast<int>(i)] : QStringLiteral("$%1").arg(i + 1);
+			const QString value = record.valid[i] ? edb::v1::format_pointer(record.values[i]) : tr("<error>");
+			values.push_back(QStringLiteral("%1=%2").arg(name, value));
+		}
+
+		const int row = ui.tableWidget->rowCount();
+		ui.tableWidget->insertRow(row);
+
+		auto item = new QTableWidgetItem(edb::v1::format_pointer(record.address));
+		item->setData(Qt::UserRole, record.address.toQVariant());
+
+		ui.tableWidget->setItem(row, 0, new QTableWidgetItem(QString::number(record.sequence)));
+		ui.tableWidget->setItem(row, 1, new QTableWidgetItem(QString::number(record.tid)));
+		ui.tableWidget->setItem(row, 2, item);
+		ui.tableWidget->setItem(row, 3, new QTableWidgetItem(values.join(QStringLiteral(", "))));
+	}
+
+	ui.tableWidget->setUpdatesEnabled(true);
+
+	if (followNewest_) {
+		ui.tableWidget->scrollToBottom();
+	}
+
+	ui.lblRange->setText(tr("Records %1 - %2 of %3 - %4").arg(pageStart_).arg(pageEnd).arg(first).arg(end));
+	ui.btnPrevious->setEnabled(pageStart_ > first);
+	ui.btnNext->setEnabled(pageEnd < end);
+}
+
+/**
+ * asks for an address and what to record there, and makes a tracepoint of it
+ *
+ * @brief DialogTraceLog::on_btnAdd_clicked
+ */
+void DialogTraceLog::on_btnAdd_clicked() {
+
+	if (!edb::v1::debugger_core) {
+		return;
+	}
+
+	const std::optional<edb::address_t> address = edb::v2::get_expression_from_user(tr("Add Tracepoint"), tr("Address:"));
+	if (!address) {
+		return;
+	}
+
+	// tracepoints never stop, so a breakpoint which is already there would
+	// quietly stop being one
+	if (std::shared_ptr<IBreakpoint> existing = edb::v1::find_breakpoint(*address); existing && !existing->isTracepoint()) {
+		if (existing->internal()) {
+			QMessageBox::warning(this, tr("Breakpoint Already In Use"), tr("edb itself uses the breakpoint at this address, it can't be made into a tracepoint."));
+			return;
+		}
+
+		const QMessageBox::StandardButton button = QMessageBox::question(this, tr("Breakpoint Already In Use"), tr("There already is a breakpoint at this address. Making it a tracepoint means it will no longer stop. Do you want to do that?"), QMessageBox::Yes | QMessageBox::Cancel);
+		if (button != QMessageBox::Yes) {
+			return;
+		}
+	}
+
+	bool ok;
+	const QString text = QInputDialog::getText(this,
+											   tr("Add Tracepoint"),
+											   tr("Expressions to record, separated by commas (at most %1):").arg(TraceBuffer::MaxValues),
+											   QLineEdit::Normal,
+											   QString(),
+											   &ok);
+	if (!ok) {
+		return;
+	}
+
+	QStringList expressions;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+	const QStringList list = text.split(",", Qt::SkipEmptyParts);
+#else
+	const QStringList list = text.split(",", QString::SkipEmptyParts);
+#endif
+	for (const QString &expression : list) {
+		expressions.push_back(expression.trimmed());
+	}
+
+	if (expressions.isEmpty()) {
+		return;
+	}
+
+	if (expressions.size() > static_cast<int>(TraceBuffer::MaxValues)) {
+		QMessageBox::warning(this, tr("Too Many Expressions"), tr("Only the first %1 expressions will be recorded.").arg(TraceBuffer::MaxValues));
+	}
+
+	std::shared_ptr<IBreakpoint> bp = edb::v1::find_breakpoint(*address);
+	if (!bp) {
+		bp = edb::v1::create_breakpoint(*address);
+	}
+
+	if (bp) {
+		bp->setTraceExpressions(expressions);
+	}
+}
+
+/**
+ * @brief DialogTraceLog::on_btnClear_clicked
+ */
+void DialogTraceLog::on_btnClear_clicked() {
+	edb::v1::trace_buffer().clear();
+	followNewest_ = true;
+	populateTable();
+}
+
+/**
+ * @brief DialogTraceLog::on_btnPrevious_clicked
+ */
+void DialogTraceLog::on_btnPrevious_clicked() {
+	followNewest_ = false;
+	pageStart_    = pageStart_ > PageSize ? pageStart_ - PageSize : 0;
+	populateTable();
+}
+
+/**
+ * @brief DialogTraceLog::on_btnNext_clicked
+ */
+void DialogTraceLog::on_btnNext_clicked() {
+	const TraceBuffer &buffer = edb::v1::trace_buffer();
+
+	pageStart_ += PageSize;
+
+	// once we page up to the newest records, keep following them
+	followNewest_ = pageStart_ + PageSize >= buffer.end();
+	populateTable();
+}
+
+/**
+ * @brief DialogTraceLog::on_tableWidget_cellDoubleClicked
+ * @param row
+ * @param column
+ */
+void DialogTraceLog::on_tableWidget_cellDoubleClicked(int row, int column) {
+	Q_UNUSED(column)
+
+	if (QTableWidgetItem *item = ui.tableWidget->item(row, 2)) {
+		const edb::address_t address = item->data(Qt::UserRole).toULongLong();
+		edb::v1::jump_to_address(address);
+	}
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DIALOG_TRACE_LOG_H_20240301_
+#define DIALOG_TRACE_LOG_H_20240301_
+
+#include "ui_DialogTraceLog.h"
+#include <QDialog>
+#include <cstdint>
+
+class QTimer;
+
+namespace TraceLogPlugin {
+
+class DialogTraceLog : public QDialog {
+	Q_OBJECT
+
+public:
+	explicit DialogTraceLog(QWidget *parent = nullptr, Qt::WindowFlags f = Qt::WindowFlags());
+	~DialogTraceLog() override = default;
+
+protected:
+	void showEvent(QShowEvent *) override;
+	void hideEvent(QHideEvent *) override;
+
+public Q_SLOTS:
+	void populateTable();
+
+private Q_SLOTS:
+	void on_btnAdd_clicked();
+	void on_btnClear_clicked();
+	void on_btnPrevious_clicked();
+	void on_btnNext_clicked();
+	void on_tableWidget_cellDoubleClicked(int row, int column);
+
+private:
+	Ui::DialogTraceLog ui;
+	QTimer *timer_      = nullptr;
+	uint64_t pageStart_ = 0;
+	bool followNewest_  = true;
+};
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TraceLog.h"
+#include "DialogTraceLog.h"
+#include "edb.h"
+#include <QMenu>
+
+namespace TraceLogPlugin {
+
+/**
+ * @brief TraceLog::TraceLog
+ * @param parent
+ */
+TraceLog::TraceLog(QObject *parent)
+	: QObject(parent) {
+}
+
+/**
+ * @brief TraceLog::~TraceLog
+ */
+TraceLog::~TraceLog() {
+	delete dialog_;
+}
+
+/**
+ * @brief TraceLog::menu
+ * @param parent
+ * @return
+ */
+QMenu *TraceLog::menu(QWidget *parent) {
+
+	Q_ASSERT(parent);
+
+	if (!menu_) {
+		menu_ = new QMenu(tr("TraceLog"), parent);
+		menu_->addAction(tr("&Trace Log"), this, SLOT(showMenu()), QKeySequence(tr("Ctrl+Alt+T")));
+	}
+
+	return menu_;
+}
+
+/**
+ * @brief TraceLog::showMenu
+ */
+void TraceLog::showMenu() {
+
+	if (!dialog_) {
+		dialog_ = new DialogTraceLog(edb::v1::debugger_ui);
+	}
+
+	dialog_->show();
+}
+
+}
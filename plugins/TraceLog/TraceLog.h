@@ -0,0 +1,53 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_LOG_H_20240301_
+#define TRACE_LOG_H_20240301_
+
+#include "IPlugin.h"
+#include <QPointer>
+
+class QMenu;
+class QDialog;
+
+namespace TraceLogPlugin {
+
+class TraceLog : public QObject, public IPlugin {
+	Q_OBJECT
+	Q_INTERFACES(IPlugin)
+	Q_PLUGIN_METADATA(IID "edb.IPlugin/1.0")
+	Q_CLASSINFO("author", "Evan Teran")
+	Q_CLASSINFO("url", "http://www.codef00.com")
+
+public:
+	explicit TraceLog(QObject *parent = nullptr);
+	~TraceLog() override;
+
+public:
+	[[nodiscard]] QMenu *menu(QWidget *parent = nullptr) override;
+
+public Q_SLOTS:
+	void showMenu();
+
+private:
+	QMenu *menu_ = nullptr;
+	QPointer<QDialog> dialog_;
+};
+
+}
+
+#endif
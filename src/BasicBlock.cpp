@@ -22,86 +22,103 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QString>
 #include <QTextStream>
 
-/**
- * @brief BasicBlock::swap
- * @param other
- */
-void BasicBlock::swap(BasicBlock &other) {
-	using std::swap;
-	swap(instructions_, other.instructions_);
-	swap(references_, other.references_);
-}
+#include <algorithm>
 
 /**
- * @brief BasicBlock::push_back
- * @param inst
+ * @brief InstructionArena::InstructionArena
+ * @param base the address which the record offsets are relative to
  */
-void BasicBlock::push_back(const instruction_pointer &inst) {
-	instructions_.push_back(inst);
+InstructionArena::InstructionArena(edb::address_t base)
+	: base_(base) {
 }
 
 /**
- * @brief BasicBlock::begin
- * @return
+ * appends the records of one basic block, this is safe to call from several
+ * threads at once, as long as nobody reads the arena in the meantime
+ *
+ * @brief InstructionArena::append
+ * @param records
+ * @param memory a copy of the memory at base(), the bytes of the instructions
+ * are taken from there
+ * @return the index of the first of the new records
  */
-BasicBlock::const_iterator BasicBlock::begin() const {
-	return instructions_.begin();
-}
+InstructionArena::size_type InstructionArena::append(const std::vector<InstructionRecord> &records, const uint8_t *memory) {
 
-/**
- * @brief BasicBlock::end
- * @return
- */
-BasicBlock::const_iterator BasicBlock::end() const {
-	return instructions_.end();
-}
+	Q_ASSERT(memory || records.empty());
 
-/**
- * @brief BasicBlock::begin
- * @return
- */
-BasicBlock::iterator BasicBlock::begin() {
-	return instructions_.begin();
+	std::lock_guard<std::mutex> lock(mutex_);
+	const size_type first = records_.size();
+
+	for (const InstructionRecord &record : records) {
+		if (records_.size() == first || records_.back().offset + records_.back().size != record.offset) {
+			runs_.emplace_back(static_cast<uint32_t>(records_.size()), static_cast<uint32_t>(bytes_.size()));
+		}
+
+		records_.push_back(record);
+		bytes_.insert(bytes_.end(), memory + record.offset, memory + record.offset + record.size);
+	}
+
+	return first;
 }
 
 /**
- * @brief BasicBlock::end
- * @return
+ * @brief InstructionArena::bytes
+ * @param pos
+ * @return the bytes of the instruction of the record at <pos>
  */
-BasicBlock::iterator BasicBlock::end() {
-	return instructions_.end();
+const uint8_t *InstructionArena::bytes(size_type pos) const {
+
+	Q_ASSERT(pos < records_.size());
+
+	auto it = std::upper_bound(runs_.begin(), runs_.end(), pos, [](size_type index, const std::pair<uint32_t, uint32_t> &run) {
+		return index < run.first;
+	});
+
+	Q_ASSERT(it != runs_.begin());
+	--it;
+
+	return bytes_.data() + it->second + (records_[pos].offset - records_[it->first].offset);
 }
 
 /**
- * @brief BasicBlock::rbegin
+ * @brief InstructionArena::size
  * @return
  */
-BasicBlock::const_reverse_iterator BasicBlock::rbegin() const {
-	return const_reverse_iterator(instructions_.end());
+InstructionArena::size_type InstructionArena::size() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return records_.size();
 }
 
 /**
- * @brief BasicBlock::rend
- * @return
+ * @brief InstructionArena::memoryUsage
+ * @return the number of bytes used by the records
  */
-BasicBlock::const_reverse_iterator BasicBlock::rend() const {
-	return const_reverse_iterator(instructions_.begin());
+InstructionArena::size_type InstructionArena::memoryUsage() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return sizeof(*this) + records_.capacity() * sizeof(InstructionRecord) + bytes_.capacity() + runs_.capacity() * sizeof(runs_[0]);
 }
 
 /**
- * @brief BasicBlock::rbegin
- * @return
+ * @brief BasicBlock::BasicBlock
+ * @param arena
+ * @param first the index of the first record of this block in <arena>
+ * @param count
  */
-BasicBlock::reverse_iterator BasicBlock::rbegin() {
-	return reverse_iterator(instructions_.end());
+BasicBlock::BasicBlock(std::shared_ptr<const InstructionArena> arena, size_type first, size_type count)
+	: arena_(std::move(arena)), first_(static_cast<uint32_t>(first)), count_(static_cast<uint32_t>(count)) {
+	Q_ASSERT(arena_ || count == 0);
 }
 
 /**
- * @brief BasicBlock::rend
- * @return
+ * @brief BasicBlock::swap
+ * @param other
  */
-BasicBlock::reverse_iterator BasicBlock::rend() {
-	return reverse_iterator(instructions_.begin());
+void BasicBlock::swap(BasicBlock &other) {
+	using std::swap;
+	swap(arena_, other.arena_);
+	swap(first_, other.first_);
+	swap(count_, other.count_);
+	swap(references_, other.references_);
 }
 
 /**
@@ -109,7 +126,7 @@ BasicBlock::reverse_iterator BasicBlock::rend() {
  * @return
  */
 BasicBlock::size_type BasicBlock::size() const {
-	return instructions_.size();
+	return count_;
 }
 
 /**
@@ -117,63 +134,57 @@ BasicBlock::size_type BasicBlock::size() const {
  * @return
  */
 bool BasicBlock::empty() const {
-	return instructions_.empty();
+	return count_ == 0;
 }
 
 /**
- * @brief BasicBlock::operator []
+ * @brief BasicBlock::record
  * @param pos
  * @return
  */
-BasicBlock::reference BasicBlock::operator[](size_type pos) {
-	Q_ASSERT(pos < instructions_.size());
-	return instructions_[pos];
+const InstructionRecord &BasicBlock::record(size_type pos) const {
+	Q_ASSERT(pos < size());
+	return (*arena_)[first_ + pos];
 }
 
 /**
- * @brief BasicBlock::operator []
+ * @brief BasicBlock::instructionAddress
  * @param pos
  * @return
  */
-BasicBlock::const_reference BasicBlock::operator[](size_type pos) const {
-	Q_ASSERT(pos < instructions_.size());
-	return instructions_[pos];
+edb::address_t BasicBlock::instructionAddress(size_type pos) const {
+	return arena_->base() + record(pos).offset;
 }
 
 /**
- * @brief BasicBlock::front
- * @return
+ * @brief BasicBlock::operator[]
+ * @param pos
+ * @return the instruction, decoded from the bytes it was analyzed from
  */
-BasicBlock::reference BasicBlock::front() {
-	Q_ASSERT(!empty());
-	return *begin();
-}
+instruction_pointer BasicBlock::operator[](size_type pos) const {
 
-/**
- * @brief BasicBlock::front
- * @return
- */
-BasicBlock::const_reference BasicBlock::front() const {
-	Q_ASSERT(!empty());
-	return *begin();
+	// the debuggee may have changed since, and what is there now
+	// need not even be the same length
+	const uint8_t *const bytes = arena_->bytes(first_ + pos);
+	return std::make_shared<edb::Instruction>(bytes, bytes + record(pos).size, instructionAddress(pos));
 }
 
 /**
- * @brief BasicBlock::back
+ * @brief BasicBlock::front
  * @return
  */
-BasicBlock::reference BasicBlock::back() {
+instruction_pointer BasicBlock::front() const {
 	Q_ASSERT(!empty());
-	return *rbegin();
+	return (*this)[0];
 }
 
 /**
  * @brief BasicBlock::back
  * @return
  */
-BasicBlock::const_reference BasicBlock::back() const {
+instruction_pointer BasicBlock::back() const {
 	Q_ASSERT(!empty());
-	return *rbegin();
+	return (*this)[size() - 1];
 }
 
 /**
@@ -182,8 +193,8 @@ BasicBlock::const_reference BasicBlock::back() const {
  */
 BasicBlock::size_type BasicBlock::byteSize() const {
 	size_type n = 0;
-	for (const instruction_pointer &inst : instructions_) {
-		n += inst->byteSize();
+	for (size_type i = 0; i < size(); ++i) {
+		n += record(i).size;
 	}
 	return n;
 }
@@ -194,7 +205,7 @@ BasicBlock::size_type BasicBlock::byteSize() const {
  */
 edb::address_t BasicBlock::firstAddress() const {
 	Q_ASSERT(!empty());
-	return edb::address_t(front()->rva());
+	return instructionAddress(0);
 }
 
 /**
@@ -203,7 +214,7 @@ edb::address_t BasicBlock::firstAddress() const {
  */
 edb::address_t BasicBlock::lastAddress() const {
 	Q_ASSERT(!empty());
-	return edb::address_t(back()->rva() + back()->byteSize());
+	return instructionAddress(size() - 1) + record(size() - 1).size;
 }
 
 /**
@@ -214,7 +225,8 @@ QString BasicBlock::toString() const {
 	QString text;
 	QTextStream ts(&text);
 
-	for (const instruction_pointer &inst : instructions_) {
+	for (size_type i = 0; i < size(); ++i) {
+		const instruction_pointer inst = (*this)[i];
 		ts << edb::address_t(inst->rva()).toPointerString() << ": " << edb::v1::formatter().toString(*inst).c_str() << "\n";
 	}
 
@@ -239,26 +251,17 @@ std::vector<std::pair<edb::address_t, edb::address_t>> BasicBlock::references()
 }
 
 /**
- * @brief BasicBlock::references
- * @return
+ * @brief BasicBlock::splitBlock
+ * @param pos
+ * @return two blocks, the first one ends with the instruction at <pos>
  */
-std::pair<BasicBlock, BasicBlock> BasicBlock::splitBlock(const instruction_pointer &inst) {
-	BasicBlock block1;
-	BasicBlock block2;
-
-	auto it = begin();
-	for (; it != end(); ++it) {
+std::pair<BasicBlock, BasicBlock> BasicBlock::splitBlock(size_type pos) const {
 
-		block1.push_back(*it);
-		if (*it == inst) {
-			++it;
-			break;
-		}
-	}
+	Q_ASSERT(pos < size());
 
-	for (; it != end(); ++it) {
-		block2.push_back(*it);
-	}
+	// both halves are just smaller ranges of the same records
+	BasicBlock block1(arena_, first_, pos + 1);
+	BasicBlock block2(arena_, first_ + pos + 1, size() - (pos + 1));
 
 	for (auto it = references_.begin(); it != references_.end(); ++it) {
 		if (it->first >= block1.firstAddress() && it->first < block1.lastAddress()) {
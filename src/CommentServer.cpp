@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IDebugger.h"
 #include "IProcess.h"
 #include "Instruction.h"
+#include "InstructionCache.h"
 #include "edb.h"
 
 namespace {
@@ -65,10 +66,12 @@ Result<QString, QString> CommentServer::resolveFunctionCall(edb::address_t addre
 
 		uint8_t buffer[edb::Instruction::MaxSize];
 
-		if (process->readBytes(address - CallMaxSize, buffer, sizeof(buffer))) {
+		const edb::address_t start = address - CallMaxSize;
+
+		if (process->readBytes(start, buffer, sizeof(buffer))) {
 			for (int i = (CallMaxSize - CallMinSize); i >= 0; --i) {
-				edb::Instruction inst(buffer + i, buffer + sizeof(buffer), 0);
-				if (is_call(inst)) {
+				const auto entry = edb::v1::instruction_cache().find(start + i, buffer + i, sizeof(buffer) - i);
+				if (is_call(entry->instruction())) {
 					const QString symname = edb::v1::find_function_symbol(address);
 
 					if (!symname.isEmpty()) {
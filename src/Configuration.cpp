@@ -137,6 +137,7 @@ void Configuration::readSettings() {
 	remove_stale_symbols    = settings.value("debugger.remove_stale_symbols.enabled", true).toBool();
 	disableASLR             = settings.value("debugger.disableASLR.enabled", false).toBool();
 	disableLazyBinding      = settings.value("debugger.disableLazyBinding.enabled", false).toBool();
+	nonStopMode             = settings.value("debugger.nonStopMode.enabled", false).toBool();
 	break_on_library_load   = settings.value("debugger.break_on_library_load_event.enabled", false).toBool();
 	default_breakpoint_type = settings.value("debugger.default_breakpoint_type", QVariant::fromValue(IBreakpoint::TypeId::Automatic)).value<IBreakpoint::TypeId>();
 	settings.endGroup();
@@ -253,6 +254,7 @@ void Configuration::writeSettings() {
 	settings.setValue("debugger.remove_stale_symbols.enabled", remove_stale_symbols);
 	settings.setValue("debugger.disableASLR.enabled", disableASLR);
 	settings.setValue("debugger.disableLazyBinding.enabled", disableLazyBinding);
+	settings.setValue("debugger.nonStopMode.enabled", nonStopMode);
 	settings.setValue("debugger.break_on_library_load_event.enabled", break_on_library_load);
 	settings.setValue("debugger.default_breakpoint_type", QVariant::fromValue(default_breakpoint_type));
 	settings.endGroup();
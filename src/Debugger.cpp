@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ArchProcessor.h"
 #include "CommentServer.h"
 #include "Configuration.h"
+#include "DebugEventNotifier.h"
 #include "DebuggerInternal.h"
 #include "DialogAbout.h"
 #include "DialogArguments.h"
@@ -40,6 +41,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IProcess.h"
 #include "IThread.h"
 #include "Instruction.h"
+#include "InstructionCache.h"
 #include "MemoryRegions.h"
 #include "QHexView"
 #include "RecentFileManager.h"
@@ -168,8 +170,7 @@ bool is_instruction_ret(edb::address_t address) {
 
 	uint8_t buffer[edb::Instruction::MaxSize];
 	if (const int size = edb::v1::get_instruction_bytes(address, buffer)) {
-		edb::Instruction inst(buffer, buffer + size, address);
-		return is_ret(inst);
+		return is_ret(edb::v1::instruction_cache().find(address, buffer, size)->instruction());
 	}
 	return false;
 }
@@ -377,6 +378,13 @@ Debugger::Debugger(QWidget *parent)
 	// connect the timer to the debug event
 	connect(timer_, &QTimer::timeout, this, &Debugger::nextDebugEvent);
 
+	// if the core can tell us when an event is waiting, we don't need to poll
+	if (edb::v1::debugger_core) {
+		if (DebugEventNotifier *notifier = edb::v1::debugger_core->eventNotifier()) {
+			connect(notifier, &DebugEventNotifier::debugEventPending, this, &Debugger::nextDebugEvent);
+		}
+	}
+
 	// create a context menu for the tab bar as well
 	connect(tabWidget_, &TabWidget::customContextMenuRequested, this, &Debugger::tabContextMenu);
 
@@ -1479,7 +1487,8 @@ void Debugger::stepOver(F1 run_func, F2 step_func) {
 			const edb::address_t ip = state.instructionPointer();
 			uint8_t buffer[edb::Instruction::MaxSize];
 			if (const int sz = edb::v1::get_instruction_bytes(ip, buffer)) {
-				edb::Instruction inst(buffer, buffer + sz, 0);
+				const auto entry             = edb::v1::instruction_cache().find(ip, buffer, sz);
+				const edb::Instruction &inst = entry->instruction();
 				if (inst && edb::v1::arch_processor().canStepOver(inst)) {
 
 					// add a temporary breakpoint at the instruction just
@@ -2156,7 +2165,7 @@ void Debugger::mnuCPUAddConditionalBreakpoint() {
 	if (ok) {
 		if (std::shared_ptr<IBreakpoint> bp = edb::v1::create_breakpoint(address)) {
 			if (!condition.isEmpty()) {
-				bp->condition = condition;
+				bp->setCondition(condition);
 			}
 		}
 	}
@@ -2305,9 +2314,31 @@ void Debugger::mnuStackModify() {
 // Name: breakpoint_condition_true
 // Desc:
 //------------------------------------------------------------------------------
-bool Debugger::isBreakpointConditionTrue(const QString &condition) {
+bool Debugger::isBreakpointConditionTrue(const IBreakpoint &bp, const State &state) {
+
+	// the condition was compiled when it was set, so all that is
+	// left to do here is to run it against the state we already have in hand
+	if (Expression<edb::address_t> *expr = bp.compiledCondition()) {
+
+		auto variable_reader = [&state](const QString &name, bool *ok, ExpressionError *err) {
+			return edb::v1::get_state_variable(state, name, ok, err);
+		};
+
+		auto bound_reader = [&state](int index, bool *ok, ExpressionError *err) {
+			return edb::v1::get_bound_state_variable(state, index, ok, err);
+		};
+
+		const Result<edb::address_t, ExpressionError> condition_value = expr->evaluate(variable_reader, edb::v1::get_value, bound_reader);
+		if (condition_value) {
+			return *condition_value;
+		}
+
+		QMessageBox::critical(this, tr("Error In Expression!"), condition_value.error().what());
+		return true;
+	}
 
-	if (std::optional<edb::address_t> condition_value = edb::v2::eval_expression(condition)) {
+	// the condition didn't compile, this will tell the user why
+	if (std::optional<edb::address_t> condition_value = edb::v2::eval_expression(bp.condition())) {
 		return *condition_value;
 	}
 	return true;
@@ -2370,15 +2401,19 @@ edb::EventStatus Debugger::handleTrap(const std::shared_ptr<IDebugEvent> &event)
 		}
 #endif
 
-		const QString condition = bp->condition;
-
 		// handle conditional breakpoints
-		if (!condition.isEmpty()) {
-			if (!isBreakpointConditionTrue(condition)) {
+		if (!bp->condition().isEmpty()) {
+			if (!isBreakpointConditionTrue(*bp, state)) {
 				return edb::DEBUG_CONTINUE_BP;
 			}
 		}
 
+		// tracepoints take note of what they need to and carry on
+		if (bp->isTracepoint()) {
+			edb::v1::record_tracepoint(*bp, process->currentThread()->tid(), state);
+			return edb::DEBUG_CONTINUE_BP;
+		}
+
 		// if it's a one time breakpoint then we should remove it upon
 		// triggering, this is mainly used for situations like step over
 
@@ -2784,6 +2819,12 @@ void Debugger::resumeExecution(ExceptionResume pass_exception, DebugMode mode, R
 
 			// set the state to 'running'
 			updateMenuState(Running);
+
+			// single steps don't count, the debuggee is only let go
+			// for an instruction and the memory map almost never changes
+			if (mode == Run) {
+				Q_EMIT resumeEvent();
+			}
 		}
 	}
 }
@@ -2987,7 +3028,9 @@ void Debugger::detachFromProcess(DetachAction kill) {
 void Debugger::setInitialDebuggerState() {
 
 	updateMenuState(Paused);
-	timer_->start(0);
+	if (!edb::v1::debugger_core->eventNotifier()) {
+		timer_->start(0);
+	}
 
 	edb::v1::symbol_manager().clear();
 	edb::v1::memory_regions().sync();
@@ -3550,7 +3593,10 @@ void Debugger::nextDebugEvent() {
 
 	Q_ASSERT(edb::v1::debugger_core);
 
-	if (std::shared_ptr<IDebugEvent> e = edb::v1::debugger_core->waitDebugEvent(10ms)) {
+	// when the core told us there is an event, there is no point in waiting
+	const std::chrono::milliseconds timeout = edb::v1::debugger_core->eventNotifier() ? 0ms : 10ms;
+
+	if (std::shared_ptr<IDebugEvent> e = edb::v1::debugger_core->waitDebugEvent(timeout)) {
 
 		lastEvent_ = e;
 
@@ -45,6 +45,7 @@ class IBreakpoint;
 class IDebugEvent;
 class IPlugin;
 class RecentFileManager;
+class State;
 class TabWidget;
 
 class QDisassemblyView;
@@ -120,6 +121,7 @@ Q_SIGNALS:
 	void debugEvent();
 	void detachEvent();
 	void attachEvent();
+	void resumeEvent();
 
 public Q_SLOTS:
 	// the auto-connected slots
@@ -233,7 +235,7 @@ private:
 	Result<edb::address_t, QString> getGotoExpression();
 	[[nodiscard]] Result<edb::reg_t, QString> getFollowRegister() const;
 	bool commonOpen(const QString &s, const QList<QByteArray> &args, const QString &input, const QString &output);
-	bool isBreakpointConditionTrue(const QString &condition);
+	bool isBreakpointConditionTrue(const IBreakpoint &bp, const State &state);
 	edb::EventStatus handleEventExited(const std::shared_ptr<IDebugEvent> &event);
 	edb::EventStatus handleEventStopped(const std::shared_ptr<IDebugEvent> &event);
 	edb::EventStatus handleEventTerminated(const std::shared_ptr<IDebugEvent> &event);
@@ -80,7 +80,7 @@ void DialogBreakpoints::updateList() {
 		ui.tableWidget->insertRow(row);
 
 		const edb::address_t address = bp->address();
-		const QString condition      = bp->condition;
+		const QString condition      = bp->condition();
 		const bool onetime           = bp->oneTime();
 		const QString symname        = edb::v1::find_function_symbol(address, QString(), nullptr);
 		const QString bytes          = edb::v1::format_bytes(bp->originalBytes(), bp->size());
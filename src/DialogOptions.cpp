@@ -180,6 +180,7 @@ void DialogOptions::showEvent(QShowEvent *event) {
 	ui.chkDeleteStaleSymbols->setChecked(config.remove_stale_symbols);
 	ui.chkDisableASLR->setChecked(config.disableASLR);
 	ui.chkDisableLazyBinding->setChecked(config.disableLazyBinding);
+	ui.chkNonStopMode->setChecked(config.nonStopMode);
 
 	ui.chkBreakOnLibraryLoad->setChecked(config.break_on_library_load);
 
@@ -309,6 +310,7 @@ void DialogOptions::closeEvent(QCloseEvent *event) {
 	config.remove_stale_symbols    = ui.chkDeleteStaleSymbols->isChecked();
 	config.disableASLR             = ui.chkDisableASLR->isChecked();
 	config.disableLazyBinding      = ui.chkDisableLazyBinding->isChecked();
+	config.nonStopMode             = ui.chkNonStopMode->isChecked();
 	config.break_on_library_load   = ui.chkBreakOnLibraryLoad->isChecked();
 	config.default_breakpoint_type = ui.cmbDefaultBreakpointType->itemData(ui.cmbDefaultBreakpointType->currentIndex()).value<IBreakpoint::TypeId>();
 
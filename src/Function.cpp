@@ -69,7 +69,8 @@ edb::address_t Function::endAddress() const {
  */
 edb::address_t Function::lastInstruction() const {
 	Q_ASSERT(!empty());
-	return back().back()->rva();
+	const BasicBlock &bb = back();
+	return bb.instructionAddress(bb.size() - 1);
 }
 
 /**
@@ -202,6 +203,15 @@ Function::size_type Function::size() const {
 void Function::addReference() {
 	++referenceCount_;
 }
+
+/**
+ * @brief Function::setReferenceCount
+ * @param count
+ */
+void Function::setReferenceCount(int count) {
+	referenceCount_ = count;
+}
+
 /**
  * @brief Function::type
  * @return
@@ -0,0 +1,75 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "IBreakpoint.h"
+#include "Expression.h"
+#include "edb.h"
+
+namespace {
+
+/**
+ * @brief compile
+ * @param expression
+ * @return <expression> compiled, with the registers in it bound so that they
+ * are read without looking at their names on every hit. nullptr if it doesn't
+ * compile
+ */
+std::unique_ptr<Expression<edb::address_t>> compile(const QString &expression) {
+	auto expr = std::make_unique<Expression<edb::address_t>>(expression, nullptr, nullptr);
+	if (!expr->compile(edb::v1::bind_state_variable)) {
+		return nullptr;
+	}
+	return expr;
+}
+
+}
+
+/**
+ * @brief IBreakpoint::IBreakpoint
+ */
+IBreakpoint::IBreakpoint() = default;
+
+/**
+ * @brief IBreakpoint::~IBreakpoint
+ */
+IBreakpoint::~IBreakpoint() = default;
+
+/**
+ * @brief IBreakpoint::setCondition
+ * @param condition
+ */
+void IBreakpoint::setCondition(const QString &condition) {
+	condition_ = condition;
+	compiledCondition_.reset();
+
+	if (!condition.isEmpty()) {
+		compiledCondition_ = compile(condition);
+	}
+}
+
+/**
+ * @brief IBreakpoint::setTraceExpressions
+ * @param expressions
+ */
+void IBreakpoint::setTraceExpressions(const QStringList &expressions) {
+	traceExpressions_ = expressions;
+	compiledTrace_.clear();
+
+	for (const QString &expression : expressions) {
+		compiledTrace_.push_back(compile(expression));
+	}
+}
@@ -0,0 +1,292 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "InstructionCache.h"
+#include "edb.h"
+#include <QtGlobal>
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+/**
+ * @brief InstructionCache::Entry::Entry
+ * @param address
+ * @param buf
+ * @param size
+ */
+InstructionCache::Entry::Entry(edb::address_t address, const uint8_t *buf, std::size_t size)
+	: instruction_(buf, buf + size, address), size_(std::min(size, edb::Instruction::MaxSize)) {
+	std::copy_n(buf, size_, bytes_);
+}
+
+/**
+ * the instruction as the formatter renders it, formatted on first use
+ *
+ * @brief InstructionCache::Entry::text
+ * @return
+ */
+const QString &InstructionCache::Entry::text() const {
+	std::call_once(textOnce_, [this]() {
+		// one buffer per thread, so formatting doesn't allocate once it has grown
+		thread_local std::string buffer;
+		edb::v1::formatter().toString(instruction_, &buffer);
+		text_ = QString::fromStdString(buffer);
+	});
+	return text_;
+}
+
+/**
+ * @brief InstructionCache::Entry::matches
+ * @param buf
+ * @param size
+ * @return true if decoding <buf> would give the same result as this entry
+ */
+bool InstructionCache::Entry::matches(const uint8_t *buf, std::size_t size) const {
+
+	// a valid instruction only depends on its own bytes, but
+	// whether a failed decode fails again depends on how much we were given
+	if (instruction_) {
+		const std::size_t n = instruction_.byteSize();
+		return size >= n && std::memcmp(bytes_, buf, n) == 0;
+	}
+
+	return std::min(size, edb::Instruction::MaxSize) == size_ && std::memcmp(bytes_, buf, size_) == 0;
+}
+
+/**
+ * @brief InstructionCache::InstructionCache
+ * @param capacity
+ */
+InstructionCache::InstructionCache(std::size_t capacity)
+	: capacity_(capacity) {
+	Q_ASSERT(capacity != 0);
+}
+
+/**
+ * finds (or decodes and remembers) the instruction at <address>, <buf> holds
+ * the <size> bytes which are currently found there
+ *
+ * @brief InstructionCache::find
+ * @param address
+ * @param buf
+ * @param size
+ * @return
+ */
+std::shared_ptr<const InstructionCache::Entry> InstructionCache::find(edb::address_t address, const void *buf, std::size_t size) {
+
+	Q_ASSERT(buf || size == 0);
+
+	const auto bytes          = static_cast<const uint8_t *>(buf);
+	const uint64_t generation = CapstoneEDB::generation();
+
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex_);
+		if (generation_ == generation) {
+			auto it = current_.find(address);
+			if (it != current_.end() && it->second->matches(bytes, size)) {
+				return it->second;
+			}
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(mutex_);
+
+	// the architecture or formatting changed, nothing we have is any good
+	if (generation_ != generation) {
+		current_.clear();
+		previous_.clear();
+		generation_ = generation;
+	}
+
+	auto it = previous_.find(address);
+	if (it != previous_.end() && it->second->matches(bytes, size)) {
+		std::shared_ptr<const Entry> entry = std::move(it->second);
+		previous_.erase(it);
+		insert(address, entry);
+		return entry;
+	}
+
+	// decoding is the expensive part, don't hold up everyone else meanwhile
+	lock.unlock();
+	auto entry = std::make_shared<const Entry>(address, bytes, size);
+	lock.lock();
+
+	if (generation_ == generation) {
+		insert(address, entry);
+	}
+
+	return entry;
+}
+
+/**
+ * forgets every instruction which overlaps [address, address + size)
+ *
+ * @brief InstructionCache::invalidate
+ * @param address
+ * @param size
+ */
+void InstructionCache::invalidate(edb::address_t address, std::size_t size) {
+
+	if (size == 0) {
+		return;
+	}
+
+	// an instruction starting up to MaxSize - 1 bytes earlier may reach into the range
+	const edb::address_t first = (address >= edb::Instruction::MaxSize - 1) ? address - (edb::Instruction::MaxSize - 1) : edb::address_t(0);
+	const edb::address_t last  = address + (size - 1);
+
+	std::unique_lock<std::shared_mutex> lock(mutex_);
+
+	for (Map *map : {&current_, &previous_}) {
+		auto it = map->lower_bound(first);
+		while (it != map->end() && it->first <= last) {
+			it = map->erase(it);
+		}
+	}
+
+	logChange(address, size);
+}
+
+/**
+ * takes note of an invalidation. Ranges which overlap (or touch) are merged,
+ * and once there are LogSize of them, the closest one takes in the new range
+ * as well. The log this way never loses track of a change, at worst it
+ * reports a bit more than what actually changed
+ *
+ * @brief InstructionCache::logChange
+ * @param address
+ * @param size
+ */
+void InstructionCache::logChange(edb::address_t address, std::size_t size) {
+
+	++sequence_;
+
+	edb::address_t first = address;
+	edb::address_t last  = address + (size - 1);
+
+	// the distance between two ranges, 0 if they overlap or touch
+	const auto gap = [](const Range &range, edb::address_t lo, edb::address_t hi) -> edb::address_t {
+		const edb::address_t range_last = range.address + (range.size - 1);
+		if (range_last + 1 < lo) {
+			return lo - (range_last + 1);
+		}
+
+		if (hi + 1 < range.address) {
+			return range.address - (hi + 1);
+		}
+
+		return edb::address_t(0);
+	};
+
+	// merging may make a range reach the ones next to it, so keep going
+	// until nothing is left to merge with
+	auto merge = [&first, &last](const Range &range) {
+		first = std::min(first, range.address);
+		last  = std::max(last, range.address + (range.size - 1));
+	};
+
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		for (auto it = log_.begin(); it != log_.end(); ++it) {
+			if (gap(it->range, first, last) == 0) {
+				merge(it->range);
+				log_.erase(it);
+				merged = true;
+				break;
+			}
+		}
+	}
+
+	if (log_.size() >= LogSize) {
+		auto closest = std::min_element(log_.begin(), log_.end(), [&](const LogEntry &lhs, const LogEntry &rhs) {
+			return gap(lhs.range, first, last) < gap(rhs.range, first, last);
+		});
+
+		merge(closest->range);
+		log_.erase(closest);
+	}
+
+	log_.push_back(LogEntry{Range{first, static_cast<std::size_t>(last - first) + 1}, sequence_});
+}
+
+/**
+ * @brief InstructionCache::clear
+ */
+void InstructionCache::clear() {
+	std::unique_lock<std::shared_mutex> lock(mutex_);
+	current_.clear();
+	previous_.clear();
+	log_.clear();
+	cleared_ = ++sequence_;
+}
+
+/**
+ * @brief InstructionCache::sequence
+ * @return the number of invalidations so far
+ */
+uint64_t InstructionCache::sequence() const {
+	std::shared_lock<std::shared_mutex> lock(mutex_);
+	return sequence_;
+}
+
+/**
+ * appends the ranges invalidated since <sequence> to <ranges>
+ *
+ * @brief InstructionCache::changesSince
+ * @param sequence
+ * @param ranges
+ * @return false if everything was cleared meanwhile, in which case the caller
+ * has to forget everything
+ */
+bool InstructionCache::changesSince(uint64_t sequence, std::vector<Range> *ranges) const {
+
+	Q_ASSERT(ranges);
+
+	std::shared_lock<std::shared_mutex> lock(mutex_);
+
+	if (sequence < cleared_) {
+		return false;
+	}
+
+	for (const LogEntry &entry : log_) {
+		if (entry.sequence > sequence) {
+			ranges->push_back(entry.range);
+		}
+	}
+
+	return true;
+}
+
+/**
+ * once the current generation of entries is full, it becomes the previous one
+ * and the old previous one is dropped. Entries which are still in use get
+ * promoted back into the current one by find
+ *
+ * @brief InstructionCache::insert
+ * @param address
+ * @param entry
+ */
+void InstructionCache::insert(edb::address_t address, const std::shared_ptr<const Entry> &entry) {
+
+	if (current_.size() >= capacity_) {
+		previous_ = std::move(current_);
+		current_.clear();
+	}
+
+	current_[address] = entry;
+}
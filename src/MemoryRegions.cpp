@@ -21,9 +21,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IProcess.h"
 #include "IRegion.h"
 #include "ISymbolManager.h"
+#include "InstructionCache.h"
 #include "edb.h"
 
 #include <QDebug>
+#include <QHash>
+#include <algorithm>
 
 //------------------------------------------------------------------------------
 // Name: MemoryRegions
@@ -40,6 +43,10 @@ MemoryRegions::MemoryRegions()
 void MemoryRegions::clear() {
 	beginResetModel();
 	regions_.clear();
+
+	// a rebuilt binary is quite likely to be mapped at the same
+	// place with the same name the next time around
+	edb::v1::clear_binary_info();
 	endResetModel();
 }
 
@@ -79,6 +86,25 @@ void MemoryRegions::sync() {
 	}
 
 	std::swap(regions_, regions);
+
+	// whatever was decoded in a region which went away is no good anymore,
+	// something else may get mapped there
+	QHash<edb::address_t, std::shared_ptr<IRegion>> current;
+	current.reserve(regions_.size());
+	for (const std::shared_ptr<IRegion> &region : regions_) {
+		current.insert(region->start(), region);
+	}
+
+	for (const std::shared_ptr<IRegion> &old : regions) {
+		const std::shared_ptr<IRegion> region = current.value(old->start());
+		const bool still_mapped               = region && region->end() == old->end() && region->name() == old->name();
+
+		if (!still_mapped) {
+			edb::v1::instruction_cache().invalidate(old->start(), old->size());
+			edb::v1::invalidate_binary_info(old);
+		}
+	}
+
 	endResetModel();
 }
 
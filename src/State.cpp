@@ -388,6 +388,31 @@ QString State::fpuRegisterTagString(std::size_t n) const {
 }
 #endif
 
+/**
+ * @brief State::registerIndex
+ * @param reg
+ * @return an index which registerValue can read <reg> by, -1 if there isn't one
+ */
+int State::registerIndex(const QString &reg) const {
+	if (impl_) {
+		return impl_->registerIndex(reg);
+	}
+	return -1;
+}
+
+/**
+ * @brief State::registerValue
+ * @param index
+ * @param value
+ * @return true if the register at <index> has been filled in
+ */
+bool State::registerValue(int index, edb::reg_t *value) const {
+	if (impl_) {
+		return impl_->registerValue(index, value);
+	}
+	return false;
+}
+
 /**
  * @brief State::gpRegister
  * @param n
@@ -75,6 +75,10 @@ QVariant ThreadsModel::data(const QModelIndex &index, int role) const {
 			case 3:
 				return item.thread->runState();
 			case 4:
+				// in non-stop mode, only some of the threads
+				// may be halted by the debugger at any given time
+				return item.thread->isPaused() ? tr("Stopped") : tr("Running");
+			case 5:
 				return item.thread->name();
 			}
 		} else if (role == Qt::UserRole) {
@@ -98,6 +102,8 @@ QVariant ThreadsModel::headerData(int section, Qt::Orientation orientation, int
 		case 3:
 			return tr("State");
 		case 4:
+			return tr("Debugger State");
+		case 5:
 			return tr("Name");
 		}
 	}
@@ -107,7 +113,7 @@ QVariant ThreadsModel::headerData(int section, Qt::Orientation orientation, int
 
 int ThreadsModel::columnCount(const QModelIndex &parent) const {
 	Q_UNUSED(parent)
-	return 5;
+	return 6;
 }
 
 int ThreadsModel::rowCount(const QModelIndex &parent) const {
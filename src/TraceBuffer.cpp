@@ -0,0 +1,117 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TraceBuffer.h"
+#include <QtGlobal>
+#include <algorithm>
+
+/**
+ * @brief TraceBuffer::TraceBuffer
+ * @param capacity
+ */
+TraceBuffer::TraceBuffer(std::size_t capacity)
+	: slots_(std::make_unique<Slot[]>(capacity)), capacity_(capacity) {
+	Q_ASSERT(capacity != 0);
+}
+
+/**
+ * records a hit, overwriting the oldest record once the buffer is full
+ *
+ * @brief TraceBuffer::push
+ * @param address
+ * @param tid
+ * @param values
+ * @param valid
+ * @param count
+ */
+void TraceBuffer::push(edb::address_t address, edb::tid_t tid, const edb::address_t *values, const bool *valid, std::size_t count) noexcept {
+
+	const uint64_t sequence = head_.load(std::memory_order_relaxed);
+	Slot &slot              = slots_[sequence % capacity_];
+
+	// a zero sequence marks the slot as being written, readers
+	// which raced with us will see that (or a changed sequence) and give up
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	count = std::min(count, MaxValues);
+
+	Record &record  = slot.record;
+	record.sequence = sequence;
+	record.address  = address;
+	record.tid      = tid;
+	record.count    = count;
+	std::copy_n(values, count, record.values);
+	std::copy_n(valid, count, record.valid);
+
+	slot.sequence.store(sequence + 1, std::memory_order_release);
+	head_.store(sequence + 1, std::memory_order_release);
+}
+
+/**
+ * forgets all of the records so far, the sequence numbers keep counting
+ *
+ * @brief TraceBuffer::clear
+ */
+void TraceBuffer::clear() noexcept {
+	base_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+/**
+ * @brief TraceBuffer::read
+ * @param sequence
+ * @param record
+ * @return false if there is no such record (anymore)
+ */
+bool TraceBuffer::read(uint64_t sequence, Record *record) const noexcept {
+
+	Q_ASSERT(record);
+
+	if (sequence < first() || sequence >= end()) {
+		return false;
+	}
+
+	const Slot &slot = slots_[sequence % capacity_];
+
+	if (slot.sequence.load(std::memory_order_acquire) != sequence + 1) {
+		return false;
+	}
+
+	*record = slot.record;
+
+	// if the writer lapped us while we were copying, the copy is no good
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.sequence.load(std::memory_order_relaxed) == sequence + 1;
+}
+
+/**
+ * @brief TraceBuffer::first
+ * @return the sequence number of the oldest record still available
+ */
+uint64_t TraceBuffer::first() const noexcept {
+	const uint64_t head = head_.load(std::memory_order_acquire);
+	const uint64_t base = base_.load(std::memory_order_acquire);
+	return std::max(base, head > capacity_ ? head - capacity_ : 0);
+}
+
+/**
+ * @brief TraceBuffer::end
+ * @return one past the sequence number of the newest record
+ */
+uint64_t TraceBuffer::end() const noexcept {
+	return head_.load(std::memory_order_acquire);
+}
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IProcess.h"
 #include "IThread.h"
 #include "Instruction.h"
+#include "InstructionCache.h"
 #include "Prototype.h"
 #include "RegisterViewModel.h"
 #include "State.h"
@@ -863,7 +864,8 @@ void analyze_jump_targets(const edb::Instruction &inst, QStringList &ret) {
 
 	for (edb::address_t addr = start_address; addr < end_address; ++addr) {
 		if (const int sz = edb::v1::get_instruction_bytes(addr, buffer)) {
-			edb::Instruction inst(buffer, buffer + sz, addr);
+			const auto entry             = edb::v1::instruction_cache().find(addr, buffer, sz);
+			const edb::Instruction &inst = entry->instruction();
 			if (is_jump(inst)) {
 				const auto operand = inst[0];
 
@@ -1496,8 +1498,9 @@ QStringList ArchProcessor::updateInstructionInfo(edb::address_t address) {
 	if (IProcess *process = edb::v1::debugger_core->process()) {
 		uint8_t buffer[edb::Instruction::MaxSize];
 
-		if (process->readBytes(address, buffer, sizeof(buffer))) {
-			edb::Instruction inst(buffer, buffer + sizeof(buffer), address);
+		if (const std::size_t size = process->readBytes(address, buffer, sizeof(buffer))) {
+			const auto entry             = edb::v1::instruction_cache().find(address, buffer, size);
+			const edb::Instruction &inst = entry->instruction();
 			if (inst) {
 
 				State state;
@@ -17,17 +17,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Instruction.h"
 
-#include <QRegExp>
 #include <QRegularExpression>
 #include <QString>
 #include <QStringList>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cctype>
+#include <cinttypes>
+#include <cstdio>
 #include <cstring>
-#include <sstream>
 #include <stdexcept>
+#include <string_view>
 #include <vector>
 
 namespace CapstoneEDB {
@@ -36,11 +38,109 @@ namespace {
 
 constexpr int MaxOperands = 3;
 
-Architecture capstoneArch = Architecture::ARCH_X86;
-bool capstoneInitialized  = false;
-csh csh                   = 0;
+// the configuration is global, but every thread which decodes
+// instructions has its own capstone handles (capstone handles may not be
+// shared between threads). Whenever the configuration changes, the generation
+// is bumped and each thread reopens its handles the next time it needs them
+std::atomic<Architecture> capstoneArch{Architecture::ARCH_X86};
+std::atomic<bool> capstoneInitialized{false};
+std::atomic<bool> capstoneAttSyntax{false};
+std::atomic<uint64_t> capstoneGeneration{1};
+std::atomic<uint64_t> formatGeneration{1};
 Formatter activeFormatter;
 
+/**
+ * @brief open_handle
+ * @param handle
+ * @param detail
+ * @return true if capstone supports the current configuration
+ */
+bool open_handle(csh *handle, bool detail) {
+
+	const cs_err result = [handle]() {
+		switch (capstoneArch.load(std::memory_order_relaxed)) {
+		case Architecture::ARCH_AMD64:
+			return cs_open(CS_ARCH_X86, CS_MODE_64, handle);
+		case Architecture::ARCH_X86:
+			return cs_open(CS_ARCH_X86, CS_MODE_32, handle);
+		case Architecture::ARCH_ARM32_ARM:
+			return cs_open(CS_ARCH_ARM, CS_MODE_ARM, handle);
+		case Architecture::ARCH_ARM32_THUMB:
+			return cs_open(CS_ARCH_ARM, CS_MODE_THUMB, handle);
+		case Architecture::ARCH_ARM64:
+			return cs_open(CS_ARCH_ARM64, CS_MODE_ARM, handle);
+		default:
+			return CS_ERR_ARCH;
+		}
+	}();
+
+	if (result != CS_ERR_OK) {
+		return false;
+	}
+
+	cs_option(*handle, CS_OPT_DETAIL, detail ? CS_OPT_ON : CS_OPT_OFF);
+
+#if defined(EDB_X86) || defined(EDB_X86_64)
+	cs_option(*handle, CS_OPT_SYNTAX, capstoneAttSyntax.load(std::memory_order_relaxed) ? CS_OPT_SYNTAX_ATT : CS_OPT_SYNTAX_INTEL);
+#elif defined(EDB_ARM32) // FIXME(ARM): does this apply to AArch64?
+	// TODO: make this optional. Don't forget to reflect this in register view!
+	cs_option(*handle, CS_OPT_SYNTAX, CS_OPT_SYNTAX_NOREGNAME);
+#endif
+
+	return true;
+}
+
+// the capstone handles of one thread, one with details turned on and one
+// without them, each opened on first use
+class ThreadHandles {
+public:
+	ThreadHandles()                                 = default;
+	ThreadHandles(const ThreadHandles &)            = delete;
+	ThreadHandles &operator=(const ThreadHandles &) = delete;
+
+	~ThreadHandles() {
+		for (Entry &entry : entries_) {
+			if (entry.open) {
+				cs_close(&entry.handle);
+			}
+		}
+	}
+
+public:
+	/**
+	 * @brief handle
+	 * @param mode
+	 * @return a handle for the current configuration, 0 if there is none
+	 */
+	csh handle(Instruction::Mode mode) {
+
+		Entry &entry              = entries_[mode == Instruction::Mode::Full ? 0 : 1];
+		const uint64_t generation = capstoneGeneration.load(std::memory_order_acquire);
+
+		if (entry.generation != generation) {
+			if (entry.open) {
+				cs_close(&entry.handle);
+			}
+
+			entry.open       = open_handle(&entry.handle, mode == Instruction::Mode::Full);
+			entry.generation = generation;
+		}
+
+		return entry.open ? entry.handle : 0;
+	}
+
+private:
+	struct Entry {
+		csh handle          = 0;
+		uint64_t generation = 0;
+		bool open           = false;
+	};
+
+	Entry entries_[2];
+};
+
+thread_local ThreadHandles threadHandles;
+
 #if defined(EDB_X86) || defined(EDB_X86_64)
 /**
  * @brief is_simd_register
@@ -148,6 +248,159 @@ bool isX86_64() {
 	return capstoneArch == Architecture::ARCH_AMD64;
 }
 
+/**
+ * @brief is_word_char
+ * @param ch
+ * @return true if <ch> is what a regex would call \w
+ */
+bool is_word_char(char ch) {
+	return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+}
+
+/**
+ * @brief is_hex_char
+ * @param ch
+ * @return
+ */
+bool is_hex_char(char ch) {
+	return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+}
+
+/**
+ * @brief matches_at
+ * @param str
+ * @param pos
+ * @param what
+ * @return true if <what> appears in <str> at <pos>
+ */
+bool matches_at(const std::string &str, std::size_t pos, std::string_view what) {
+	return pos <= str.size() && str.compare(pos, what.size(), what) == 0;
+}
+
+/**
+ * @brief is_word_boundary
+ * @param str
+ * @param pos
+ * @return true if there is a word boundary (a regex \b) at <pos>
+ */
+bool is_word_boundary(const std::string &str, std::size_t pos) {
+	const bool before = pos > 0 && is_word_char(str[pos - 1]);
+	const bool after  = pos < str.size() && is_word_char(str[pos]);
+	return before != after;
+}
+
+/**
+ * @brief replace_all
+ * @param str
+ * @param first
+ * @param from
+ * @param to
+ */
+void replace_all(std::string *str, std::size_t first, std::string_view from, std::string_view to) {
+	for (std::size_t pos = str->find(from.data(), first, from.size()); pos != std::string::npos; pos = str->find(from.data(), pos + to.size(), from.size())) {
+		str->replace(pos, from.size(), to.data(), to.size());
+	}
+}
+
+/**
+ * matches "(\b.?(mm)?word|byte)\b( ptr)? " at <pos>, so things like
+ * "qword ptr ", "xmmword " or "byte "
+ *
+ * @brief size_specifier_length
+ * @param str
+ * @param pos
+ * @return the length of the match, 0 if there is none
+ */
+std::size_t size_specifier_length(const std::string &str, std::size_t pos) {
+
+	const auto tail = [&str, pos](std::size_t end) -> std::size_t {
+		if (!is_word_boundary(str, end)) {
+			return 0;
+		}
+
+		if (matches_at(str, end, " ptr ")) {
+			return end + 5 - pos;
+		}
+
+		if (matches_at(str, end, " ")) {
+			return end + 1 - pos;
+		}
+
+		return 0;
+	};
+
+	if (is_word_boundary(str, pos)) {
+		for (std::size_t any : {1, 0}) {
+			if (pos + any > str.size()) {
+				continue;
+			}
+
+			for (std::size_t mm : {2, 0}) {
+				const std::size_t at = pos + any;
+				if (mm != 0 && !matches_at(str, at, "mm")) {
+					continue;
+				}
+
+				if (matches_at(str, at + mm, "word")) {
+					if (const std::size_t n = tail(at + mm + 4)) {
+						return n;
+					}
+				}
+			}
+		}
+	}
+
+	if (matches_at(str, pos, "byte")) {
+		return tail(pos + 4);
+	}
+
+	return 0;
+}
+
+/**
+ * matches "\brip ?[+-] ?((0x)?[0-9a-fA-F]+)\b" at <pos>
+ *
+ * @brief rip_relative_length
+ * @param str
+ * @param pos
+ * @return the length of the match, 0 if there is none
+ */
+std::size_t rip_relative_length(const std::string &str, std::size_t pos) {
+
+	if (!is_word_boundary(str, pos) || !matches_at(str, pos, "rip")) {
+		return 0;
+	}
+
+	std::size_t at = pos + 3;
+	if (matches_at(str, at, " ")) {
+		++at;
+	}
+
+	if (!matches_at(str, at, "+") && !matches_at(str, at, "-")) {
+		return 0;
+	}
+
+	++at;
+	if (matches_at(str, at, " ")) {
+		++at;
+	}
+
+	if (matches_at(str, at, "0x")) {
+		at += 2;
+	}
+
+	const std::size_t digits = at;
+	while (at < str.size() && is_hex_char(str[at])) {
+		++at;
+	}
+
+	if (at == digits || (at < str.size() && is_word_char(str[at]))) {
+		return 0;
+	}
+
+	return at - pos;
+}
+
 /**
  * @brief to_operands
  * @param str
@@ -209,66 +462,63 @@ std::vector<std::string> to_operands(QString str) {
 
 bool init(Architecture arch) {
 
-	capstoneArch = arch;
-
-	if (capstoneInitialized) {
-		cs_close(&csh);
-	}
-
-	capstoneInitialized = false;
+	capstoneArch.store(arch, std::memory_order_relaxed);
+	capstoneGeneration.fetch_add(1, std::memory_order_acq_rel);
 
-	const cs_err result = [arch]() {
-		switch (arch) {
-		case Architecture::ARCH_AMD64:
-			return cs_open(CS_ARCH_X86, CS_MODE_64, &csh);
-		case Architecture::ARCH_X86:
-			return cs_open(CS_ARCH_X86, CS_MODE_32, &csh);
-		case Architecture::ARCH_ARM32_ARM:
-			return cs_open(CS_ARCH_ARM, CS_MODE_ARM, &csh);
-		case Architecture::ARCH_ARM32_THUMB:
-			return cs_open(CS_ARCH_ARM, CS_MODE_THUMB, &csh);
-		case Architecture::ARCH_ARM64:
-			return cs_open(CS_ARCH_ARM64, CS_MODE_ARM, &csh);
-		default:
-			return CS_ERR_ARCH;
-		}
-	}();
+	// make sure capstone can actually handle it, other threads will open
+	// their own handles when they need them
+	capstoneInitialized = threadHandles.handle(Instruction::Mode::Full) != 0;
 
-	if (result != CS_ERR_OK) {
+	if (!capstoneInitialized) {
 		return false;
 	}
 
-	capstoneInitialized = true;
-
-	cs_option(csh, CS_OPT_DETAIL, CS_OPT_ON);
-
 	// Set selected formatting options on reinit
 	activeFormatter.setOptions(activeFormatter.options());
 	return true;
 }
 
-Instruction::Instruction(Instruction &&other) noexcept
-	: insn_(std::exchange(other.insn_, nullptr)),
-	  byte0_(std::exchange(other.byte0_, 0)),
-	  rva_(std::exchange(other.rva_, 0)) {
+Architecture architecture() {
+	return capstoneArch.load(std::memory_order_relaxed);
+}
+
+uint64_t generation() {
+	return formatGeneration.load(std::memory_order_acquire);
+}
+
+Instruction::Instruction(Instruction &&other) noexcept {
+	moveFrom(other);
 }
 
 Instruction &Instruction::operator=(Instruction &&rhs) noexcept {
 	if (this != &rhs) {
-		insn_  = std::exchange(rhs.insn_, nullptr);
-		byte0_ = std::exchange(rhs.byte0_, 0);
-		rva_   = std::exchange(rhs.rva_, 0);
+		moveFrom(rhs);
 	}
 	return *this;
 }
 
-Instruction::~Instruction() {
-	if (insn_) {
-		cs_free(insn_, 1);
+/**
+ * the decoded data lives inside of the object, so moving means copying it
+ * and pointing the copy at its own details
+ *
+ * @brief Instruction::moveFrom
+ * @param other
+ */
+void Instruction::moveFrom(Instruction &other) noexcept {
+	valid_ = std::exchange(other.valid_, false);
+	byte0_ = std::exchange(other.byte0_, 0);
+	rva_   = std::exchange(other.rva_, 0);
+
+	if (valid_) {
+		insn_ = other.insn_;
+		if (other.insn_.detail) {
+			detail_      = other.detail_;
+			insn_.detail = &detail_;
+		}
 	}
 }
 
-Instruction::Instruction(const void *first, const void *last, uint64_t rva) noexcept
+Instruction::Instruction(const void *first, const void *last, uint64_t rva, Mode mode) noexcept
 	: rva_(rva) {
 	assert(capstoneInitialized);
 	auto codeBegin = static_cast<const uint8_t *>(first);
@@ -276,20 +526,40 @@ Instruction::Instruction(const void *first, const void *last, uint64_t rva) noex
 
 	byte0_ = codeBegin[0];
 
-	cs_insn *insn = nullptr;
-	if (first < last && cs_disasm(csh, codeBegin, codeEnd - codeBegin, rva, 1, &insn)) {
-		insn_ = insn;
+	if (first >= last) {
+		return;
+	}
+
+	const csh handle = threadHandles.handle(mode);
+	if (!handle) {
+		return;
+	}
+
+	// capstone fills in whatever insn.detail points at, so
+	// rather than using storage from cs_malloc, we let it use our own
+	size_t size      = codeEnd - codeBegin;
+	uint64_t address = rva;
+	insn_.detail     = &detail_;
+
+	if (!cs_disasm_iter(handle, &codeBegin, &size, &address, &insn_)) {
+		return;
+	}
+
+	valid_ = true;
+
+	if (mode == Mode::Basic) {
+		insn_.detail = nullptr;
+		return;
+	}
+
 #if defined(EDB_ARM32)
-		if (insn_->detail->arm.op_count >= 2) {
-			// XXX: this is a work around capstone bug #1013
-			auto &op = insn_->detail->arm.operands[1];
-			if (op.type == ARM_OP_MEM && op.subtracted && op.mem.scale == 1)
-				op.mem.scale = -1;
-		}
-#endif
-	} else {
-		insn_ = nullptr;
+	if (insn_.detail->arm.op_count >= 2) {
+		// XXX: this is a work around capstone bug #1013
+		auto &op = insn_.detail->arm.operands[1];
+		if (op.type == ARM_OP_MEM && op.subtracted && op.mem.scale == 1)
+			op.mem.scale = -1;
 	}
+#endif
 }
 
 Operand Instruction::operator[](size_t n) const {
@@ -302,9 +572,9 @@ Operand Instruction::operator[](size_t n) const {
 	}
 
 #if defined(EDB_X86) || defined(EDB_X86_64)
-	return Operand(this, &insn_->detail->x86.operands[n], n);
+	return Operand(this, &insn_.detail->x86.operands[n], n);
 #elif defined(EDB_ARM32) || defined(EDB_ARM64)
-	return Operand(this, &insn_->detail->arm.operands[n], n);
+	return Operand(this, &insn_.detail->arm.operands[n], n);
 #else
 #error "What to return here?"
 #endif
@@ -320,9 +590,9 @@ Operand Instruction::operand(size_t n) const {
 	}
 
 #if defined(EDB_X86) || defined(EDB_X86_64)
-	return Operand(this, &insn_->detail->x86.operands[n], n);
+	return Operand(this, &insn_.detail->x86.operands[n], n);
 #elif defined(EDB_ARM32) || defined(EDB_ARM64)
-	return Operand(this, &insn_->detail->arm.operands[n], n);
+	return Operand(this, &insn_.detail->arm.operands[n], n);
 #else
 #error "What to return here?"
 #endif
@@ -358,8 +628,8 @@ Instruction::ConditionCode Instruction::conditionCode() const {
 		return CC_P;
 	// TODO: handle LOOPcc, REPcc OP
 	default:
-		if (is_conditional_gpr_move(*this) || is_conditional_jump(*this) || is_conditional_set(*this)) {
-			const uint8_t *opcode = insn_->detail->x86.opcode;
+		if (hasDetail() && (is_conditional_gpr_move(*this) || is_conditional_jump(*this) || is_conditional_set(*this))) {
+			const uint8_t *opcode = insn_.detail->x86.opcode;
 			if (opcode[0] == 0x0f) {
 				return static_cast<ConditionCode>(opcode[1] & 0xf);
 			}
@@ -368,7 +638,11 @@ Instruction::ConditionCode Instruction::conditionCode() const {
 	}
 	return CC_UNCONDITIONAL;
 #elif defined(EDB_ARM32)
-	switch (insn_->detail->arm.cc) {
+	if (!hasDetail()) {
+		return CC_AL;
+	}
+
+	switch (insn_.detail->arm.cc) {
 	case ARM_CC_EQ:
 		return CC_EQ;
 	case ARM_CC_NE:
@@ -408,34 +682,63 @@ Instruction::ConditionCode Instruction::conditionCode() const {
 }
 
 void Instruction::swap(Instruction &other) {
-	using std::swap;
-	swap(insn_, other.insn_);
-	swap(byte0_, other.byte0_);
-	swap(rva_, other.rva_);
+	Instruction temp(std::move(other));
+	other = std::move(*this);
+	*this = std::move(temp);
 }
 
-QString Formatter::adjustInstructionText(const Instruction &insn) const {
-	QString operands(insn->op_str);
+void Formatter::adjustInstructionText(const Instruction &insn, std::string *str, std::size_t first) const {
+
+	// this used to be a handful of regex replacements, which was
+	// a lot of work for every instruction we display. The helpers match exactly
+	// what those did, but edit the string in place
 
 	// Remove extra spaces
-	operands.replace(" + ", "+");
-	operands.replace(" - ", "-");
+	replace_all(str, first, " + ", "+");
+	replace_all(str, first, " - ", "-");
 
-	operands.replace(QRegExp("\\bxword "), "tbyte ");
-	operands.replace(QRegExp("(word|byte) ptr "), "\\1 ");
+	for (std::size_t pos = str->find("xword ", first); pos != std::string::npos; pos = str->find("xword ", pos + 1)) {
+		if (is_word_boundary(*str, pos)) {
+			str->replace(pos, 5, "tbyte");
+		}
+	}
+
+	for (std::size_t pos = str->find(" ptr ", first); pos != std::string::npos; pos = str->find(" ptr ", pos + 1)) {
+		if (pos >= first + 4 && (matches_at(*str, pos - 4, "word") || matches_at(*str, pos - 4, "byte"))) {
+			str->erase(pos + 1, 4);
+		}
+	}
 
 #if defined(EDB_X86) || defined(EDB_X86_64)
-	if (activeFormatter.options().simplifyRIPRelativeTargets && isX86_64() && (insn->detail->x86.modrm & 0xc7) == 0x05) {
-		QRegExp ripRel("\\brip ?[+-] ?((0x)?[0-9a-fA-F]+)\\b");
-		operands.replace(ripRel, "rel 0x" + QString::number(insn->detail->x86.disp + insn->address + insn->size, 16));
+	if (activeFormatter.options().simplifyRIPRelativeTargets && isX86_64() && insn.hasDetail() && (insn->detail->x86.modrm & 0xc7) == 0x05) {
+		char target[32];
+		snprintf(target, sizeof(target), "rel 0x%" PRIx64, static_cast<uint64_t>(insn->detail->x86.disp + insn->address + insn->size));
+
+		for (std::size_t pos = str->find("rip", first); pos != std::string::npos; pos = str->find("rip", pos + 1)) {
+			if (const std::size_t n = rip_relative_length(*str, pos)) {
+				str->replace(pos, n, target);
+			}
+		}
 	}
 
 	if (insn.operandCount() == 2 && insn->id != X86_INS_MOVZX && insn->id != X86_INS_MOVSX &&
 		((insn[0]->type == X86_OP_REG && insn[1]->type == X86_OP_MEM) || (insn[1]->type == X86_OP_REG && insn[0]->type == X86_OP_MEM))) {
-		operands.replace(QRegExp("(\\b.?(mm)?word|byte)\\b( ptr)? "), "");
+
+		// we only ever remove characters, so this can be done in place
+		std::size_t out = first;
+		for (std::size_t in = first; in < str->size();) {
+			if (const std::size_t n = size_specifier_length(*str, in)) {
+				in += n;
+			} else {
+				(*str)[out++] = (*str)[in++];
+			}
+		}
+
+		str->resize(out);
 	}
+#else
+	(void)insn;
 #endif
-	return operands;
 }
 
 void Formatter::setOptions(const Formatter::FormatOptions &options) {
@@ -444,25 +747,32 @@ void Formatter::setOptions(const Formatter::FormatOptions &options) {
 	options_ = options;
 
 #if defined(EDB_X86) || defined(EDB_X86_64)
-	if (options.syntax == SyntaxAtt) {
-		cs_option(csh, CS_OPT_SYNTAX, CS_OPT_SYNTAX_ATT);
-	} else {
-		cs_option(csh, CS_OPT_SYNTAX, CS_OPT_SYNTAX_INTEL);
+	// every thread picks up the new syntax when it reopens its handles
+	const bool att = (options.syntax == SyntaxAtt);
+	if (capstoneAttSyntax.exchange(att) != att) {
+		capstoneGeneration.fetch_add(1, std::memory_order_acq_rel);
 	}
-#elif defined(EDB_ARM32) // FIXME(ARM): does this apply to AArch64?
-	// TODO: make this optional. Don't forget to reflect this in register view!
-	cs_option(csh, CS_OPT_SYNTAX, CS_OPT_SYNTAX_NOREGNAME);
 #endif
 
+	formatGeneration.fetch_add(1, std::memory_order_acq_rel);
 	activeFormatter = *this;
 }
 
 std::string Formatter::toString(const Instruction &insn) const {
+	std::string str;
+	toString(insn, &str);
+	return str;
+}
+
+void Formatter::toString(const Instruction &insn, std::string *buffer) const {
 	enum {
 		Tab1Size = 8,
 		Tab2Size = 11,
 	};
 
+	assert(buffer);
+	buffer->clear();
+
 	if (!insn) {
 		char buf[32];
 		if (options_.tabBetweenMnemonicAndOperands) {
@@ -471,45 +781,54 @@ std::string Formatter::toString(const Instruction &insn) const {
 			snprintf(buf, sizeof(buf), "db 0x%02x", insn.byte0_);
 		}
 
-		std::string str(buf);
-		checkCapitalize(str);
-		return str;
+		buffer->append(buf);
+		checkCapitalize(*buffer);
+		return;
 	}
 
-	std::ostringstream s;
-	s << insn->mnemonic;
-	std::string space = " ";
-	if (options_.tabBetweenMnemonicAndOperands) {
-		const auto pos = s.tellp();
-		const auto pad = pos < Tab1Size ? Tab1Size - pos : pos < Tab2Size ? Tab2Size - pos
-																		  : 1;
+	buffer->append(insn->mnemonic);
 
-		space = std::string(pad, ' ');
+	std::size_t pad = 1;
+	if (options_.tabBetweenMnemonicAndOperands) {
+		const std::size_t pos = buffer->size();
+		pad                   = pos < Tab1Size ? Tab1Size - pos : pos < Tab2Size ? Tab2Size - pos
+																				  : 1;
 	}
 
 	if (insn.operandCount() > 0) {
 		// prevent addition of trailing whitespace
-		s << space << adjustInstructionText(insn).toStdString();
+		buffer->append(pad, ' ');
+		const std::size_t first = buffer->size();
+		buffer->append(insn->op_str);
+		adjustInstructionText(insn, buffer, first);
 	} else if (insn->op_str[0] != 0) {
 		// This may happen for instructions like IT in Thumb-2: e.g. ITT NE
-		s << space << insn->op_str;
+		buffer->append(pad, ' ');
+		buffer->append(insn->op_str);
 	}
 
-	auto str = s.str();
-	checkCapitalize(str);
-	return str;
+	checkCapitalize(*buffer);
 }
 
 void Formatter::checkCapitalize(std::string &str, bool canContainHex) const {
 	if (options_.capitalization == UpperCase) {
 		std::transform(str.begin(), str.end(), str.begin(), ::toupper);
 		if (canContainHex) {
-			auto qstr = QString::fromStdString(str);
+			// hex numbers keep their lower case "0x" prefix, "\b0X([0-9A-F]+)\b"
+			for (std::size_t pos = str.find("0X"); pos != std::string::npos; pos = str.find("0X", pos + 2)) {
+				if (!is_word_boundary(str, pos)) {
+					continue;
+				}
 
-			static const QRegularExpression re("\\b0X([0-9A-F]+)\\b");
-			qstr.replace(re, "0x\\1");
+				std::size_t end = pos + 2;
+				while (end < str.size() && is_hex_char(str[end])) {
+					++end;
+				}
 
-			str = qstr.toStdString();
+				if (end != pos + 2 && (end == str.size() || !is_word_char(str[end]))) {
+					str[pos + 1] = 'x';
+				}
+			}
 		}
 	}
 }
@@ -555,7 +874,7 @@ std::string Formatter::toString(const Operand &operand) const {
 
 std::string Formatter::registerName(unsigned int reg) const {
 	assert(capstoneInitialized);
-	const char *raw = cs_reg_name(csh, reg);
+	const char *raw = cs_reg_name(threadHandles.handle(Instruction::Mode::Full), reg);
 	if (!raw) {
 		return "(invalid register)";
 	}
@@ -1183,21 +1502,21 @@ bool is_return(const Instruction &insn) {
 	if (!insn) {
 		return false;
 	}
-	return cs_insn_group(csh, insn.native(), CS_GRP_RET);
+	return cs_insn_group(threadHandles.handle(Instruction::Mode::Full), insn.native(), CS_GRP_RET);
 }
 
 bool is_jump(const Instruction &insn) {
 	if (!insn) {
 		return false;
 	}
-	return cs_insn_group(csh, insn.native(), CS_GRP_JUMP);
+	return cs_insn_group(threadHandles.handle(Instruction::Mode::Full), insn.native(), CS_GRP_JUMP);
 }
 
 bool is_call(const Instruction &insn) {
 	if (!insn) {
 		return false;
 	}
-	return cs_insn_group(csh, insn.native(), CS_GRP_CALL);
+	return cs_insn_group(threadHandles.handle(Instruction::Mode::Full), insn.native(), CS_GRP_CALL);
 }
 
 bool modifies_pc(const Instruction &insn) {
@@ -0,0 +1,601 @@
+
+#include "LengthDecoder.h"
+#include "Instruction.h"
+#include <algorithm>
+#include <cstddef>
+
+#if defined(EDB_X86) || defined(EDB_X86_64)
+
+namespace CapstoneEDB {
+
+namespace {
+
+constexpr std::size_t MaxInstructionSize = 15;
+
+// what follows an opcode byte
+enum : uint8_t {
+	M   = 0x01, // a ModRM byte (plus SIB and displacement)
+	I8  = 0x02, // an 8-bit immediate
+	I16 = 0x04, // a 16-bit immediate
+	IZ  = 0x08, // a 16 or 32-bit immediate, depending on the operand size
+	X   = 0x10, // needs special handling
+	N64 = 0x20, // invalid in 64-bit mode
+	U   = 0x40, // not something we know about
+};
+
+// clang-format off
+constexpr uint8_t OneByteMap[256] = {
+	/* 00 */ M,      M,      M,      M,      I8,     IZ,     N64,    N64,    M,      M,      M,      M,      I8,     IZ,     N64,    0,
+	/* 10 */ M,      M,      M,      M,      I8,     IZ,     N64,    N64,    M,      M,      M,      M,      I8,     IZ,     N64,    N64,
+	/* 20 */ M,      M,      M,      M,      I8,     IZ,     U,      N64,    M,      M,      M,      M,      I8,     IZ,     U,      N64,
+	/* 30 */ M,      M,      M,      M,      I8,     IZ,     U,      N64,    M,      M,      M,      M,      I8,     IZ,     U,      N64,
+	/* 40 */ 0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,
+	/* 50 */ 0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,
+	/* 60 */ N64,    N64,    M | X,  M,      U,      U,      U,      U,      IZ,     M | IZ, I8,     M | I8, 0,      0,      0,      0,
+	/* 70 */ I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,
+	/* 80 */ M | I8, M | IZ, M | I8 | N64,   M | I8, M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M | X,
+	/* 90 */ 0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      X | N64,0,      0,      0,      0,      0,
+	/* A0 */ X,      X,      X,      X,      0,      0,      0,      0,      I8,     IZ,     0,      0,      0,      0,      0,      0,
+	/* B0 */ I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     X,      X,      X,      X,      X,      X,      X,      X,
+	/* C0 */ M | I8, M | I8, I16,    0,      M | X,  M | X,  M | X,  M | X,  I16|I8, 0,      I16,    0,      0,      I8,     N64,    0,
+	/* D0 */ M,      M,      M,      M,      I8|N64, I8|N64, N64,    0,      M,      M,      M,      M,      M,      M,      M,      M,
+	/* E0 */ I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     IZ,     IZ,     X | N64,I8,     0,      0,      0,      0,
+	/* F0 */ U,      0,      U,      U,      0,      0,      M | X,  M | X,  0,      0,      0,      0,      0,      0,      M | X,  M | X,
+};
+
+constexpr uint8_t TwoByteMap[256] = {
+	/* 00 */ M,      M,      M,      M,      U,      0,      0,      0,      0,      0,      U,      0,      U,      M,      0,      M | I8,
+	/* 10 */ M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+	/* 20 */ M | X,  M | X,  M | X,  M | X,  U,      U,      U,      U,      M,      M,      M,      M,      M,      M,      M,      M,
+	/* 30 */ 0,      0,      0,      0,      0,      0,      U,      0,      X,      U,      X,      U,      U,      U,      U,      U,
+	/* 40 */ M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+	/* 50 */ M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+	/* 60 */ M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+	/* 70 */ M | I8, M | I8, M | I8, M | I8, M,      M,      M,      0,      M | X,  M,      U,      U,      M,      M,      M,      M,
+	/* 80 */ IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,
+	/* 90 */ M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+	/* A0 */ 0,      0,      0,      M,      M | I8, M,      U,      U,      0,      0,      0,      M,      M | I8, M,      M,      M,
+	/* B0 */ M,      M,      M,      M,      M,      M,      M,      M,      M | X,  M,      M | I8, M,      M,      M,      M,      M,
+	/* C0 */ M,      M,      M | I8, M,      M | I8, M | I8, M | I8, M,      0,      0,      0,      0,      0,      0,      0,      0,
+	/* D0 */ M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+	/* E0 */ M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+	/* F0 */ M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,
+};
+// clang-format on
+
+// the opcode maps as VEX and EVEX number them
+enum OpcodeMap {
+	Map0F   = 1,
+	Map0F38 = 2,
+	Map0F3A = 3,
+};
+
+struct Prefixes {
+	bool operandSize = false; // 66
+	bool addressSize = false; // 67
+	bool rep         = false; // F3
+	bool repne       = false; // F2
+	bool lock        = false; // F0
+	uint8_t rex      = 0;
+};
+
+/**
+ * @brief apply_prefix
+ * @param prefixes
+ * @param byte
+ * @return false if <byte> is not a legacy prefix
+ */
+bool apply_prefix(Prefixes *prefixes, uint8_t byte) {
+	switch (byte) {
+	case 0x66:
+		prefixes->operandSize = true;
+		return true;
+	case 0x67:
+		prefixes->addressSize = true;
+		return true;
+	case 0xf0:
+		prefixes->lock = true;
+		return true;
+	case 0xf2:
+		prefixes->repne = true;
+		return true;
+	case 0xf3:
+		prefixes->rep = true;
+		return true;
+	case 0x26:
+	case 0x2e:
+	case 0x36:
+	case 0x3e:
+	case 0x64:
+	case 0x65:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * @brief modrm_size
+ * @param p points at the ModRM byte
+ * @param end
+ * @param address16 true when using 16-bit addressing
+ * @return the size of the ModRM byte, the SIB byte and the displacement
+ * together, 0 if they don't fit before <end>
+ */
+std::size_t modrm_size(const uint8_t *p, const uint8_t *end, bool address16) {
+
+	if (p >= end) {
+		return 0;
+	}
+
+	const uint8_t modrm = p[0];
+	const uint8_t mod   = modrm >> 6;
+	const uint8_t rm    = modrm & 0x07;
+
+	std::size_t size = 1;
+
+	if (mod != 3) {
+		if (address16) {
+			if ((mod == 0 && rm == 6) || mod == 2) {
+				size += 2;
+			} else if (mod == 1) {
+				size += 1;
+			}
+		} else {
+			if (rm == 4) {
+				if (p + 1 >= end) {
+					return 0;
+				}
+
+				++size;
+				if (mod == 0 && (p[1] & 0x07) == 5) {
+					size += 4;
+				}
+			}
+
+			if (mod == 0 && rm == 5) {
+				size += 4;
+			} else if (mod == 1) {
+				size += 1;
+			} else if (mod == 2) {
+				size += 4;
+			}
+		}
+	}
+
+	return (p + size <= end) ? size : 0;
+}
+
+/**
+ * @brief read_immediate
+ * @param p
+ * @param size
+ * @return the little endian value of <size> bytes at <p>, sign extended
+ */
+int64_t read_immediate(const uint8_t *p, std::size_t size) {
+
+	if (size == 0) {
+		return 0;
+	}
+
+	uint64_t value = 0;
+	for (std::size_t i = 0; i < size; ++i) {
+		value |= static_cast<uint64_t>(p[i]) << (i * 8);
+	}
+
+	const unsigned int shift = 64 - static_cast<unsigned int>(size * 8);
+	return static_cast<int64_t>(value << shift) >> shift;
+}
+
+/**
+ * @brief vex_flags
+ * @param map
+ * @param opcode
+ * @return what follows the opcode of a VEX or EVEX encoded instruction
+ */
+uint8_t vex_flags(unsigned int map, uint8_t opcode) {
+	switch (map) {
+	case Map0F:
+		switch (opcode) {
+		case 0x70:
+		case 0x71:
+		case 0x72:
+		case 0x73:
+		case 0xc2:
+		case 0xc4:
+		case 0xc5:
+		case 0xc6:
+			return M | I8;
+		default:
+			return M;
+		}
+	case Map0F38:
+		return M;
+	case Map0F3A:
+		return M | I8;
+	default:
+		return U;
+	}
+}
+
+/**
+ * @brief flow_of
+ * @param map 0 for the one byte opcode map
+ * @param opcode
+ * @param modrm only meaningful for opcodes which have one
+ * @return
+ */
+Flow flow_of(unsigned int map, uint8_t opcode, uint8_t modrm) {
+
+	if (map == Map0F) {
+		if (opcode >= 0x80 && opcode <= 0x8f) {
+			return Flow::ConditionalJump;
+		}
+
+		switch (opcode) {
+		case 0x05: // syscall
+		case 0x07: // sysret
+		case 0x34: // sysenter
+		case 0x35: // sysexit
+			return Flow::Syscall;
+		default:
+			return Flow::None;
+		}
+	}
+
+	if (map != 0) {
+		return Flow::None;
+	}
+
+	if (opcode >= 0x70 && opcode <= 0x7f) {
+		return Flow::ConditionalJump;
+	}
+
+	switch (opcode) {
+	case 0xe0: // loopne
+	case 0xe1: // loope
+	case 0xe2: // loop
+	case 0xe3: // jcxz
+		return Flow::ConditionalJump;
+	case 0x9a:
+	case 0xe8:
+		return Flow::Call;
+	case 0xe9:
+	case 0xea:
+	case 0xeb:
+		return Flow::Jump;
+	case 0xc2:
+	case 0xc3:
+	case 0xca:
+	case 0xcb:
+	case 0xcf:
+		return Flow::Return;
+	case 0xcc:
+	case 0xcd:
+	case 0xce:
+	case 0xf1:
+		return Flow::Interrupt;
+	case 0xff:
+		switch ((modrm >> 3) & 0x07) {
+		case 2:
+		case 3:
+			return Flow::Call;
+		case 4:
+		case 5:
+			return Flow::Jump;
+		default:
+			return Flow::None;
+		}
+	default:
+		return Flow::None;
+	}
+}
+
+/**
+ * @brief is_relative_branch
+ * @param map
+ * @param opcode
+ * @return true if the immediate of the instruction is a branch displacement
+ */
+bool is_relative_branch(unsigned int map, uint8_t opcode) {
+	if (map == Map0F) {
+		return opcode >= 0x80 && opcode <= 0x8f;
+	}
+
+	return map == 0 && ((opcode >= 0x70 && opcode <= 0x7f) || (opcode >= 0xe0 && opcode <= 0xe3) || opcode == 0xe8 || opcode == 0xe9 || opcode == 0xeb);
+}
+
+}
+
+/**
+ * @brief decode_length
+ * @param first
+ * @param last
+ * @param rva
+ * @param x86_64
+ * @return
+ */
+LengthInfo decode_length(const void *first, const void *last, uint64_t rva, bool x86_64) noexcept {
+
+	const auto start         = static_cast<const uint8_t *>(first);
+	const uint8_t *const end = start + std::min<std::size_t>(static_cast<const uint8_t *>(last) - start, MaxInstructionSize);
+	const uint8_t *p         = start;
+
+	// legacy prefixes, and REX which has to come right before the opcode
+	Prefixes prefixes;
+	for (; p < end; ++p) {
+		// decoders disagree about what a REX prefix followed by
+		// another prefix means, so we don't guess
+		if (x86_64 && (*p & 0xf0) == 0x40) {
+			if (prefixes.rex) {
+				return {};
+			}
+
+			prefixes.rex = *p;
+			continue;
+		}
+
+		if (!apply_prefix(&prefixes, *p)) {
+			break;
+		}
+
+		if (prefixes.rex) {
+			return {};
+		}
+	}
+
+	if (p >= end) {
+		return {};
+	}
+
+	// some disassemblers fold a prefixed fwait into the x87
+	// instruction which follows it, others don't
+	if (*p == 0x9b && p != start) {
+		return {};
+	}
+
+	const bool address16 = !x86_64 && prefixes.addressSize;
+	const bool operand16 = prefixes.operandSize && !(prefixes.rex & 0x08);
+
+	unsigned int map = 0;
+	uint8_t opcode   = *p++;
+	uint8_t flags    = 0;
+	bool extended    = false; // VEX or EVEX
+
+	if (opcode == 0x0f) {
+		if (p >= end) {
+			return {};
+		}
+
+		opcode = *p++;
+		map    = Map0F;
+		flags  = TwoByteMap[opcode];
+
+		if (opcode == 0x38 || opcode == 0x3a) {
+			if (p >= end) {
+				return {};
+			}
+
+			map    = (opcode == 0x38) ? Map0F38 : Map0F3A;
+			opcode = *p++;
+			flags  = (map == Map0F38) ? M : M | I8;
+		}
+	} else {
+		flags = OneByteMap[opcode];
+
+		const bool vex  = (opcode == 0xc4 || opcode == 0xc5);
+		const bool evex = (opcode == 0x62);
+
+		// outside of 64-bit mode, these are LES, LDS and BOUND
+		// unless the following byte would be a register operand
+		if ((vex || evex) && p < end && (x86_64 || (*p & 0xc0) == 0xc0)) {
+
+			if (prefixes.operandSize || prefixes.rep || prefixes.repne || prefixes.lock || prefixes.rex) {
+				return {};
+			}
+
+			const std::size_t prefix_size = (opcode == 0xc5) ? 1 : (opcode == 0xc4) ? 2 : 3;
+			if (p + prefix_size >= end) {
+				return {};
+			}
+
+			if (opcode == 0xc5) {
+				map = Map0F;
+			} else if (opcode == 0xc4) {
+				map = p[0] & 0x1f;
+			} else {
+				map = p[0] & 0x07;
+			}
+
+			p += prefix_size;
+			opcode   = *p++;
+			flags    = vex_flags(map, opcode);
+			extended = true;
+
+			// vzeroupper and vzeroall have no ModRM byte
+			if (opcode == 0x77 && map == Map0F && vex) {
+				flags = 0;
+			}
+		}
+	}
+
+	if (flags & U) {
+		return {};
+	}
+
+	if (x86_64 && (flags & N64) && map == 0) {
+		return {};
+	}
+
+	std::size_t immediate_size = 0;
+	uint8_t modrm              = 0;
+
+	if (flags & X) {
+		if (map == 0) {
+			switch (opcode) {
+			case 0x8f:
+				// XOP, which capstone may or may not know about
+				if (p < end && (*p & 0x1f) >= 8) {
+					return {};
+				}
+				if (p < end && (*p & 0x38) != 0) {
+					return {};
+				}
+				break;
+			case 0x9a:
+			case 0xea:
+				// far pointer
+				immediate_size = operand16 ? 4 : 6;
+				break;
+			case 0xa0:
+			case 0xa1:
+			case 0xa2:
+			case 0xa3:
+				// memory offset
+				if (x86_64) {
+					immediate_size = prefixes.addressSize ? 4 : 8;
+				} else {
+					immediate_size = prefixes.addressSize ? 2 : 4;
+				}
+				break;
+			case 0xb8:
+			case 0xb9:
+			case 0xba:
+			case 0xbb:
+			case 0xbc:
+			case 0xbd:
+			case 0xbe:
+			case 0xbf:
+				if (prefixes.rex & 0x08) {
+					immediate_size = 8;
+				} else {
+					immediate_size = operand16 ? 2 : 4;
+				}
+				break;
+			case 0xc6:
+			case 0xc7:
+				// only /0, and xabort/xbegin
+				if (p < end && (*p & 0x38) != 0 && *p != 0xf8) {
+					return {};
+				}
+				flags |= (opcode == 0xc6) ? I8 : IZ;
+				break;
+			case 0xf6:
+			case 0xf7:
+				// test has an immediate, the rest of group 3 doesn't
+				if (p < end && (*p & 0x38) <= 0x08) {
+					flags |= (opcode == 0xf6) ? I8 : IZ;
+				}
+				break;
+			case 0xfe:
+				if (p < end && (*p & 0x38) > 0x08) {
+					return {};
+				}
+				break;
+			case 0xff:
+				// far calls and jumps need a memory operand
+				if (p < end && ((*p & 0x38) == 0x38 || ((*p & 0xc0) == 0xc0 && ((*p & 0x38) == 0x18 || (*p & 0x38) == 0x28)))) {
+					return {};
+				}
+				break;
+			}
+		} else if (map == Map0F) {
+			switch (opcode) {
+			case 0x20:
+			case 0x21:
+			case 0x22:
+			case 0x23:
+				// moves to and from control and debug registers always use the
+				// register form, whatever the mod bits say
+				if (p >= end) {
+					return {};
+				}
+				modrm = *p++;
+				flags &= ~M;
+				break;
+			case 0x78:
+				// extrq and insertq have two immediates, vmread has none
+				if (prefixes.operandSize || prefixes.repne) {
+					immediate_size = 2;
+				}
+				break;
+			case 0xb8:
+				// popcnt, without F3 this would be jmpe
+				if (!prefixes.rep) {
+					return {};
+				}
+				break;
+			}
+		}
+	}
+
+	if (flags & M) {
+		const std::size_t size = modrm_size(p, end, address16);
+		if (size == 0) {
+			return {};
+		}
+
+		modrm = *p;
+		p += size;
+	}
+
+	const bool relative = !extended && is_relative_branch(map, opcode);
+
+	// Intel and AMD CPUs disagree about the operand size prefix
+	// on relative branches in 64-bit mode, so does everyone disassembling them
+	if (relative && x86_64 && prefixes.operandSize) {
+		return {};
+	}
+
+	if (flags & I16) {
+		if (flags & I8) {
+			// enter has two immediates, we only report the second one
+			p += 2;
+		} else {
+			immediate_size = 2;
+		}
+	}
+
+	if (flags & I8) {
+		immediate_size = 1;
+	} else if (flags & IZ) {
+		immediate_size = operand16 ? 2 : 4;
+	}
+
+	if (p + immediate_size > end) {
+		return {};
+	}
+
+	LengthInfo info;
+	info.size          = static_cast<uint8_t>(p + immediate_size - start);
+	info.immediateSize = static_cast<uint8_t>(immediate_size);
+	info.flow          = extended ? Flow::None : flow_of(map, opcode, modrm);
+	info.immediate     = read_immediate(p, immediate_size);
+
+	if (relative) {
+		uint64_t target = rva + info.size + static_cast<uint64_t>(info.immediate);
+		if (!x86_64) {
+			target &= (immediate_size == 2) ? 0xffff : 0xffffffff;
+		}
+
+		info.hasTarget = true;
+		info.target    = target;
+	}
+
+	return info;
+}
+
+/**
+ * @brief decode_length
+ * @param first
+ * @param last
+ * @param rva
+ * @return
+ */
+LengthInfo decode_length(const void *first, const void *last, uint64_t rva) noexcept {
+	return decode_length(first, last, rva, architecture() == Architecture::ARCH_AMD64);
+}
+
+}
+
+#endif
@@ -3,8 +3,8 @@
 #define FORMATTER_H_20191119_
 
 #include "API.h"
+#include <cstddef>
 #include <string>
-class QString;
 
 namespace CapstoneEDB {
 
@@ -32,6 +32,7 @@ public:
 
 public:
 	[[nodiscard]] std::string toString(const Instruction &insn) const;
+	void toString(const Instruction &insn, std::string *buffer) const;
 	[[nodiscard]] std::string toString(const Operand &operand) const;
 	[[nodiscard]] std::string registerName(unsigned int reg) const;
 
@@ -43,7 +44,7 @@ public:
 
 private:
 	void checkCapitalize(std::string &str, bool canContainHex = true) const;
-	[[nodiscard]] QString adjustInstructionText(const Instruction &insn) const;
+	void adjustInstructionText(const Instruction &insn, std::string *str, std::size_t first) const;
 
 private:
 	FormatOptions options_ = {SyntaxIntel, LowerCase, false, true};
@@ -38,6 +38,11 @@ enum class Architecture {
 };
 
 bool init(Architecture arch);
+Architecture architecture();
+
+// changes whenever the architecture or the formatting options do, anything
+// which remembers decoded or formatted instructions must forget them then
+uint64_t generation();
 
 class Instruction;
 class Formatter;
@@ -54,16 +59,24 @@ public:
 #endif
 
 public:
-	Instruction(const void *first, const void *last, uint64_t rva) noexcept;
+	// how much capstone should tell us about an instruction
+	enum class Mode {
+		Full,  // everything, operands, groups, registers...
+		Basic, // only the size, id, bytes, mnemonic and operand text. Nothing
+		       // which needs the details (operands, Inspection.h) may be used
+	};
+
+public:
+	Instruction(const void *first, const void *last, uint64_t rva, Mode mode = Mode::Full) noexcept;
 	Instruction(const Instruction &)            = delete;
 	Instruction &operator=(const Instruction &) = delete;
 	Instruction(Instruction &&) noexcept;
 	Instruction &operator=(Instruction &&) noexcept;
-	~Instruction();
+	~Instruction() = default;
 
 public:
 	[[nodiscard]] bool valid() const {
-		return insn_;
+		return valid_;
 	}
 
 	[[nodiscard]] explicit operator bool() const {
@@ -71,20 +84,21 @@ public:
 	}
 
 public:
-	[[nodiscard]] unsigned int operation() const { return insn_ ? insn_->id : 0; }
+	[[nodiscard]] unsigned int operation() const { return valid_ ? insn_.id : 0; }
 	[[nodiscard]] std::size_t operandCount() const {
 #if defined(EDB_X86) || defined(EDB_X86_64)
-		return insn_ ? insn_->detail->x86.op_count : 0;
+		return hasDetail() ? insn_.detail->x86.op_count : 0;
 #elif defined(EDB_ARM32) || defined(EDB_ARM64)
-		return insn_ ? insn_->detail->arm.op_count : 0;
+		return hasDetail() ? insn_.detail->arm.op_count : 0;
 #else
 #error "What to return here?"
 #endif
 	}
-	[[nodiscard]] std::size_t byteSize() const { return insn_ ? insn_->size : 1; }
-	[[nodiscard]] uint64_t rva() const { return insn_ ? insn_->address : rva_; }
-	[[nodiscard]] std::string mnemonic() const { return insn_ ? insn_->mnemonic : std::string(); }
-	[[nodiscard]] const uint8_t *bytes() const { return insn_ ? insn_->bytes : &byte0_; }
+	[[nodiscard]] std::size_t byteSize() const { return valid_ ? insn_.size : 1; }
+	[[nodiscard]] uint64_t rva() const { return valid_ ? insn_.address : rva_; }
+	[[nodiscard]] std::string mnemonic() const { return valid_ ? insn_.mnemonic : std::string(); }
+	[[nodiscard]] const uint8_t *bytes() const { return valid_ ? insn_.bytes : &byte0_; }
+	[[nodiscard]] bool hasDetail() const { return valid_ && insn_.detail; }
 
 public:
 	[[nodiscard]] Operand operator[](size_t n) const;
@@ -92,12 +106,12 @@ public:
 
 public:
 	[[nodiscard]] const cs_insn *native() const {
-		return insn_;
+		return valid_ ? &insn_ : nullptr;
 	}
 
 public:
-	cs_insn *operator->() { return insn_; }
-	const cs_insn *operator->() const { return insn_; }
+	cs_insn *operator->() { return valid_ ? &insn_ : nullptr; }
+	const cs_insn *operator->() const { return valid_ ? &insn_ : nullptr; }
 
 public:
 	void swap(Instruction &other);
@@ -161,7 +175,15 @@ public:
 	[[nodiscard]] ConditionCode conditionCode() const;
 
 private:
-	cs_insn *insn_ = nullptr;
+	void moveFrom(Instruction &other) noexcept;
+
+private:
+	// capstone decodes straight into these, so an instruction never needs any
+	// memory of its own. insn_.detail points at detail_ (or is nullptr when
+	// decoded in Mode::Basic)
+	cs_insn insn_;
+	cs_detail detail_;
+	bool valid_ = false;
 
 	// we have our own copies of this data so we can give something meaningful
 	// even during a failed disassembly
@@ -0,0 +1,49 @@
+
+#ifndef LENGTH_DECODER_H_20240301_
+#define LENGTH_DECODER_H_20240301_
+
+#include "API.h"
+#include <cstdint>
+
+namespace CapstoneEDB {
+
+#if defined(EDB_X86) || defined(EDB_X86_64)
+
+// A small table driven x86/x86-64 decoder for code which looks at every byte
+// offset of a region and only needs to know how long an instruction is, or
+// whether it transfers control. It knows nothing about operands beyond the
+// immediate, so anything more than that still needs a real Instruction.
+//
+// When the decoder is not sure what capstone would make of the bytes (invalid
+// opcodes, XOP, unusual prefix combinations...) it reports a size of 0 and
+// the caller should decode them with capstone instead.
+
+enum class Flow : uint8_t {
+	None,
+	Call,            // near or far, direct or indirect
+	Jump,            // near or far, direct or indirect
+	ConditionalJump, // jcc, loop and jcxz
+	Return,          // ret, retf and iret
+	Interrupt,       // int, int1, int3 and into
+	Syscall,         // syscall, sysenter, sysret and sysexit
+};
+
+struct LengthInfo {
+	uint8_t size          = 0; // 0 if unknown to the decoder
+	uint8_t immediateSize = 0; // size of the last immediate, 0 if there is none
+	Flow flow             = Flow::None;
+	bool hasTarget        = false; // relative calls and jumps
+	int64_t immediate     = 0;     // sign extended
+	uint64_t target       = 0;
+};
+
+EDB_EXPORT LengthInfo decode_length(const void *first, const void *last, uint64_t rva, bool x86_64) noexcept;
+
+// same as above, for the architecture capstone was initialized with
+EDB_EXPORT LengthInfo decode_length(const void *first, const void *last, uint64_t rva) noexcept;
+
+#endif
+
+}
+
+#endif
@@ -34,6 +34,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "IProcess.h"
 #include "IRegion.h"
 #include "IThread.h"
+#include "InstructionCache.h"
 #include "MemoryRegions.h"
 #include "Prototype.h"
 #include "QHexView"
@@ -41,6 +42,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "State.h"
 #include "Symbol.h"
 #include "SymbolManager.h"
+#include "TraceBuffer.h"
 #include "version.h"
 
 #include <QAction>
@@ -55,7 +57,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QFileInfo>
 #include <QMessageBox>
 
+#include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <mutex>
 
 IDebugger *edb::v1::debugger_core = nullptr;
 QWidget *edb::v1::debugger_ui     = nullptr;
@@ -68,12 +73,36 @@ namespace {
 
 using BinaryInfoList = QList<IBinary::create_func_ptr_t>;
 
+// number of tracepoint hits kept around before the oldest get overwritten
+constexpr std::size_t TraceBufferCapacity = 16384;
+
+// number of decoded instructions in each generation of the instruction cache.
+// When the current generation fills up, the previous one is dropped as a whole
+// (only what was looked up again since the last turnover survives), so
+// between this many and twice this many are remembered
+constexpr std::size_t InstructionCacheCapacity = 2048;
+
+// every this many probes saved by the binary info cache, the count is logged
+constexpr uint64_t BinaryInfoProbesReportInterval = 1000;
+
 DebugEventHandlers g_DebugEventHandlers;
 QAtomicPointer<IAnalyzer> g_Analyzer = nullptr;
 QMap<QString, QObject *> g_GeneralPlugins;
 BinaryInfoList g_BinaryInfoList;
 CapstoneEDB::Formatter g_Formatter;
 
+// what the binary info plugins made of a region, binary is null if none of
+// them recognized it, so we don't ask them again
+struct BinaryInfoEntry {
+	edb::address_t end;
+	QString name;
+	std::shared_ptr<IBinary> binary;
+};
+
+std::mutex g_BinaryInfoMutex;
+QHash<edb::address_t, BinaryInfoEntry> g_BinaryInfoCache;
+std::atomic<uint64_t> g_BinaryInfoProbesSaved{0};
+
 QHash<QString, edb::Prototype> g_FunctionDB;
 
 Debugger *ui() {
@@ -335,7 +364,7 @@ bool dump_data(address_t address) {
 void set_breakpoint_condition(address_t address, const QString &condition) {
 
 	if (std::shared_ptr<IBreakpoint> bp = find_breakpoint(address)) {
-		bp->condition = condition;
+		bp->setCondition(condition);
 	}
 }
 
@@ -347,7 +376,7 @@ QString get_breakpoint_condition(address_t address) {
 	QString ret;
 
 	if (std::shared_ptr<IBreakpoint> bp = find_breakpoint(address)) {
-		ret = bp->condition;
+		ret = bp->condition();
 	}
 
 	return ret;
@@ -451,6 +480,52 @@ void toggle_breakpoint(address_t address) {
 	}
 }
 
+//------------------------------------------------------------------------------
+// Name: trace_buffer
+// Desc: the ring buffer which tracepoint hits are recorded into
+//------------------------------------------------------------------------------
+TraceBuffer &trace_buffer() {
+	static TraceBuffer buffer(TraceBufferCapacity);
+	return buffer;
+}
+
+//------------------------------------------------------------------------------
+// Name: record_tracepoint
+// Desc: evaluates the trace expressions of <bp> against <state> and records
+//       the results in the trace buffer
+//------------------------------------------------------------------------------
+void record_tracepoint(const IBreakpoint &bp, tid_t tid, const State &state) {
+
+	edb::address_t values[TraceBuffer::MaxValues];
+	bool valid[TraceBuffer::MaxValues] = {};
+
+	// the registers in the expressions were bound when they were compiled, so
+	// they are read without any string handling or allocation. Both lambdas
+	// are small enough for std::function to keep them without allocating
+	auto variable_reader = [&state](const QString &name, bool *ok, ExpressionError *err) {
+		return get_state_variable(state, name, ok, err);
+	};
+
+	auto bound_reader = [&state](int index, bool *ok, ExpressionError *err) {
+		return get_bound_state_variable(state, index, ok, err);
+	};
+
+	const auto &expressions = bp.compiledTraceExpressions();
+	const std::size_t count = std::min(expressions.size(), TraceBuffer::MaxValues);
+
+	for (std::size_t i = 0; i < count; ++i) {
+		if (Expression<address_t> *expr = expressions[i].get()) {
+			const Result<address_t, ExpressionError> value = expr->evaluate(variable_reader, get_value, bound_reader);
+			if (value) {
+				values[i] = *value;
+				valid[i]  = true;
+			}
+		}
+	}
+
+	trace_buffer().push(bp.address(), tid, values, valid, count);
+}
+
 //------------------------------------------------------------------------------
 // Name: remove_breakpoint
 // Desc: removes a breakpoint
@@ -756,39 +831,82 @@ address_t get_variable(const QString &s, bool *ok, ExpressionError *err) {
 
 		State state;
 		process->currentThread()->getState(&state);
-		const Register reg = state.value(s);
-		*ok                = reg.valid();
-		if (!*ok) {
-			if (const std::shared_ptr<Symbol> sym = edb::v1::symbol_manager().find(s)) {
-				*ok = true;
-				return sym->address;
-			}
+		return get_state_variable(state, s, ok, err);
+	}
 
-			*err = ExpressionError(ExpressionError::UnknownVariable);
-			return 0;
-		}
+	*err = ExpressionError(ExpressionError::UnknownVariable);
+	return 0;
+}
 
-		// FIXME: should this really return segment base, not selector?
-		// FIXME: if it's really meant to return base, then need to check whether
-		//        State::operator[]() returned valid Register
-		if (reg.name() == "fs") {
-			return state["fs_base"].valueAsAddress();
-		}
+//------------------------------------------------------------------------------
+// Name: get_state_variable
+// Desc: like get_variable, but resolves registers from an already fetched state
+//------------------------------------------------------------------------------
+address_t get_state_variable(const State &state, const QString &s, bool *ok, ExpressionError *err) {
 
-		if (reg.name() == "gs") {
-			return state["gs_base"].valueAsAddress();
-		}
+	Q_ASSERT(ok);
+	Q_ASSERT(err);
 
-		if (reg.bitSize() > 8 * sizeof(edb::address_t)) {
-			*err = ExpressionError(ExpressionError::UnknownVariable);
-			return 0;
+	const Register reg = state.value(s);
+	*ok                = reg.valid();
+	if (!*ok) {
+		if (const std::shared_ptr<Symbol> sym = edb::v1::symbol_manager().find(s)) {
+			*ok = true;
+			return sym->address;
 		}
 
-		return reg.valueAsAddress();
+		*err = ExpressionError(ExpressionError::UnknownVariable);
+		return 0;
 	}
 
-	*err = ExpressionError(ExpressionError::UnknownVariable);
-	return 0;
+	// FIXME: should this really return segment base, not selector?
+	// FIXME: if it's really meant to return base, then need to check whether
+	//        State::operator[]() returned valid Register
+	if (reg.name() == "fs") {
+		return state["fs_base"].valueAsAddress();
+	}
+
+	if (reg.name() == "gs") {
+		return state["gs_base"].valueAsAddress();
+	}
+
+	if (reg.bitSize() > 8 * sizeof(edb::address_t)) {
+		*err = ExpressionError(ExpressionError::UnknownVariable);
+		return 0;
+	}
+
+	return reg.valueAsAddress();
+}
+
+//------------------------------------------------------------------------------
+// Name: bind_state_variable
+// Desc: looks a register up by name once, so that get_bound_state_variable can
+//       read it later on without doing that again. -1 if it isn't a register
+//       that can be read that way
+//------------------------------------------------------------------------------
+int bind_state_variable(const QString &s) {
+	const State state;
+	return state.registerIndex(s);
+}
+
+//------------------------------------------------------------------------------
+// Name: get_bound_state_variable
+// Desc: like get_state_variable, but for a register bound by
+//       bind_state_variable, without any string handling or allocation
+//------------------------------------------------------------------------------
+address_t get_bound_state_variable(const State &state, int index, bool *ok, ExpressionError *err) {
+
+	Q_ASSERT(ok);
+	Q_ASSERT(err);
+
+	reg_t value;
+	*ok = state.registerValue(index, &value);
+	if (!*ok) {
+		*err = ExpressionError(ExpressionError::UnknownVariable);
+		return 0;
+	}
+
+	return value;
 }
 
 //------------------------------------------------------------------------------
@@ -815,6 +933,16 @@ address_t get_value(address_t address, bool *ok, ExpressionError *err) {
 	return ret;
 }
 
+//------------------------------------------------------------------------------
+// Name: instruction_cache
+// Desc: the decoded instructions shared by everything which disassembles the
+//       debuggee
+//------------------------------------------------------------------------------
+InstructionCache &instruction_cache() {
+	static InstructionCache cache(InstructionCacheCapacity);
+	return cache;
+}
+
 //------------------------------------------------------------------------------
 // Name: get_instruction_bytes
 // Desc: attempts to read at most size bytes.
@@ -884,6 +1012,68 @@ std::unique_ptr<IBinary> get_binary_info(const std::shared_ptr<IRegion> &region)
 	return nullptr;
 }
 
+//------------------------------------------------------------------------------
+// Name: cached_binary_info
+// Desc: like get_binary_info, but the result (even not finding anything) is
+//       remembered for as long as the region stays mapped. This is cheap
+//       enough to be used while painting
+//------------------------------------------------------------------------------
+std::shared_ptr<IBinary> cached_binary_info(const std::shared_ptr<IRegion> &region) {
+
+	if (!region) {
+		return nullptr;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(g_BinaryInfoMutex);
+		auto it = g_BinaryInfoCache.find(region->start());
+		if (it != g_BinaryInfoCache.end() && it->end == region->end() && it->name == region->name()) {
+			std::shared_ptr<IBinary> binary = it->binary;
+			lock.unlock();
+
+			const uint64_t saved = g_BinaryInfoProbesSaved.fetch_add(1, std::memory_order_relaxed) + 1;
+			if (saved % BinaryInfoProbesReportInterval == 0) {
+				qDebug() << "Binary info cache:" << saved << "probes saved so far";
+			}
+
+			return binary;
+		}
+	}
+
+	std::shared_ptr<IBinary> binary = get_binary_info(region);
+
+	std::lock_guard<std::mutex> lock(g_BinaryInfoMutex);
+	g_BinaryInfoCache.insert(region->start(), BinaryInfoEntry{region->end(), region->name(), binary});
+	return binary;
+}
+
+//------------------------------------------------------------------------------
+// Name: invalidate_binary_info
+// Desc: forgets what we know about the binary in <region>
+//------------------------------------------------------------------------------
+void invalidate_binary_info(const std::shared_ptr<IRegion> &region) {
+	std::lock_guard<std::mutex> lock(g_BinaryInfoMutex);
+	g_BinaryInfoCache.remove(region->start());
+}
+
+//------------------------------------------------------------------------------
+// Name: clear_binary_info
+// Desc: forgets what we know about the binaries of every region, the next
+//       process may well have something else mapped at the same place
+//------------------------------------------------------------------------------
+void clear_binary_info() {
+	std::lock_guard<std::mutex> lock(g_BinaryInfoMutex);
+	g_BinaryInfoCache.clear();
+}
+
+//------------------------------------------------------------------------------
+// Name: binary_info_probes_saved
+// Desc: how many times cached_binary_info didn't have to ask the plugins
+//------------------------------------------------------------------------------
+uint64_t binary_info_probes_saved() {
+	return g_BinaryInfoProbesSaved.load(std::memory_order_relaxed);
+}
+
 //------------------------------------------------------------------------------
 // Name: locate_main_function
 // Desc:
@@ -1031,6 +1221,10 @@ void push_value(State *state, reg_t value) {
 void register_binary_info(IBinary::create_func_ptr_t fptr) {
 	if (!g_BinaryInfoList.contains(fptr)) {
 		g_BinaryInfoList.push_back(fptr);
+
+		// the new plugin may recognize something the others didn't
+		std::lock_guard<std::mutex> lock(g_BinaryInfoMutex);
+		g_BinaryInfoCache.clear();
 	}
 }
 
@@ -0,0 +1,271 @@
+#include "FunctionCollector.h"
+#include "IRegion.h"
+#include "Instruction.h"
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <iterator>
+#include <malloc.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Analyzes the executable code of a 64-bit ELF file offline, starting from its
+// entry point and every function in its symbol tables, and reports how much
+// heap the basic blocks take. Once the way they are kept now, as records in an
+// InstructionArena, and once the way they used to be kept, a shared_ptr to a
+// decoded edb::Instruction for every instruction of every block plus the copy
+// of the region which RegionData held on to.
+//
+// Both are measured with mallinfo2, only what is left after the analysis is
+// counted, not what it needed along the way.
+//
+// usage: AnalysisMemoryBenchmark file...
+//
+// libc and something of 100 MB or more, a libLLVM for example, are the
+// interesting ones
+
+namespace {
+
+// where position independent files are put, 0 makes a poor region start
+constexpr uint64_t DynamicBase = 0x7f0000000000;
+
+using OldBlock = std::vector<std::shared_ptr<edb::Instruction>>;
+
+class FileRegion : public IRegion {
+public:
+	FileRegion(edb::address_t start, edb::address_t end)
+		: start_(start), end_(end) {
+	}
+
+public:
+	[[nodiscard]] IRegion *clone() const override { return new FileRegion(start_, end_); }
+
+public:
+	[[nodiscard]] bool accessible() const override { return true; }
+	[[nodiscard]] bool readable() const override { return true; }
+	[[nodiscard]] bool writable() const override { return false; }
+	[[nodiscard]] bool executable() const override { return true; }
+	[[nodiscard]] size_t size() const override { return end_ - start_; }
+
+public:
+	void setPermissions(bool, bool, bool) override {}
+	void setStart(edb::address_t address) override { start_ = address; }
+	void setEnd(edb::address_t address) override { end_ = address; }
+
+public:
+	[[nodiscard]] edb::address_t start() const override { return start_; }
+	[[nodiscard]] edb::address_t end() const override { return end_; }
+	[[nodiscard]] edb::address_t base() const override { return start_; }
+	[[nodiscard]] QString name() const override { return QString(); }
+	[[nodiscard]] permissions_t permissions() const override { return 0; }
+
+private:
+	edb::address_t start_;
+	edb::address_t end_;
+};
+
+struct Binary {
+	edb::address_t start;
+	QVector<uint8_t> memory;
+	QList<edb::address_t> entryPoints;
+};
+
+std::size_t heap_in_use() {
+	return mallinfo2().uordblks;
+}
+
+std::vector<uint8_t> read_file(const char *filename) {
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		return {};
+	}
+
+	return std::vector<uint8_t>{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+/**
+ * the executable segment which is the biggest, it's the one with the code in
+ * any binary of interest
+ */
+bool load(const std::vector<uint8_t> &file, Binary *binary) {
+
+	if (file.size() < sizeof(Elf64_Ehdr) || std::memcmp(file.data(), ELFMAG, SELFMAG) != 0 || file[EI_CLASS] != ELFCLASS64) {
+		return false;
+	}
+
+	Elf64_Ehdr header;
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	const uint64_t bias = header.e_type == ET_DYN ? DynamicBase : 0;
+
+	const Elf64_Phdr *code = nullptr;
+	for (int i = 0; i < header.e_phnum; ++i) {
+		const std::size_t offset = header.e_phoff + i * sizeof(Elf64_Phdr);
+		if (offset + sizeof(Elf64_Phdr) > file.size()) {
+			return false;
+		}
+
+		auto segment = reinterpret_cast<const Elf64_Phdr *>(file.data() + offset);
+		if (segment->p_type == PT_LOAD && (segment->p_flags & PF_X) && (!code || segment->p_filesz > code->p_filesz)) {
+			code = segment;
+		}
+	}
+
+	if (!code || code->p_offset + code->p_filesz > file.size()) {
+		return false;
+	}
+
+	const uint64_t first = code->p_vaddr;
+	const uint64_t last  = code->p_vaddr + code->p_filesz;
+
+	binary->start = bias + first;
+	binary->memory.reserve(static_cast<int>(code->p_filesz));
+	std::copy_n(file.data() + code->p_offset, code->p_filesz, std::back_inserter(binary->memory));
+
+	QSet<edb::address_t> entry_points;
+	if (header.e_entry >= first && header.e_entry < last) {
+		entry_points.insert(bias + header.e_entry);
+	}
+
+	for (int i = 0; i < header.e_shnum; ++i) {
+		const std::size_t offset = header.e_shoff + i * sizeof(Elf64_Shdr);
+		if (offset + sizeof(Elf64_Shdr) > file.size()) {
+			break;
+		}
+
+		auto section = reinterpret_cast<const Elf64_Shdr *>(file.data() + offset);
+		if ((section->sh_type != SHT_SYMTAB && section->sh_type != SHT_DYNSYM) || section->sh_offset + section->sh_size > file.size()) {
+			continue;
+		}
+
+		auto symbols           = reinterpret_cast<const Elf64_Sym *>(file.data() + section->sh_offset);
+		const std::size_t count = section->sh_size / sizeof(Elf64_Sym);
+		for (std::size_t j = 0; j < count; ++j) {
+			if (ELF64_ST_TYPE(symbols[j].st_info) == STT_FUNC && symbols[j].st_shndx != SHN_UNDEF && symbols[j].st_value >= first && symbols[j].st_value < last) {
+				entry_points.insert(bias + symbols[j].st_value);
+			}
+		}
+	}
+
+	binary->entryPoints = entry_points.values();
+	std::sort(binary->entryPoints.begin(), binary->entryPoints.end());
+	return true;
+}
+
+/**
+ * the blocks the way BasicBlock used to keep them, every instruction decoded
+ * and on the heap
+ */
+bool make_old_blocks(const QHash<edb::address_t, BasicBlock> &blocks, const Binary &binary, QHash<edb::address_t, OldBlock> *old_blocks) {
+
+	for (auto it = blocks.begin(); it != blocks.end(); ++it) {
+		const BasicBlock &block = it.value();
+
+		OldBlock &old_block = (*old_blocks)[it.key()];
+		for (std::size_t i = 0; i < block.size(); ++i) {
+			const edb::address_t address = block.instructionAddress(i);
+			const uint8_t *const first   = binary.memory.data() + (address - binary.start).toUint();
+			const uint8_t *const last    = binary.memory.data() + binary.memory.size();
+
+			auto inst = std::make_shared<edb::Instruction>(first, last, address);
+			if (!*inst) {
+				return false;
+			}
+
+			old_block.push_back(inst);
+		}
+	}
+
+	return true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	if (argc < 2) {
+		std::fprintf(stderr, "usage: %s file...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (!CapstoneEDB::init(CapstoneEDB::Architecture::ARCH_AMD64)) {
+		std::fprintf(stderr, "unable to initialize capstone\n");
+		return EXIT_FAILURE;
+	}
+
+	std::printf("sizeof(edb::Instruction) = %zu, sizeof(InstructionRecord) = %zu\n", sizeof(edb::Instruction), sizeof(InstructionRecord));
+
+	const std::atomic<bool> cancelled{false};
+	const QSet<edb::address_t> non_returning;
+
+	for (int i = 1; i < argc; ++i) {
+
+		Binary binary;
+		if (!load(read_file(argv[i]), &binary)) {
+			std::fprintf(stderr, "%s: not a 64-bit ELF file with code in it\n", argv[i]);
+			return EXIT_FAILURE;
+		}
+
+		const auto region = std::make_shared<FileRegion>(binary.start, binary.start + binary.memory.size());
+
+		// what is left once the analysis is done, the collector and its
+		// caches are gone by then
+		const std::size_t heap_before_analysis = heap_in_use();
+
+		QHash<edb::address_t, BasicBlock> blocks;
+		std::size_t arena_size   = 0;
+		std::size_t instructions = 0;
+		{
+			auto arena = std::make_shared<InstructionArena>(binary.start);
+
+			AnalyzerPlugin::FunctionCollector collector(region, binary.memory, arena, non_returning, cancelled);
+			collector.run(binary.entryPoints, std::max(1u, std::thread::hardware_concurrency()));
+
+			blocks       = collector.basicBlocks();
+			arena_size   = arena->memoryUsage();
+			instructions = arena->size();
+		}
+
+		const std::size_t new_blocks = heap_in_use() - heap_before_analysis;
+
+		const std::size_t heap_before_old = heap_in_use();
+
+		QHash<edb::address_t, OldBlock> old_blocks;
+		if (!make_old_blocks(blocks, binary, &old_blocks)) {
+			std::fprintf(stderr, "%s: FAILED to decode an analyzed instruction again\n", argv[i]);
+			return EXIT_FAILURE;
+		}
+
+		// RegionData kept a copy of the region for as long as the analysis
+		const std::size_t old_blocks_size = heap_in_use() - heap_before_old + static_cast<std::size_t>(binary.memory.size());
+
+		std::printf("%s: %d bytes of code, %d entry points, %d blocks, %zu instructions\n",
+					argv[i],
+					binary.memory.size(),
+					binary.entryPoints.size(),
+					blocks.size(),
+					instructions);
+
+		std::printf("    before: %12zu bytes (%.1f per instruction)\n",
+					old_blocks_size,
+					static_cast<double>(old_blocks_size) / instructions);
+
+		std::printf("    after:  %12zu bytes (%.1f per instruction), %zu of them in the arena (%.1fx less)\n",
+					new_blocks,
+					static_cast<double>(new_blocks) / instructions,
+					arena_size,
+					static_cast<double>(old_blocks_size) / new_blocks);
+	}
+}
@@ -0,0 +1,305 @@
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Runs a debuggee which calls the same function over and over, with a
+// breakpoint on it whose condition is always false, and reports how many hits
+// per second can be stepped past. Once the way DebuggerCore::skipBreakpoint
+// does it on Linux: the general purpose registers, rewind, stop every other
+// thread, lift the breakpoint, single step, put it back, continue everything.
+// And once with what the GUI path used to do on top of that for every hit,
+// short of the GUI itself: read the memory map again and fetch every register.
+//
+// The debuggee has a growing number of other threads which are busy but never
+// get near the breakpoint. Those have to be stopped around every step all the
+// same, since they could run through the breakpoint while it is lifted.
+//
+// usage: BreakpointSkipBenchmark [seconds per run]
+
+namespace {
+
+constexpr uint8_t Int3 = 0xcc;
+
+extern "C" __attribute__((noinline)) void hot_function(volatile uint64_t *counter) {
+	++*counter;
+	asm volatile("" ::: "memory");
+}
+
+/**
+ * what the debuggee does, it never returns
+ */
+[[noreturn]] void debuggee(int others, int ready) {
+
+	for (int i = 0; i < others; ++i) {
+		std::thread([]() {
+			volatile uint64_t busy = 0;
+			for (;;) {
+				++busy;
+			}
+		}).detach();
+	}
+
+	// every thread exists now, the tracer can attach to them
+	const char c = 0;
+	if (write(ready, &c, 1) != 1) {
+		_exit(EXIT_FAILURE);
+	}
+
+	volatile uint64_t counter = 0;
+	for (;;) {
+		hot_function(&counter);
+	}
+}
+
+std::vector<pid_t> thread_ids(pid_t pid) {
+
+	std::vector<pid_t> tids;
+
+	char path[64];
+	std::snprintf(path, sizeof(path), "/proc/%d/task", pid);
+
+	if (DIR *const dir = opendir(path)) {
+		while (const dirent *const entry = readdir(dir)) {
+			if (entry->d_name[0] != '.') {
+				tids.push_back(static_cast<pid_t>(std::atoi(entry->d_name)));
+			}
+		}
+		closedir(dir);
+	}
+
+	return tids;
+}
+
+/**
+ * what the GUI path did on every hit on top of the fast path, short of the
+ * GUI itself
+ */
+bool extra_work(pid_t pid) {
+
+	// memory_regions().sync()
+	char path[64];
+	std::snprintf(path, sizeof(path), "/proc/%d/maps", pid);
+
+	const int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+
+	char buffer[4096];
+	while (read(fd, buffer, sizeof(buffer)) > 0) {
+	}
+	close(fd);
+
+	// PlatformThread::getState
+	alignas(64) uint8_t xsave[4096];
+	iovec iov = {xsave, sizeof(xsave)};
+	if (ptrace(PTRACE_GETREGSET, pid, NT_X86_XSTATE, &iov) == -1) {
+		return false;
+	}
+
+	for (int i = 0; i < 8; ++i) {
+		errno = 0;
+		ptrace(PTRACE_PEEKUSER, pid, offsetof(struct user, u_debugreg) + i * sizeof(long), nullptr);
+		if (errno != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * the way DebuggerCore::stopThreads does it, SIGSTOP to all of them before
+ * waiting for any
+ */
+bool stop_others(pid_t pid, const std::vector<pid_t> &others) {
+	for (const pid_t tid : others) {
+		if (syscall(SYS_tgkill, pid, tid, SIGSTOP) == -1) {
+			return false;
+		}
+	}
+
+	for (const pid_t tid : others) {
+		int status;
+		if (waitpid(tid, &status, __WALL) != tid || !WIFSTOPPED(status)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool resume_others(const std::vector<pid_t> &others) {
+	for (const pid_t tid : others) {
+		if (ptrace(PTRACE_CONT, tid, nullptr, nullptr) == -1) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * steps past one hit, the way DebuggerCore::skipBreakpoint does it
+ */
+bool skip(pid_t pid, int mem, uint64_t address, uint8_t original, const std::vector<pid_t> &others) {
+
+	user_regs_struct regs;
+	if (ptrace(PTRACE_GETREGS, pid, nullptr, &regs) == -1) {
+		return false;
+	}
+
+	// the condition, "rdi == 0", which is always false
+	if (regs.rip - 1 != address || regs.rdi == 0) {
+		return false;
+	}
+
+	regs.rip = address;
+	if (ptrace(PTRACE_SETREGS, pid, nullptr, &regs) == -1) {
+		return false;
+	}
+
+	if (!stop_others(pid, others)) {
+		return false;
+	}
+
+	if (pwrite(mem, &original, 1, static_cast<off_t>(address)) != 1) {
+		return false;
+	}
+
+	int status;
+	if (ptrace(PTRACE_SINGLESTEP, pid, nullptr, nullptr) == -1 || waitpid(pid, &status, __WALL) != pid || !WIFSTOPPED(status) || WSTOPSIG(status) != SIGTRAP) {
+		return false;
+	}
+
+	if (pwrite(mem, &Int3, 1, static_cast<off_t>(address)) != 1) {
+		return false;
+	}
+
+	return ptrace(PTRACE_CONT, pid, nullptr, nullptr) == 0 && resume_others(others);
+}
+
+/**
+ * @return the number of hits per second, or a negative number if anything
+ * went wrong
+ */
+double hits_per_second(int others, double seconds, bool gui_path) {
+
+	int ready[2];
+	if (pipe(ready) == -1) {
+		return -1.0;
+	}
+
+	const pid_t pid = fork();
+	if (pid == -1) {
+		return -1.0;
+	}
+
+	if (pid == 0) {
+		close(ready[0]);
+		debuggee(others, ready[1]);
+	}
+
+	close(ready[1]);
+
+	char c;
+	const bool started = read(ready[0], &c, 1) == 1;
+	close(ready[0]);
+
+	const std::vector<pid_t> tids = started ? thread_ids(pid) : std::vector<pid_t>();
+
+	// PTRACE_ATTACH would send a SIGSTOP to the whole process, seizing doesn't
+	// stop anything
+	bool ok = static_cast<int>(tids.size()) == others + 1;
+	std::vector<pid_t> other_tids;
+	for (const pid_t tid : tids) {
+		ok = ok && ptrace(PTRACE_SEIZE, tid, nullptr, nullptr) == 0;
+		if (tid != pid) {
+			other_tids.push_back(tid);
+		}
+	}
+
+	// the debuggee is a fork of us, so the function is at the same address
+	// over there
+	const auto address = reinterpret_cast<uint64_t>(&hot_function);
+
+	char path[64];
+	std::snprintf(path, sizeof(path), "/proc/%d/mem", pid);
+
+	double result = -1.0;
+
+	const int mem = ok ? open(path, O_RDWR) : -1;
+	if (mem != -1) {
+		uint8_t original;
+		if (pread(mem, &original, 1, static_cast<off_t>(address)) == 1 && pwrite(mem, &Int3, 1, static_cast<off_t>(address)) == 1) {
+
+			const auto start    = std::chrono::steady_clock::now();
+			const auto deadline = start + std::chrono::duration<double>(seconds);
+			uint64_t count      = 0;
+
+			int status;
+			do {
+				ok = waitpid(pid, &status, __WALL) == pid && WIFSTOPPED(status) && WSTOPSIG(status) == SIGTRAP;
+				ok = ok && (!gui_path || extra_work(pid));
+				ok = ok && skip(pid, mem, address, original, other_tids);
+				++count;
+			} while (ok && std::chrono::steady_clock::now() < deadline);
+
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			if (ok) {
+				result = static_cast<double>(count) / elapsed.count();
+			}
+		}
+		close(mem);
+	}
+
+	// the leader isn't reported as gone before every other thread we trace
+	// has been reaped
+	kill(pid, SIGKILL);
+	for (const pid_t tid : other_tids) {
+		waitpid(tid, nullptr, __WALL);
+	}
+	waitpid(pid, nullptr, __WALL);
+	return result;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	const double seconds = (argc > 1) ? std::atof(argv[1]) : 1.0;
+
+	std::printf("%u CPU(s)\n", std::thread::hardware_concurrency());
+
+	for (const int others : {0, 1, 3, 7}) {
+
+		const double fast = hits_per_second(others, seconds, false);
+		const double slow = hits_per_second(others, seconds, true);
+
+		if (fast < 0 || slow < 0) {
+			std::fprintf(stderr, "unable to trace the debuggee: %s\n", std::strerror(errno));
+			return EXIT_FAILURE;
+		}
+
+		std::printf("%d other thread(s): %10.0f hits/s in the core, %10.0f hits/s with the map and every register on each hit (%.1fx)\n",
+					others,
+					fast,
+					slow,
+					fast / slow);
+	}
+}
@@ -0,0 +1,156 @@
+#include "Expression.h"
+#include "Types.h"
+#include <QHash>
+#include <QString>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+
+// Evaluates some typical breakpoint conditions over and over, the way a hot
+// conditional breakpoint does. Once by parsing the condition every time, which
+// is how Debugger::isBreakpointConditionTrue used to do it, once by compiling
+// it a single time and looking the registers up by name on every run, and once
+// with the registers bound to an index when compiling, which is how it is done
+// now. Reports how many conditional hits per second each of them manages.
+//
+// The registers come out of a table here. The old way also fetched the thread
+// state once per register in the condition, which is a handful of ptrace calls
+// each time, so the real difference is bigger than the one reported.
+//
+// usage: ExpressionBenchmark [seconds per run]
+
+namespace {
+
+constexpr uint64_t Rounds = 1024;
+
+const char *const Conditions[] = {
+	"rax == 0x1234",
+	"rax == 0x1234 && [rsp+8] != 0",
+	"(rcx & 0xff) == 7 || rdx > rsi + 0x100",
+	"[[rbp-8]+0x10] == rdi && (r8 ^ r9) != 0 && rip >= 0x400000",
+};
+
+const char *const RegisterNames[] = {"rax", "rcx", "rdx", "rsi", "rdi", "rbp", "rsp", "rip", "r8", "r9"};
+
+// the same registers twice, by name the way State::value finds them and by
+// index the way State::registerValue does
+using Registers      = QHash<QString, edb::address_t>;
+using BoundRegisters = std::array<edb::address_t, std::size(RegisterNames)>;
+
+BoundRegisters make_bound_registers() {
+	return {0x1234, 0x1007, 0x2000, 0x1000, 0x7fff0010, 0x7ffe0040, 0x7ffe0000, 0x401000, 0x55, 0xaa};
+}
+
+Registers make_registers(const BoundRegisters &bound) {
+	Registers registers;
+	for (std::size_t i = 0; i < bound.size(); ++i) {
+		registers[QString::fromLatin1(RegisterNames[i])] = bound[i];
+	}
+	return registers;
+}
+
+int bind(const QString &name) {
+	for (std::size_t i = 0; i < std::size(RegisterNames); ++i) {
+		if (name == QString::fromLatin1(RegisterNames[i])) {
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+template <class F>
+double hits_per_second(double seconds, F hit) {
+
+	const auto start    = std::chrono::steady_clock::now();
+	const auto deadline = start + std::chrono::duration<double>(seconds);
+	uint64_t count      = 0;
+
+	do {
+		for (uint64_t i = 0; i < Rounds; ++i) {
+			hit();
+		}
+		count += Rounds;
+	} while (std::chrono::steady_clock::now() < deadline);
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return static_cast<double>(count) / elapsed.count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	const double seconds = (argc > 1) ? std::atof(argv[1]) : 1.0;
+
+	const BoundRegisters bound_registers = make_bound_registers();
+	const Registers registers            = make_registers(bound_registers);
+
+	const Expression<edb::address_t>::variable_getter_t variable_reader = [&registers](const QString &name, bool *ok, ExpressionError *err) {
+		auto it = registers.constFind(name);
+		if (it == registers.constEnd()) {
+			*ok  = false;
+			*err = ExpressionError(ExpressionError::UnknownVariable);
+			return edb::address_t(0);
+		}
+		*ok = true;
+		return it.value();
+	};
+
+	const Expression<edb::address_t>::bound_reader_t bound_reader = [&bound_registers](int index, bool *ok, ExpressionError *) {
+		*ok = true;
+		return bound_registers[static_cast<std::size_t>(index)];
+	};
+
+	// every address reads as something made up from the address itself
+	const Expression<edb::address_t>::memoryReader_t memory_reader = [](edb::address_t address, bool *ok, ExpressionError *) {
+		*ok = true;
+		return edb::address_t(address.toUint() ^ 0x7fff0000);
+	};
+
+	for (const char *const condition : Conditions) {
+
+		const QString text = QString::fromLatin1(condition);
+
+		Expression<edb::address_t> compiled(text, variable_reader, memory_reader);
+		Expression<edb::address_t> bound(text, variable_reader, memory_reader);
+		if (!compiled.compile() || !bound.compile(bind)) {
+			std::fprintf(stderr, "FAILED: \"%s\" doesn't compile\n", condition);
+			return EXIT_FAILURE;
+		}
+
+		// all of them have to come up with the same value, or the numbers mean
+		// nothing. Without a variable reader the bound one can't fall back to
+		// the names, so that one has to have bound every register
+		const Result<edb::address_t, ExpressionError> expected  = Expression<edb::address_t>(text, variable_reader, memory_reader).evaluate();
+		const Result<edb::address_t, ExpressionError> got       = compiled.evaluate(variable_reader, memory_reader);
+		const Result<edb::address_t, ExpressionError> got_bound = bound.evaluate(nullptr, memory_reader, bound_reader);
+		if (!expected || !got || !got_bound || *expected != *got || *expected != *got_bound) {
+			std::fprintf(stderr, "FAILED: \"%s\" evaluates differently\n", condition);
+			return EXIT_FAILURE;
+		}
+
+		const double parsed = hits_per_second(seconds, [&]() {
+			Expression<edb::address_t> expr(text, variable_reader, memory_reader);
+			static_cast<void>(expr.evaluate());
+		});
+
+		const double run = hits_per_second(seconds, [&]() {
+			static_cast<void>(compiled.evaluate(variable_reader, memory_reader));
+		});
+
+		const double run_bound = hits_per_second(seconds, [&]() {
+			static_cast<void>(bound.evaluate(variable_reader, memory_reader, bound_reader));
+		});
+
+		std::printf("%-60s %11.0f hits/s parsing every time, %11.0f hits/s compiled (%.1fx), %11.0f hits/s bound (%.1fx)\n",
+					condition,
+					parsed,
+					run,
+					run / parsed,
+					run_bound,
+					run_bound / parsed);
+	}
+}
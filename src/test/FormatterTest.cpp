@@ -0,0 +1,206 @@
+#include "Formatter.h"
+#include "Instruction.h"
+#include <QRegExp>
+#include <QRegularExpression>
+#include <QString>
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Formats a corpus of instructions with every combination of the formatter
+// options and compares the result with what the regular expressions the
+// formatter used to be built on produce for the same operand strings.
+//
+// usage: FormatterTest [file...]
+//
+// the files are used as (mostly) real code, a block of pseudo random bytes is
+// always added to that, which makes for plenty of odd operands
+
+namespace {
+
+constexpr std::size_t RandomSize      = 256 * 1024;
+constexpr std::size_t MaxFileSize     = 512 * 1024;
+constexpr std::size_t MaxFailedReport = 20;
+
+struct Stats {
+	uint64_t total  = 0;
+	uint64_t failed = 0;
+};
+
+std::vector<uint8_t> make_corpus(int argc, char *argv[]) {
+
+	std::vector<uint8_t> corpus;
+
+	for (int i = 1; i < argc; ++i) {
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file) {
+			std::fprintf(stderr, "unable to open %s\n", argv[i]);
+			std::exit(EXIT_FAILURE);
+		}
+
+		std::vector<uint8_t> bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+		bytes.resize(std::min(bytes.size(), MaxFileSize));
+		corpus.insert(corpus.end(), bytes.begin(), bytes.end());
+	}
+
+	std::mt19937 engine(0x20240301);
+	std::uniform_int_distribution<int> distribution(0, 0xff);
+	std::generate_n(std::back_inserter(corpus), RandomSize, [&]() { return static_cast<uint8_t>(distribution(engine)); });
+
+	return corpus;
+}
+
+/**
+ * the operand clean ups, the way they were done with regular expressions
+ */
+std::string reference_operands(const CapstoneEDB::Instruction &insn, bool simplifyRIPRelativeTargets, bool x86_64) {
+
+	QString operands(insn->op_str);
+
+	operands.replace(" + ", "+");
+	operands.replace(" - ", "-");
+
+	operands.replace(QRegExp("\\bxword "), "tbyte ");
+	operands.replace(QRegExp("(word|byte) ptr "), "\\1 ");
+
+	if (simplifyRIPRelativeTargets && x86_64 && insn.hasDetail() && (insn->detail->x86.modrm & 0xc7) == 0x05) {
+		QRegExp ripRel("\\brip ?[+-] ?((0x)?[0-9a-fA-F]+)\\b");
+		operands.replace(ripRel, "rel 0x" + QString::number(insn->detail->x86.disp + insn->address + insn->size, 16));
+	}
+
+	if (insn.operandCount() == 2 && insn->id != X86_INS_MOVZX && insn->id != X86_INS_MOVSX &&
+		((insn[0]->type == X86_OP_REG && insn[1]->type == X86_OP_MEM) || (insn[1]->type == X86_OP_REG && insn[0]->type == X86_OP_MEM))) {
+		operands.replace(QRegExp("(\\b.?(mm)?word|byte)\\b( ptr)? "), "");
+	}
+
+	return operands.toStdString();
+}
+
+/**
+ * the whole line, the way it used to be put together
+ */
+std::string reference_string(const CapstoneEDB::Instruction &insn, const CapstoneEDB::Formatter::FormatOptions &options, const std::string &operands) {
+
+	enum {
+		Tab1Size = 8,
+		Tab2Size = 11,
+	};
+
+	std::string str;
+
+	if (!insn) {
+		char buf[32];
+		if (options.tabBetweenMnemonicAndOperands) {
+			std::snprintf(buf, sizeof(buf), "%-*s0x%02x", Tab1Size, "db", insn.bytes()[0]);
+		} else {
+			std::snprintf(buf, sizeof(buf), "db 0x%02x", insn.bytes()[0]);
+		}
+
+		str = buf;
+	} else {
+		str = insn->mnemonic;
+
+		std::size_t pad = 1;
+		if (options.tabBetweenMnemonicAndOperands) {
+			const std::size_t pos = str.size();
+			pad                   = pos < Tab1Size ? Tab1Size - pos : pos < Tab2Size ? Tab2Size - pos
+																					  : 1;
+		}
+
+		if (insn.operandCount() > 0) {
+			str += std::string(pad, ' ') + operands;
+		} else if (insn->op_str[0] != 0) {
+			str += std::string(pad, ' ') + insn->op_str;
+		}
+	}
+
+	if (options.capitalization == CapstoneEDB::Formatter::UpperCase) {
+		std::transform(str.begin(), str.end(), str.begin(), ::toupper);
+
+		static const QRegularExpression re("\\b0X([0-9A-F]+)\\b");
+		str = QString::fromStdString(str).replace(re, "0x\\1").toStdString();
+	}
+
+	return str;
+}
+
+/**
+ * sweeps through the corpus, formatting every instruction with each of
+ * <formatters>, which differ only in capitalization and tabbing
+ */
+void check(const std::vector<uint8_t> &corpus, const std::vector<CapstoneEDB::Formatter> &formatters, bool simplifyRIPRelativeTargets, bool x86_64, Stats *stats) {
+
+	std::string str;
+
+	const uint8_t *p    = corpus.data();
+	const uint8_t *last = corpus.data() + corpus.size();
+
+	while (p < last) {
+		const CapstoneEDB::Instruction insn(p, std::min(p + CapstoneEDB::Instruction::MaxSize, last), static_cast<uint64_t>(p - corpus.data()));
+
+		const std::string operands = insn ? reference_operands(insn, simplifyRIPRelativeTargets, x86_64) : std::string();
+
+		for (const CapstoneEDB::Formatter &formatter : formatters) {
+			formatter.toString(insn, &str);
+
+			const std::string expected = reference_string(insn, formatter.options(), operands);
+
+			++stats->total;
+			if (str != expected) {
+				if (stats->failed++ < MaxFailedReport) {
+					std::fprintf(stderr, "FAILED: [@%zx] \"%s\" vs \"%s\"\n", static_cast<std::size_t>(p - corpus.data()), str.c_str(), expected.c_str());
+				}
+			}
+		}
+
+		p += std::max<std::size_t>(1, insn.byteSize());
+	}
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	const std::vector<uint8_t> corpus = make_corpus(argc, argv);
+
+	Stats stats;
+
+	for (const CapstoneEDB::Architecture arch : {CapstoneEDB::Architecture::ARCH_AMD64, CapstoneEDB::Architecture::ARCH_X86}) {
+
+		if (!CapstoneEDB::init(arch)) {
+			std::fprintf(stderr, "unable to initialize capstone\n");
+			return EXIT_FAILURE;
+		}
+
+		for (const CapstoneEDB::Formatter::Syntax syntax : {CapstoneEDB::Formatter::SyntaxIntel, CapstoneEDB::Formatter::SyntaxAtt}) {
+			for (const bool simplify : {false, true}) {
+
+				// the syntax and RIP relative targets are taken from
+				// whichever formatter was set up last, which is the same for all
+				// of these
+				std::vector<CapstoneEDB::Formatter> formatters;
+				for (const CapstoneEDB::Formatter::Capitalization capitalization : {CapstoneEDB::Formatter::LowerCase, CapstoneEDB::Formatter::UpperCase}) {
+					for (const bool tab : {false, true}) {
+						CapstoneEDB::Formatter formatter;
+						formatter.setOptions({syntax, capitalization, tab, simplify});
+						formatters.push_back(formatter);
+					}
+				}
+
+				check(corpus, formatters, simplify, arch == CapstoneEDB::Architecture::ARCH_AMD64, &stats);
+			}
+		}
+	}
+
+	std::printf("formatted: %" PRIu64 ", different from the regular expressions: %" PRIu64 "\n", stats.total, stats.failed);
+
+	return stats.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
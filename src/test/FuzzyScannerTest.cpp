@@ -0,0 +1,352 @@
+#include "FuzzyScanner.h"
+#include "Instruction.h"
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// Runs the fuzzy function scan of the analyzer over a corpus and compares what
+// it finds with a plain capstone decode at every single byte offset, which is
+// how the scan used to be done. Then changes some pages of the corpus and
+// compares a scan of only those with a scan of the whole thing.
+//
+// usage: FuzzyScannerTest [file...]
+//
+// the files are used as real code, the bigger and the more like libc the
+// better. A block of pseudo random bytes is always scanned on its own too
+
+namespace {
+
+constexpr std::size_t RandomSize      = 512 * 1024 + 13; // not a multiple of 16 on purpose
+constexpr std::size_t MaxFileSize     = 1024 * 1024;
+constexpr std::size_t MaxFailedReport = 20;
+constexpr uint64_t Base               = 0x400000;
+constexpr std::size_t PageSize        = 4096;
+constexpr int UpdateRounds            = 8;
+
+struct Scan {
+	QHash<edb::address_t, int> callTargets;
+	QSet<edb::address_t> landingPads;
+};
+
+QVector<uint8_t> read_file(const char *filename) {
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		std::fprintf(stderr, "unable to open %s\n", filename);
+		std::exit(EXIT_FAILURE);
+	}
+
+	std::vector<uint8_t> bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+	bytes.resize(std::min(bytes.size(), MaxFileSize));
+
+	QVector<uint8_t> memory;
+	memory.reserve(static_cast<int>(bytes.size()));
+	std::copy(bytes.begin(), bytes.end(), std::back_inserter(memory));
+	return memory;
+}
+
+QVector<uint8_t> random_bytes() {
+
+	QVector<uint8_t> memory;
+	memory.reserve(static_cast<int>(RandomSize));
+
+	std::mt19937 engine(0x20240301);
+	std::uniform_int_distribution<int> distribution(0, 0xff);
+	std::generate_n(std::back_inserter(memory), RandomSize, [&]() { return static_cast<uint8_t>(distribution(engine)); });
+
+	return memory;
+}
+
+/**
+ * the fuzzy scan, the way it was done before there was a FuzzyScanner
+ */
+Scan reference_scan(const QVector<uint8_t> &memory) {
+
+	Scan results;
+
+	const uint8_t *const first = memory.data();
+	const uint8_t *const last  = memory.data() + memory.size();
+
+	for (const uint8_t *p = first; p != last; ++p) {
+		const edb::address_t addr = Base + static_cast<uint64_t>(p - first);
+
+		if (auto inst = edb::Instruction(p, last, addr)) {
+			if (is_call(inst)) {
+				const edb::Operand op = inst[0];
+				if (is_immediate(op)) {
+					const edb::address_t ea = op->imm;
+					if (ea != addr + inst.byteSize()) {
+						results.callTargets[ea]++;
+					}
+				}
+#if CS_API_MAJOR >= 4
+			} else if (inst->id == X86_INS_ENDBR64 || inst->id == X86_INS_ENDBR32) {
+				results.landingPads.insert(addr);
+#endif
+			}
+		}
+	}
+
+	return results;
+}
+
+/**
+ * @return the number of differences between <scanner> and <expected>
+ */
+uint64_t compare(const AnalyzerPlugin::FuzzyScanner &scanner, const Scan &expected, uint64_t *reported) {
+
+	uint64_t failed = 0;
+
+	auto report = [&](const char *what, edb::address_t address, int got, int wanted) {
+		++failed;
+		if ((*reported)++ < MaxFailedReport) {
+			std::fprintf(stderr, "FAILED: %s %" PRIx64 ": %d vs %d\n", what, address.toUint(), got, wanted);
+		}
+	};
+
+	const QHash<edb::address_t, int> &call_targets = scanner.callTargets();
+	for (auto it = expected.callTargets.begin(); it != expected.callTargets.end(); ++it) {
+		const int got = call_targets.value(it.key());
+		if (got != it.value()) {
+			report("call target", it.key(), got, it.value());
+		}
+	}
+
+	for (auto it = call_targets.begin(); it != call_targets.end(); ++it) {
+		if (!expected.callTargets.contains(it.key())) {
+			report("call target", it.key(), it.value(), 0);
+		}
+	}
+
+	const QSet<edb::address_t> &landing_pads = scanner.landingPads();
+	for (const edb::address_t address : expected.landingPads) {
+		if (!landing_pads.contains(address)) {
+			report("landing pad", address, 0, 1);
+		}
+	}
+
+	for (const edb::address_t address : landing_pads) {
+		if (!expected.landingPads.contains(address)) {
+			report("landing pad", address, 1, 0);
+		}
+	}
+
+	return failed;
+}
+
+/**
+ * @return the number of differences between the results of a scan of only the
+ * changed pages, <updated>, and those of a scan of everything, <expected>
+ */
+uint64_t compare(const AnalyzerPlugin::FuzzyScanResults &updated, const AnalyzerPlugin::FuzzyScanResults &expected, uint64_t *reported) {
+
+	uint64_t failed = 0;
+
+	auto report = [&](const char *what, uint64_t value, int got, int wanted) {
+		++failed;
+		if ((*reported)++ < MaxFailedReport) {
+			std::fprintf(stderr, "FAILED: update %s %" PRIx64 ": %d vs %d\n", what, value, got, wanted);
+		}
+	};
+
+	// the call sites have to be in the same order too
+	const int sites = std::max(updated.callSites.size(), expected.callSites.size());
+	for (int i = 0; i < sites; ++i) {
+		if (i >= updated.callSites.size()) {
+			report("call site", expected.callSites[i].offset, 0, 1);
+		} else if (i >= expected.callSites.size()) {
+			report("call site", updated.callSites[i].offset, 1, 0);
+		} else if (updated.callSites[i].offset != expected.callSites[i].offset || updated.callSites[i].target != expected.callSites[i].target) {
+			report("call site", updated.callSites[i].offset, 1, 0);
+		}
+	}
+
+	for (auto it = expected.callTargets.begin(); it != expected.callTargets.end(); ++it) {
+		const int got = updated.callTargets.value(it.key());
+		if (got != it.value()) {
+			report("call target", it.key().toUint(), got, it.value());
+		}
+	}
+
+	for (auto it = updated.callTargets.begin(); it != updated.callTargets.end(); ++it) {
+		if (!expected.callTargets.contains(it.key())) {
+			report("call target", it.key().toUint(), it.value(), 0);
+		}
+	}
+
+	for (const edb::address_t address : expected.landingPads) {
+		if (!updated.landingPads.contains(address)) {
+			report("landing pad", address.toUint(), 0, 1);
+		}
+	}
+
+	for (const edb::address_t address : updated.landingPads) {
+		if (!expected.landingPads.contains(address)) {
+			report("landing pad", address.toUint(), 1, 0);
+		}
+	}
+
+	return failed;
+}
+
+/**
+ * changes some pages of <memory>, the way a debuggee may patch itself or be
+ * patched between two analyses
+ *
+ * @return the changed ranges, in order of their offset
+ */
+std::vector<AnalyzerPlugin::FuzzyScanner::Range> change_pages(QVector<uint8_t> *memory, std::mt19937 *engine) {
+
+	const std::size_t size  = static_cast<std::size_t>(memory->size());
+	const std::size_t pages = (size + PageSize - 1) / PageSize;
+
+	std::uniform_int_distribution<std::size_t> page_distribution(0, pages - 1);
+	std::uniform_int_distribution<int> byte_distribution(0, 0xff);
+	std::uniform_int_distribution<int> kind_distribution(0, 3);
+
+	std::vector<bool> changed(pages);
+	for (std::size_t n = 1 + page_distribution(*engine) % 8; n != 0; --n) {
+		const std::size_t page  = page_distribution(*engine);
+		const std::size_t first = page * PageSize;
+		const std::size_t last  = std::min(first + PageSize, size);
+
+		switch (kind_distribution(*engine)) {
+		case 0:
+			// a single byte right at the start, where it ends instructions which
+			// start on the page before
+			(*memory)[static_cast<int>(first)] ^= 0xff;
+			break;
+		case 1:
+			// a call right at the end, its target is on the next page
+			(*memory)[static_cast<int>(last - 1)] = 0xe8;
+			break;
+		case 2:
+			// the code of some other page, so calls move around
+			for (std::size_t i = first, j = page_distribution(*engine) * PageSize; i != last && j < size; ++i, ++j) {
+				(*memory)[static_cast<int>(i)] = (*memory)[static_cast<int>(j)];
+			}
+			break;
+		default:
+			for (std::size_t i = first; i != last; ++i) {
+				(*memory)[static_cast<int>(i)] = static_cast<uint8_t>(byte_distribution(*engine));
+			}
+			break;
+		}
+
+		changed[page] = true;
+	}
+
+	std::vector<AnalyzerPlugin::FuzzyScanner::Range> ranges;
+	for (std::size_t page = 0; page != pages; ++page) {
+		if (changed[page]) {
+			const std::size_t first = page * PageSize;
+			const std::size_t last  = std::min(first + PageSize, size);
+			if (!ranges.empty() && ranges.back().second == first) {
+				ranges.back().second = last;
+			} else {
+				ranges.emplace_back(first, last);
+			}
+		}
+	}
+
+	return ranges;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	std::vector<std::pair<const char *, QVector<uint8_t>>> corpora;
+	for (int i = 1; i < argc; ++i) {
+		corpora.emplace_back(argv[i], read_file(argv[i]));
+	}
+
+	corpora.emplace_back("random bytes", random_bytes());
+
+	const std::atomic<bool> cancelled{false};
+
+	uint64_t total    = 0;
+	uint64_t failed   = 0;
+	uint64_t reported = 0;
+
+	for (const CapstoneEDB::Architecture arch : {CapstoneEDB::Architecture::ARCH_AMD64, CapstoneEDB::Architecture::ARCH_X86}) {
+
+		if (!CapstoneEDB::init(arch)) {
+			std::fprintf(stderr, "unable to initialize capstone\n");
+			return EXIT_FAILURE;
+		}
+
+		const char *const mode = arch == CapstoneEDB::Architecture::ARCH_AMD64 ? "64-bit" : "32-bit";
+
+		for (const auto &corpus : corpora) {
+			const Scan expected = reference_scan(corpus.second);
+
+			// the scanner won't make chunks smaller than 64 KiB, so
+			// the big thread counts only make a difference for the bigger corpora
+			for (const unsigned int threads : {1u, 2u, 3u, 8u, 16u}) {
+				AnalyzerPlugin::FuzzyScanner scanner(Base, corpus.second, cancelled);
+				scanner.run(threads);
+
+				const uint64_t differences = compare(scanner, expected, &reported);
+
+				std::printf("%-6s %2u thread(s) %s: %d call targets, %d landing pads, %" PRIu64 " differences\n",
+							mode,
+							threads,
+							corpus.first,
+							static_cast<int>(expected.callTargets.size()),
+							static_cast<int>(expected.landingPads.size()),
+							differences);
+
+				++total;
+				failed += differences != 0;
+			}
+
+			// every round starts from the results of the one before,
+			// so whatever an update gets wrong is carried into the next one
+			std::mt19937 engine(0x20240301);
+			QVector<uint8_t> memory = corpus.second;
+
+			AnalyzerPlugin::FuzzyScanner first(Base, memory, cancelled);
+			first.run(1);
+			AnalyzerPlugin::FuzzyScanResults previous = first.results();
+
+			uint64_t differences = 0;
+			for (int round = 0; round < UpdateRounds; ++round) {
+				const unsigned int threads = 1u + static_cast<unsigned int>(round % 4);
+				const std::vector<AnalyzerPlugin::FuzzyScanner::Range> changed = change_pages(&memory, &engine);
+
+				AnalyzerPlugin::FuzzyScanner updated(Base, memory, cancelled);
+				updated.update(previous, changed, threads);
+
+				AnalyzerPlugin::FuzzyScanner scanner(Base, memory, cancelled);
+				scanner.run(threads);
+
+				differences += compare(updated.results(), scanner.results(), &reported);
+				previous = updated.results();
+			}
+
+			std::printf("%-6s %s: %d updates, %" PRIu64 " differences from scanning everything\n",
+						mode,
+						corpus.first,
+						UpdateRounds,
+						differences);
+
+			++total;
+			failed += differences != 0;
+		}
+	}
+
+	std::printf("scans: %" PRIu64 ", different from decoding every offset or scanning everything: %" PRIu64 "\n", total, failed);
+
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,104 @@
+#include "Instruction.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Decodes a buffer of typical compiler output over and over, reporting how many
+// instructions per second the decoder manages, both on a single thread and on
+// several threads at once (each one uses its own capstone handles).
+//
+// usage: InstructionBenchmark [seconds per run] [thread count]
+
+namespace {
+
+// a typical function prologue/body/epilogue, x86-64 encoding
+const uint8_t Snippet[] = {
+	0x55,                                     // push rbp
+	0x48, 0x89, 0xe5,                         // mov rbp, rsp
+	0x48, 0x83, 0xec, 0x20,                   // sub rsp, 0x20
+	0x89, 0x7d, 0xfc,                         // mov dword ptr [rbp - 4], edi
+	0x48, 0x8b, 0x45, 0xf0,                   // mov rax, qword ptr [rbp - 0x10]
+	0xe8, 0x00, 0x00, 0x00, 0x00,             // call $+5
+	0x85, 0xc0,                               // test eax, eax
+	0x74, 0x05,                               // je $+7
+	0x48, 0x8d, 0x05, 0x10, 0x00, 0x00, 0x00, // lea rax, [rip + 0x10]
+	0xc5, 0xf8, 0x77,                         // vzeroupper
+	0x0f, 0x1f, 0x44, 0x00, 0x00,             // nop dword ptr [rax + rax]
+	0xc9,                                     // leave
+	0xc3,                                     // ret
+};
+
+constexpr std::size_t BufferSize = 64 * 1024;
+
+std::vector<uint8_t> make_buffer() {
+	std::vector<uint8_t> buffer;
+	buffer.reserve(BufferSize);
+	while (buffer.size() + sizeof(Snippet) <= BufferSize) {
+		buffer.insert(buffer.end(), std::begin(Snippet), std::end(Snippet));
+	}
+	return buffer;
+}
+
+uint64_t decode_for(const std::vector<uint8_t> &buffer, std::chrono::duration<double> duration, CapstoneEDB::Instruction::Mode mode) {
+
+	const auto deadline = std::chrono::steady_clock::now() + duration;
+	uint64_t count      = 0;
+
+	do {
+		const uint8_t *p    = buffer.data();
+		const uint8_t *last = buffer.data() + buffer.size();
+		while (p < last) {
+			const CapstoneEDB::Instruction insn(p, std::min(p + CapstoneEDB::Instruction::MaxSize, last), static_cast<uint64_t>(p - buffer.data()), mode);
+			p += insn.byteSize();
+			++count;
+		}
+	} while (std::chrono::steady_clock::now() < deadline);
+
+	return count;
+}
+
+void run(const char *name, const std::vector<uint8_t> &buffer, double seconds, unsigned int threads, CapstoneEDB::Instruction::Mode mode) {
+
+	std::atomic<uint64_t> total{0};
+	std::vector<std::thread> workers;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (unsigned int i = 0; i < threads; ++i) {
+		workers.emplace_back([&]() {
+			total += decode_for(buffer, std::chrono::duration<double>(seconds), mode);
+		});
+	}
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	std::printf("%-8s %3u thread(s): %12.0f instructions/s\n", name, threads, static_cast<double>(total) / elapsed.count());
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	const double seconds       = (argc > 1) ? std::atof(argv[1]) : 1.0;
+	const unsigned int threads = (argc > 2) ? static_cast<unsigned int>(std::atoi(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+
+	if (!CapstoneEDB::init(CapstoneEDB::Architecture::ARCH_AMD64)) {
+		std::fprintf(stderr, "unable to initialize capstone\n");
+		return EXIT_FAILURE;
+	}
+
+	const std::vector<uint8_t> buffer = make_buffer();
+
+	run("full", buffer, seconds, 1, CapstoneEDB::Instruction::Mode::Full);
+	run("full", buffer, seconds, threads, CapstoneEDB::Instruction::Mode::Full);
+	run("basic", buffer, seconds, 1, CapstoneEDB::Instruction::Mode::Basic);
+	run("basic", buffer, seconds, threads, CapstoneEDB::Instruction::Mode::Basic);
+}
@@ -0,0 +1,268 @@
+#include "Inspection.h"
+#include "Instruction.h"
+#include "LengthDecoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// Decodes every byte offset of a corpus with both the length decoder and
+// capstone and fails if they disagree about anything the length decoder claims
+// to know. Afterwards it reports how much of the corpus the length decoder
+// could handle on its own, and how fast both of them are. This is done in
+// 64-bit mode, and again in 32-bit mode along with the encodings which only
+// mean something there.
+//
+// usage: LengthDecoderTest [file...]
+//
+// the files are used as (mostly) real code, a block of pseudo random bytes is
+// always added to that
+
+namespace {
+
+constexpr std::size_t RandomSize = 1024 * 1024;
+
+// how many of the offsets capstone rejects get shown
+constexpr std::size_t MaxInvalidReported = 16;
+
+struct Stats {
+	uint64_t total   = 0;
+	uint64_t unknown = 0;
+	uint64_t invalid = 0; // capstone couldn't decode it either
+};
+
+std::vector<uint8_t> make_corpus(int argc, char *argv[]) {
+
+	std::vector<uint8_t> corpus;
+
+	for (int i = 1; i < argc; ++i) {
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file) {
+			std::fprintf(stderr, "unable to open %s\n", argv[i]);
+			std::exit(EXIT_FAILURE);
+		}
+
+		corpus.insert(corpus.end(), std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	std::mt19937 engine(0x20240301);
+	std::uniform_int_distribution<int> distribution(0, 0xff);
+	std::generate_n(std::back_inserter(corpus), RandomSize, [&]() { return static_cast<uint8_t>(distribution(engine)); });
+
+	return corpus;
+}
+
+// capstone doesn't put loop and friends (or the far and
+// interrupt returns) in the same groups in every version, so this goes by the
+// instruction itself where it can
+bool same_flow(CapstoneEDB::Flow flow, const CapstoneEDB::Instruction &insn) {
+
+	const unsigned int op = insn.operation();
+
+	switch (flow) {
+	case CapstoneEDB::Flow::Call:
+		return op == X86_INS_CALL || op == X86_INS_LCALL;
+	case CapstoneEDB::Flow::Jump:
+		return is_unconditional_jump(insn);
+	case CapstoneEDB::Flow::ConditionalJump:
+		return is_conditional_jump(insn) || op == X86_INS_LOOP || op == X86_INS_LOOPE || op == X86_INS_LOOPNE;
+	case CapstoneEDB::Flow::Return:
+		return op == X86_INS_RET || op == X86_INS_RETF || op == X86_INS_RETFQ || op == X86_INS_IRET || op == X86_INS_IRETD || op == X86_INS_IRETQ;
+	case CapstoneEDB::Flow::Interrupt:
+		return is_interrupt(insn);
+	case CapstoneEDB::Flow::Syscall:
+		return op == X86_INS_SYSCALL || op == X86_INS_SYSRET || op == X86_INS_SYSENTER || op == X86_INS_SYSEXIT;
+	default:
+		return !is_call(insn) && !is_jump(insn) && !is_return(insn) && !is_interrupt(insn);
+	}
+}
+
+void print_bytes(const uint8_t *first, const uint8_t *last) {
+	for (const uint8_t *p = first; p != last; ++p) {
+		std::fprintf(stderr, " %02x", *p);
+	}
+}
+
+/**
+ * compares the length decoder with capstone at <offset>
+ *
+ * @return false if they disagree
+ */
+bool check_one(const std::vector<uint8_t> &corpus, std::size_t offset, Stats *stats) {
+
+	const uint8_t *first = corpus.data() + offset;
+	const uint8_t *last  = corpus.data() + std::min(offset + CapstoneEDB::Instruction::MaxSize, corpus.size());
+
+	const CapstoneEDB::LengthInfo info = CapstoneEDB::decode_length(first, last, offset);
+	const CapstoneEDB::Instruction insn(first, last, offset);
+
+	++stats->total;
+
+	if (info.size == 0) {
+		++stats->unknown;
+		return true;
+	}
+
+	if (!insn) {
+		// the decoder doesn't try to recognise every invalid
+		// encoding, the length it gives is still what the CPU would use. It
+		// must not take one for a branch though, the analysis would follow it
+		if (stats->invalid++ < MaxInvalidReported) {
+			std::fprintf(stderr, "invalid: [@%zx]", offset);
+			print_bytes(first, first + info.size);
+			std::fprintf(stderr, "\n");
+		}
+
+		if (info.flow != CapstoneEDB::Flow::None || info.hasTarget) {
+			std::fprintf(stderr, "FAILED: [@%zx] invalid encoding decoded as a branch\n", offset);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool target_ok = true;
+	if (info.hasTarget) {
+		const CapstoneEDB::Operand operand = insn[0];
+		target_ok                          = is_immediate(operand) && static_cast<uint64_t>(operand->imm) == info.target;
+	}
+
+	if (info.size != insn.byteSize() || !same_flow(info.flow, insn) || !target_ok) {
+		std::fprintf(stderr, "FAILED: [@%zx] %s %s: size %u vs %zu\n", offset, insn.mnemonic().c_str(), insn->op_str, info.size, insn.byteSize());
+		return false;
+	}
+
+	return true;
+}
+
+bool check(const std::vector<uint8_t> &corpus, Stats *stats) {
+
+	bool ok = true;
+
+	for (std::size_t offset = 0; offset < corpus.size(); ++offset) {
+		if (!check_one(corpus, offset, stats)) {
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+/**
+ * the encodings which mean something else (or nothing) in 64-bit mode, the
+ * length decoder has to know these, not just agree with capstone about them
+ */
+bool check_x86_only() {
+
+	std::vector<std::vector<uint8_t>> encodings = {
+		{0x9a, 0x78, 0x56, 0x34, 0x12, 0x08, 0x00}, // lcall 0x8:0x12345678
+		{0x66, 0x9a, 0x34, 0x12, 0x08, 0x00},       // lcall 0x8:0x1234
+		{0xea, 0x78, 0x56, 0x34, 0x12, 0x08, 0x00}, // ljmp 0x8:0x12345678
+		{0x66, 0xea, 0x34, 0x12, 0x08, 0x00},       // ljmp 0x8:0x1234
+		{0x62, 0x00},                               // bound eax, [eax]
+		{0x62, 0x45, 0x08},                         // bound eax, [ebp + 8]
+		{0x66, 0x62, 0x0c, 0x24},                   // bound cx, [esp]
+		{0xc4, 0x00},                               // les eax, [eax]
+		{0xc4, 0x4e, 0x10},                         // les ecx, [esi + 0x10]
+		{0xc5, 0x46, 0x10},                         // lds eax, [esi + 0x10]
+		{0xc5, 0x05, 0x78, 0x56, 0x34, 0x12},       // lds eax, [0x12345678]
+	};
+
+	// inc and dec, REX prefixes in 64-bit mode
+	for (uint8_t opcode = 0x40; opcode <= 0x4f; ++opcode) {
+		encodings.push_back({opcode});
+	}
+
+	bool ok = true;
+
+	for (const std::vector<uint8_t> &encoding : encodings) {
+
+		// something valid after it, so that reading too far is noticed
+		std::vector<uint8_t> corpus = encoding;
+		corpus.push_back(0x90);
+
+		const CapstoneEDB::LengthInfo info = CapstoneEDB::decode_length(corpus.data(), corpus.data() + corpus.size(), 0);
+		const CapstoneEDB::Instruction insn(corpus.data(), corpus.data() + corpus.size(), 0);
+
+		Stats stats;
+		if (!insn || info.size != encoding.size() || !check_one(corpus, 0, &stats)) {
+			std::fprintf(stderr, "FAILED: [32-bit]");
+			print_bytes(encoding.data(), encoding.data() + encoding.size());
+			std::fprintf(stderr, ": size %u vs %zu\n", info.size, encoding.size());
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+template <class F>
+double bytes_per_second(const std::vector<uint8_t> &corpus, F decode) {
+
+	const auto start  = std::chrono::steady_clock::now();
+	const uint8_t *p  = corpus.data();
+	const uint8_t *pe = corpus.data() + corpus.size();
+
+	// a linear sweep, like most scanners do
+	while (p < pe) {
+		p += std::max<std::size_t>(1, decode(p, pe, static_cast<uint64_t>(p - corpus.data())));
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return static_cast<double>(corpus.size()) / elapsed.count();
+}
+
+bool run(const char *name, CapstoneEDB::Architecture arch, const std::vector<uint8_t> &corpus) {
+
+	if (!CapstoneEDB::init(arch)) {
+		std::fprintf(stderr, "unable to initialize capstone\n");
+		return false;
+	}
+
+	Stats stats;
+	bool ok = check(corpus, &stats);
+
+	if (arch == CapstoneEDB::Architecture::ARCH_X86 && !check_x86_only()) {
+		ok = false;
+	}
+
+	std::printf("%s: offsets: %" PRIu64 ", decoded without capstone: %.2f%%, invalid according to capstone: %" PRIu64 "\n",
+				name,
+				stats.total,
+				100.0 * static_cast<double>(stats.total - stats.unknown) / static_cast<double>(stats.total),
+				stats.invalid);
+
+	const double lde = bytes_per_second(corpus, [](const uint8_t *p, const uint8_t *pe, uint64_t rva) -> std::size_t {
+		return CapstoneEDB::decode_length(p, pe, rva).size;
+	});
+
+	const double capstone = bytes_per_second(corpus, [](const uint8_t *p, const uint8_t *pe, uint64_t rva) -> std::size_t {
+		return CapstoneEDB::Instruction(p, std::min(p + CapstoneEDB::Instruction::MaxSize, pe), rva, CapstoneEDB::Instruction::Mode::Basic).byteSize();
+	});
+
+	std::printf("%s: length decoder: %14.0f bytes/s\n", name, lde);
+	std::printf("%s: capstone:       %14.0f bytes/s\n", name, capstone);
+
+	return ok;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	const std::vector<uint8_t> corpus = make_corpus(argc, argv);
+
+	bool ok = run("x86-64", CapstoneEDB::Architecture::ARCH_AMD64, corpus);
+
+	if (!run("x86", CapstoneEDB::Architecture::ARCH_X86, corpus)) {
+		ok = false;
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
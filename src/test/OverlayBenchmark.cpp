@@ -0,0 +1,217 @@
+#include "BreakpointOverlay.h"
+#include "IBreakpoint.h"
+#include "Types.h"
+#include <QHash>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Puts the original bytes of the breakpoints back into a buffer which was just
+// read from the debuggee, with the same breakpoints_overlapping and
+// restore_breakpoint_bytes that DebuggerCoreBase and PlatformProcess use.
+// Compared with visiting every breakpoint, which is how it used to be done.
+// Reports how many reads per second each of them manages for a growing number
+// of breakpoints, for reads of a single instruction and of a whole page, and
+// how long a single 64 MiB read takes with 10000 breakpoints in it.
+//
+// usage: OverlayBenchmark [seconds per run]
+
+namespace {
+
+using DebuggerCorePlugin::BreakpointIndex;
+
+constexpr uint64_t Base         = 0x400000;
+constexpr uint64_t Span         = 64 * 1024 * 1024; // the breakpoints are somewhere in here
+constexpr std::size_t MaxSize   = 2;                // the same as Breakpoint::MaxSize on x86
+constexpr std::size_t ReadMask  = 4095;             // there are ReadMask + 1 different reads
+constexpr int LargeCount        = 10000;
+constexpr std::size_t LargeRead = Span;
+
+// all the overlay needs from a breakpoint, without a debuggee to write it to
+class TestBreakpoint final : public IBreakpoint {
+public:
+	explicit TestBreakpoint(edb::address_t address)
+		: address_(address) {
+	}
+
+public:
+	[[nodiscard]] edb::address_t address() const override { return address_; }
+	[[nodiscard]] uint64_t hitCount() const override { return 0; }
+	[[nodiscard]] bool enabled() const override { return true; }
+	[[nodiscard]] bool oneTime() const override { return false; }
+	[[nodiscard]] bool internal() const override { return false; }
+	[[nodiscard]] const uint8_t *originalBytes() const override { return originalBytes_.data(); }
+	[[nodiscard]] size_t size() const override { return 1; }
+	[[nodiscard]] TypeId type() const override { return TypeId::Automatic; }
+
+public:
+	bool enable() override { return true; }
+	bool disable() override { return true; }
+	void hit() override {}
+	void setOneTime(bool) override {}
+	void setInternal(bool) override {}
+	void setType(TypeId) override {}
+
+private:
+	edb::address_t address_;
+	std::array<uint8_t, MaxSize> originalBytes_ = {0x90, 0x90};
+};
+
+using BreakpointList = QHash<edb::address_t, std::shared_ptr<IBreakpoint>>;
+
+/**
+ * the way it used to be done
+ */
+void restore_all(const BreakpointList &breakpoints, edb::address_t address, uint8_t *buf, std::size_t len) {
+	for (const std::shared_ptr<IBreakpoint> &bp : breakpoints) {
+		for (std::size_t i = 0; i < bp->size(); ++i) {
+			if (bp->address() + i >= address && bp->address() + i < address + len) {
+				buf[(bp->address() + i - address).toUint()] = bp->originalBytes()[i];
+			}
+		}
+	}
+}
+
+/**
+ * the way PlatformProcess::restoreBreakpointBytes does it
+ */
+void restore_indexed(const BreakpointIndex &index, edb::address_t address, uint8_t *buf, std::size_t len) {
+	DebuggerCorePlugin::restore_breakpoint_bytes(DebuggerCorePlugin::breakpoints_overlapping(index, address, len, MaxSize), address, buf, len);
+}
+
+void add_breakpoints(BreakpointList *breakpoints, BreakpointIndex *index, int count, std::mt19937 *engine) {
+
+	std::uniform_int_distribution<uint64_t> distribution(0, Span - 1);
+
+	while (breakpoints->size() < count) {
+		auto bp = std::make_shared<TestBreakpoint>(Base + distribution(*engine));
+
+		(*breakpoints)[bp->address()] = bp;
+		(*index)[bp->address()]       = bp;
+	}
+}
+
+template <class F>
+double reads_per_second(const std::vector<edb::address_t> &reads, std::size_t len, double seconds, F overlay) {
+
+	std::vector<uint8_t> buffer(len);
+
+	const auto start    = std::chrono::steady_clock::now();
+	const auto deadline = start + std::chrono::duration<double>(seconds);
+	uint64_t count      = 0;
+
+	do {
+		for (const edb::address_t address : reads) {
+			overlay(address, buffer.data(), len);
+		}
+		count += reads.size();
+	} while (std::chrono::steady_clock::now() < deadline);
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return static_cast<double>(count) / elapsed.count();
+}
+
+/**
+ * @return true if both ways come up with the same bytes for every read, or the
+ * numbers mean nothing
+ */
+bool same_overlay(const BreakpointList &breakpoints, const BreakpointIndex &index, const std::vector<edb::address_t> &reads, std::size_t len) {
+
+	std::vector<uint8_t> expected(len);
+	std::vector<uint8_t> got(len);
+
+	for (const edb::address_t address : reads) {
+		std::fill(expected.begin(), expected.end(), 0xcc);
+		std::fill(got.begin(), got.end(), 0xcc);
+		restore_all(breakpoints, address, expected.data(), len);
+		restore_indexed(index, address, got.data(), len);
+		if (expected != got) {
+			std::fprintf(stderr, "FAILED: the overlays differ at %" PRIx64 "\n", address.toUint());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	const double seconds = (argc > 1) ? std::atof(argv[1]) : 1.0;
+
+	std::mt19937 engine(0x20240301);
+	std::uniform_int_distribution<uint64_t> distribution(0, Span - 1);
+
+	for (const int count : {1, 16, 256, 4096, LargeCount}) {
+
+		BreakpointList breakpoints;
+		BreakpointIndex index;
+		add_breakpoints(&breakpoints, &index, count, &engine);
+
+		for (const std::size_t len : {std::size_t{16}, std::size_t{4096}}) {
+
+			// mostly at random, and every now and then right where a breakpoint
+			// is, which is what the disassembly view does
+			std::vector<edb::address_t> reads;
+			for (std::size_t i = 0; i <= ReadMask; ++i) {
+				if (i % 8 == 0) {
+					auto it = std::next(index.cbegin(), static_cast<int>(i % static_cast<std::size_t>(count)));
+					reads.push_back(it.key() - (i % len));
+				} else {
+					reads.push_back(Base + distribution(engine));
+				}
+			}
+
+			if (!same_overlay(breakpoints, index, reads, len)) {
+				return EXIT_FAILURE;
+			}
+
+			const double all = reads_per_second(reads, len, seconds, [&](edb::address_t address, uint8_t *buf, std::size_t size) {
+				restore_all(breakpoints, address, buf, size);
+			});
+
+			const double indexed = reads_per_second(reads, len, seconds, [&](edb::address_t address, uint8_t *buf, std::size_t size) {
+				restore_indexed(index, address, buf, size);
+			});
+
+			std::printf("%5d breakpoint(s), %4zu byte reads: %12.0f reads/s visiting all, %12.0f reads/s indexed (%.1fx)\n",
+						count,
+						len,
+						all,
+						indexed,
+						indexed / all);
+		}
+
+		// the whole region in one read, every breakpoint is in it
+		if (count == LargeCount) {
+			const std::vector<edb::address_t> reads = {edb::address_t(Base)};
+
+			if (!same_overlay(breakpoints, index, reads, LargeRead)) {
+				return EXIT_FAILURE;
+			}
+
+			const double all = reads_per_second(reads, LargeRead, seconds, [&](edb::address_t address, uint8_t *buf, std::size_t size) {
+				restore_all(breakpoints, address, buf, size);
+			});
+
+			const double indexed = reads_per_second(reads, LargeRead, seconds, [&](edb::address_t address, uint8_t *buf, std::size_t size) {
+				restore_indexed(index, address, buf, size);
+			});
+
+			std::printf("%5d breakpoint(s),   64 MiB read: %12.1f us visiting all, %12.1f us indexed (%.1fx)\n",
+						count,
+						1e6 / all,
+						1e6 / indexed,
+						indexed / all);
+		}
+	}
+}
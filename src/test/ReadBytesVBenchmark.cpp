@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <sys/mman.h>
+#include <sys/ptrace.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Reads a batch of small scattered ranges out of a stopped debuggee, the way
+// the call stack and the heap analyzer look at candidate pointers, and reports
+// how many syscalls and how much time a batch takes. Once one range after the
+// other, the way PlatformProcess::readBytes does it with a cold page cache (a
+// page sized read of /proc/<pid>/mem for every page which isn't cached yet),
+// and once the way PlatformProcess::readBytesV does it (a process_vm_readv
+// for every IOV_MAX ranges).
+//
+// usage: ReadBytesVBenchmark [rounds per batch size]
+
+namespace {
+
+constexpr std::size_t Span          = 64 * 1024 * 1024; // the ranges are somewhere in here
+constexpr std::size_t RangeSize     = 16;
+constexpr std::size_t PageSize      = 4096;
+constexpr std::size_t CacheCapacity = 256; // the same as PageCacheCapacity
+constexpr std::size_t IovBatchSize  = IOV_MAX;
+constexpr int DefaultRounds         = 50;
+
+struct Range {
+	uint64_t address;
+	uint8_t *buf;
+};
+
+struct Measurement {
+	double microseconds = 0;
+	uint64_t syscalls   = 0;
+};
+
+uint8_t pattern(std::size_t offset) {
+	return static_cast<uint8_t>((offset * 0x9e3779b1u) >> 13);
+}
+
+/**
+ * what the debuggee does, it never returns
+ */
+[[noreturn]] void debuggee(uint8_t *memory) {
+
+	if (ptrace(PTRACE_TRACEME, 0, nullptr, nullptr) == -1) {
+		_exit(EXIT_FAILURE);
+	}
+
+	// only the debuggee has the pattern, so whatever we read is really its own
+	for (std::size_t i = 0; i < Span; ++i) {
+		memory[i] = pattern(i);
+	}
+
+	raise(SIGSTOP);
+	_exit(EXIT_SUCCESS);
+}
+
+/**
+ * the way PlatformProcess::readBytes goes about it, one range after the other
+ * through a page cache which starts out empty, as it does after every resume
+ */
+bool read_one_by_one(int mem, const std::vector<Range> &ranges, uint64_t *syscalls) {
+
+	std::unordered_map<uint64_t, std::array<uint8_t, PageSize>> cache;
+
+	for (const Range &range : ranges) {
+		std::size_t done = 0;
+		while (done < RangeSize) {
+			const uint64_t current = range.address + done;
+			const uint64_t page    = current & ~(PageSize - 1);
+			const std::size_t n    = std::min(PageSize - (current - page), RangeSize - done);
+
+			auto it = cache.find(page);
+			if (it == cache.end()) {
+				// close enough to an LRU for ranges all over the place
+				if (cache.size() == CacheCapacity) {
+					cache.clear();
+				}
+
+				it = cache.emplace(page, std::array<uint8_t, PageSize>()).first;
+				++*syscalls;
+				if (pread(mem, it->second.data(), PageSize, static_cast<off_t>(page)) != static_cast<ssize_t>(PageSize)) {
+					return false;
+				}
+			}
+
+			std::memcpy(range.buf + done, it->second.data() + (current - page), n);
+			done += n;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * the way PlatformProcess::readBytesV goes about it
+ */
+bool read_batched(pid_t pid, const std::vector<Range> &ranges, uint64_t *syscalls) {
+
+	std::vector<iovec> local(IovBatchSize);
+	std::vector<iovec> remote(IovBatchSize);
+
+	for (std::size_t index = 0; index < ranges.size();) {
+		std::size_t n = 0;
+		for (; n < IovBatchSize && index + n < ranges.size(); ++n) {
+			local[n].iov_base  = ranges[index + n].buf;
+			local[n].iov_len   = RangeSize;
+			remote[n].iov_base = reinterpret_cast<void *>(ranges[index + n].address);
+			remote[n].iov_len  = RangeSize;
+		}
+
+		++*syscalls;
+		if (process_vm_readv(pid, local.data(), n, remote.data(), n, 0) != static_cast<ssize_t>(n * RangeSize)) {
+			return false;
+		}
+
+		index += n;
+	}
+
+	return true;
+}
+
+template <class F>
+Measurement measure(const std::vector<Range> &ranges, int rounds, F read) {
+
+	Measurement m;
+	std::chrono::duration<double, std::micro> total{0};
+
+	for (int i = 0; i < rounds; ++i) {
+		uint64_t syscalls = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+		if (!read(ranges, &syscalls)) {
+			m.microseconds = -1.0;
+			return m;
+		}
+		total += std::chrono::steady_clock::now() - start;
+		m.syscalls = syscalls;
+	}
+
+	m.microseconds = total.count() / rounds;
+	return m;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	const int rounds = (argc > 1) ? std::max(1, std::atoi(argv[1])) : DefaultRounds;
+
+	void *const mapping = mmap(nullptr, Span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED) {
+		std::perror("mmap");
+		return EXIT_FAILURE;
+	}
+
+	// the debuggee is a fork of us, so the memory is at the same address
+	// over there
+	auto memory = static_cast<uint8_t *>(mapping);
+
+	const pid_t pid = fork();
+	if (pid == -1) {
+		std::perror("fork");
+		return EXIT_FAILURE;
+	}
+
+	if (pid == 0) {
+		debuggee(memory);
+	}
+
+	int status;
+	if (waitpid(pid, &status, __WALL) != pid || !WIFSTOPPED(status)) {
+		std::fprintf(stderr, "the debuggee didn't stop\n");
+		return EXIT_FAILURE;
+	}
+
+	char path[64];
+	std::snprintf(path, sizeof(path), "/proc/%d/mem", pid);
+
+	const int mem = open(path, O_RDONLY);
+	if (mem == -1) {
+		std::perror("open");
+		kill(pid, SIGKILL);
+		return EXIT_FAILURE;
+	}
+
+	std::mt19937 engine(0x20240301);
+	std::uniform_int_distribution<std::size_t> distribution(0, (Span - RangeSize) / 8);
+
+	int result = EXIT_SUCCESS;
+
+	for (const std::size_t count : {std::size_t{16}, std::size_t{256}, std::size_t{4096}}) {
+
+		std::vector<uint8_t> expected_buffer(count * RangeSize);
+		std::vector<uint8_t> one_by_one_buffer(count * RangeSize);
+		std::vector<uint8_t> batched_buffer(count * RangeSize);
+
+		std::vector<std::size_t> offsets(count);
+		std::vector<Range> one_by_one_ranges(count);
+		std::vector<Range> batched_ranges(count);
+
+		for (std::size_t i = 0; i < count; ++i) {
+			// 8 byte aligned, like the pointers they stand in for
+			offsets[i] = distribution(engine) * 8;
+			for (std::size_t j = 0; j < RangeSize; ++j) {
+				expected_buffer[i * RangeSize + j] = pattern(offsets[i] + j);
+			}
+
+			one_by_one_ranges[i] = {reinterpret_cast<uint64_t>(memory + offsets[i]), &one_by_one_buffer[i * RangeSize]};
+			batched_ranges[i]    = {reinterpret_cast<uint64_t>(memory + offsets[i]), &batched_buffer[i * RangeSize]};
+		}
+
+		const Measurement one_by_one = measure(one_by_one_ranges, rounds, [mem](const std::vector<Range> &ranges, uint64_t *syscalls) {
+			return read_one_by_one(mem, ranges, syscalls);
+		});
+
+		const Measurement batched = measure(batched_ranges, rounds, [pid](const std::vector<Range> &ranges, uint64_t *syscalls) {
+			return read_batched(pid, ranges, syscalls);
+		});
+
+		if (one_by_one.microseconds < 0 || batched.microseconds < 0) {
+			std::fprintf(stderr, "unable to read the debuggee: %s\n", std::strerror(errno));
+			result = EXIT_FAILURE;
+			break;
+		}
+
+		// both have to come up with the debuggee's bytes, or the numbers mean nothing
+		if (one_by_one_buffer != expected_buffer || batched_buffer != expected_buffer) {
+			std::fprintf(stderr, "FAILED: the bytes read differ from the debuggee's\n");
+			result = EXIT_FAILURE;
+			break;
+		}
+
+		std::printf("%5zu ranges: %5llu syscalls %9.1f us one by one, %3llu syscalls %9.1f us batched (%.1fx)\n",
+					count,
+					static_cast<unsigned long long>(one_by_one.syscalls),
+					one_by_one.microseconds,
+					static_cast<unsigned long long>(batched.syscalls),
+					batched.microseconds,
+					one_by_one.microseconds / batched.microseconds);
+	}
+
+	close(mem);
+	kill(pid, SIGKILL);
+	waitpid(pid, nullptr, __WALL);
+	munmap(mapping, Span);
+
+	return result;
+}
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Stops every thread of a traced process over and over, the way
+// DebuggerCore::stopThreads does it on Linux, and reports how long stopping
+// all of them takes. Once one thread after the other, SIGSTOP and wait for
+// it, which is how it used to be done, and once by sending SIGSTOP to all of
+// them before waiting for any, which is how it is done now.
+//
+// Half of the threads of the debuggee are busy, the others are asleep most of
+// the time, like in most real programs.
+//
+// usage: ThreadStopBenchmark [rounds per run]
+
+namespace {
+
+constexpr int DefaultRounds = 200;
+
+/**
+ * what the debuggee does, it never returns
+ */
+[[noreturn]] void debuggee(int threads, int ready) {
+
+	std::atomic<bool> spin{true};
+
+	for (int i = 1; i < threads; ++i) {
+		std::thread([i, &spin]() {
+			if (i % 2) {
+				while (spin) {
+				}
+			} else {
+				for (;;) {
+					usleep(1000);
+				}
+			}
+		}).detach();
+	}
+
+	// every thread exists now, the tracer can attach to them
+	const char c = 0;
+	if (write(ready, &c, 1) != 1) {
+		_exit(EXIT_FAILURE);
+	}
+
+	for (;;) {
+		usleep(1000);
+	}
+}
+
+std::vector<pid_t> thread_ids(pid_t pid) {
+
+	std::vector<pid_t> tids;
+
+	char path[64];
+	std::snprintf(path, sizeof(path), "/proc/%d/task", pid);
+
+	if (DIR *const dir = opendir(path)) {
+		while (const dirent *const entry = readdir(dir)) {
+			if (entry->d_name[0] != '.') {
+				tids.push_back(static_cast<pid_t>(std::atoi(entry->d_name)));
+			}
+		}
+		closedir(dir);
+	}
+
+	return tids;
+}
+
+bool stop(pid_t pid, pid_t tid) {
+	return syscall(SYS_tgkill, pid, tid, SIGSTOP) == 0;
+}
+
+bool wait_for_stop(pid_t tid) {
+	int status;
+	return waitpid(tid, &status, __WALL) == tid && WIFSTOPPED(status);
+}
+
+/**
+ * the way it used to be done
+ */
+bool stop_one_by_one(pid_t pid, const std::vector<pid_t> &tids) {
+	for (const pid_t tid : tids) {
+		if (!stop(pid, tid) || !wait_for_stop(tid)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * the way DebuggerCore::stopThreads does it
+ */
+bool stop_all_at_once(pid_t pid, const std::vector<pid_t> &tids) {
+	for (const pid_t tid : tids) {
+		if (!stop(pid, tid)) {
+			return false;
+		}
+	}
+
+	for (const pid_t tid : tids) {
+		if (!wait_for_stop(tid)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool resume(const std::vector<pid_t> &tids) {
+	for (const pid_t tid : tids) {
+		if (ptrace(PTRACE_CONT, tid, nullptr, nullptr) == -1) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @return the average number of microseconds <stop_threads> takes, or a
+ * negative number if anything went wrong
+ */
+template <class F>
+double measure(pid_t pid, const std::vector<pid_t> &tids, int rounds, F stop_threads) {
+
+	std::chrono::duration<double, std::micro> total{0};
+
+	for (int i = 0; i < rounds; ++i) {
+
+		// give the threads a moment to get back to what they were
+		// doing, otherwise they are still on their way out of the kernel
+		usleep(200);
+
+		const auto start = std::chrono::steady_clock::now();
+		if (!stop_threads(pid, tids)) {
+			return -1.0;
+		}
+		total += std::chrono::steady_clock::now() - start;
+
+		if (!resume(tids)) {
+			return -1.0;
+		}
+	}
+
+	return total.count() / rounds;
+}
+
+/**
+ * @return false if the debuggee couldn't be set up
+ */
+bool run(int threads, int rounds) {
+
+	int ready[2];
+	if (pipe(ready) == -1) {
+		return false;
+	}
+
+	const pid_t pid = fork();
+	if (pid == -1) {
+		return false;
+	}
+
+	if (pid == 0) {
+		close(ready[0]);
+		debuggee(threads, ready[1]);
+	}
+
+	close(ready[1]);
+
+	char c;
+	const bool started = read(ready[0], &c, 1) == 1;
+	close(ready[0]);
+
+	std::vector<pid_t> tids = started ? thread_ids(pid) : std::vector<pid_t>();
+
+	// PTRACE_ATTACH would send a SIGSTOP to the whole process,
+	// which stops the threads we aren't attached to yet too. Seizing doesn't
+	// stop anything
+	bool ok = static_cast<int>(tids.size()) == threads;
+	for (const pid_t tid : tids) {
+		ok = ok && ptrace(PTRACE_SEIZE, tid, nullptr, nullptr) == 0;
+	}
+
+	double one_by_one = -1.0;
+	double at_once    = -1.0;
+
+	if (ok) {
+		one_by_one = measure(pid, tids, rounds, stop_one_by_one);
+		at_once    = measure(pid, tids, rounds, stop_all_at_once);
+	}
+
+	// the leader isn't reported as gone before every other thread
+	// we trace has been reaped
+	kill(pid, SIGKILL);
+	for (const pid_t tid : tids) {
+		if (tid != pid) {
+			waitpid(tid, nullptr, __WALL);
+		}
+	}
+	waitpid(pid, nullptr, __WALL);
+
+	if (one_by_one < 0 || at_once < 0) {
+		std::fprintf(stderr, "unable to trace the debuggee: %s\n", std::strerror(errno));
+		return false;
+	}
+
+	std::printf("%3d thread(s): %9.1f us one by one, %9.1f us all at once (%.1fx)\n",
+				threads,
+				one_by_one,
+				at_once,
+				one_by_one / at_once);
+
+	return true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	const int rounds = (argc > 1) ? std::max(1, std::atoi(argv[1])) : DefaultRounds;
+
+	std::printf("%u CPU(s)\n", std::thread::hardware_concurrency());
+
+	for (const int threads : {1, 4, 16, 64}) {
+		if (!run(threads, rounds)) {
+			return EXIT_FAILURE;
+		}
+	}
+}
@@ -0,0 +1,326 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "InstructionBoundaries.h"
+#include "IAnalyzer.h"
+#include "IRegion.h"
+#include "Instruction.h"
+#include "InstructionCache.h"
+#include "Status.h"
+#include "edb.h"
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+/**
+ * starts over for a (possibly) different region
+ *
+ * @brief InstructionBoundaries::setRegion
+ * @param region
+ */
+void InstructionBoundaries::setRegion(const std::shared_ptr<IRegion> &region) {
+
+	region_ = region;
+	chunks_.clear();
+	anchors_.clear();
+
+	generation_ = CapstoneEDB::generation();
+	sequence_   = edb::v1::instruction_cache().sequence();
+
+	if (region_) {
+		start_ = region_->start();
+		end_   = region_->end();
+		anchors_.insert(start_);
+	} else {
+		start_ = 0;
+		end_   = 0;
+	}
+}
+
+/**
+ * remembers the functions and basic blocks the analyzer found in the region
+ * as good places to start sweeping from
+ *
+ * @brief InstructionBoundaries::seed
+ * @param analyzer
+ */
+void InstructionBoundaries::seed(IAnalyzer *analyzer) {
+
+	if (!analyzer || !region_) {
+		return;
+	}
+
+	// the map is shared with the analyzer, so as long as it is
+	// only ever looked at through a const reference, nothing gets copied
+	const IAnalyzer::FunctionMap &functions = analyzer->functions(region_);
+	for (const Function &function : functions) {
+		anchors_.insert(function.entryAddress());
+		for (const auto &[address, block] : function) {
+			Q_UNUSED(block)
+			anchors_.insert(address);
+		}
+	}
+}
+
+/**
+ * records that there is an instruction of <size> bytes at <address>, any
+ * instructions it overlaps with are forgotten
+ *
+ * @brief InstructionBoundaries::record
+ * @param address
+ * @param size
+ */
+void InstructionBoundaries::record(edb::address_t address, std::size_t size) {
+	sync();
+	setSizeAt(address, size);
+}
+
+/**
+ * @brief InstructionBoundaries::previous
+ * @param analyzer
+ * @param address
+ * @return the address of the instruction which ends right at <address>, if
+ * there is one
+ */
+std::optional<edb::address_t> InstructionBoundaries::previous(IAnalyzer *analyzer, edb::address_t address) {
+
+	if (!region_ || address <= start_ || address > end_) {
+		return {};
+	}
+
+	sync();
+
+	if (std::optional<edb::address_t> previous = endingAt(address)) {
+		return previous;
+	}
+
+	// the analysis may well have finished after we were seeded
+	if (analyzer) {
+		if (Result<edb::address_t, QString> function = analyzer->findContainingFunction(address)) {
+			if (*function >= start_ && *function < address) {
+				anchors_.insert(*function);
+			}
+		}
+	}
+
+	// sweep from the closest known instruction start, whatever we already know
+	// along the way is simply skipped over
+	auto it             = anchors_.lower_bound(address);
+	edb::address_t from = (it != anchors_.begin()) ? *std::prev(it) : start_;
+
+	// without anything better nearby, start somewhere reasonably
+	// close. x86 code tends to synchronize within a few instructions anyway
+	if (address - from > MaxSweep) {
+		from = address - MaxSweep;
+	}
+
+	sweep(from, address);
+	return endingAt(address);
+}
+
+/**
+ * @brief InstructionBoundaries::sizeAt
+ * @param address
+ * @return the size of the instruction known to start at <address>, 0 if none
+ */
+std::size_t InstructionBoundaries::sizeAt(edb::address_t address) const {
+
+	if (address < start_ || address >= end_) {
+		return 0;
+	}
+
+	const std::size_t offset = address - start_;
+	auto it                  = chunks_.find(offset / ChunkSize);
+	if (it != chunks_.end()) {
+		return (*it->second)[offset % ChunkSize];
+	}
+
+	return 0;
+}
+
+/**
+ * @brief InstructionBoundaries::endingAt
+ * @param address
+ * @return the address of the known instruction which ends at <address>
+ */
+std::optional<edb::address_t> InstructionBoundaries::endingAt(edb::address_t address) const {
+
+	// recorded instructions never overlap, so there is at most one
+	const std::size_t limit = std::min<std::size_t>(edb::Instruction::MaxSize, address - start_);
+	for (std::size_t i = 1; i <= limit; ++i) {
+		if (sizeAt(address - i) == i) {
+			return address - i;
+		}
+	}
+
+	return {};
+}
+
+/**
+ * @brief InstructionBoundaries::setSizeAt
+ * @param address
+ * @param size
+ */
+void InstructionBoundaries::setSizeAt(edb::address_t address, std::size_t size) {
+
+	if (address < start_ || address >= end_ || size == 0 || size > edb::Instruction::MaxSize) {
+		return;
+	}
+
+	// forget whatever this instruction overlaps with, earlier instructions
+	// reaching into it as well as the ones starting inside of it
+	const std::size_t limit = std::min<std::size_t>(edb::Instruction::MaxSize - 1, address - start_);
+	for (std::size_t i = 1; i <= limit; ++i) {
+		if (sizeAt(address - i) > i) {
+			clearSizes(address - i, address - i);
+		}
+	}
+
+	if (size > 1) {
+		clearSizes(address + 1, address + (size - 1));
+	}
+
+	const std::size_t offset      = address - start_;
+	std::unique_ptr<Chunk> &chunk = chunks_[offset / ChunkSize];
+	if (!chunk) {
+		chunk = std::make_unique<Chunk>();
+	}
+
+	(*chunk)[offset % ChunkSize] = static_cast<uint8_t>(size);
+}
+
+/**
+ * forgets the instructions starting in [first, last]
+ *
+ * @brief InstructionBoundaries::clearSizes
+ * @param first
+ * @param last
+ */
+void InstructionBoundaries::clearSizes(edb::address_t first, edb::address_t last) {
+
+	first = std::max(first, start_);
+	last  = std::min(last, end_ - 1);
+
+	if (first > last) {
+		return;
+	}
+
+	const std::size_t first_offset = first - start_;
+	const std::size_t last_offset  = last - start_;
+	const std::size_t first_index  = first_offset / ChunkSize;
+	const std::size_t last_index   = last_offset / ChunkSize;
+
+	auto clear = [&](ChunkMap::iterator it) {
+		const std::size_t index       = it->first;
+		const std::size_t chunk_first = std::max(first_offset, index * ChunkSize) - index * ChunkSize;
+		const std::size_t chunk_last  = std::min(last_offset, index * ChunkSize + ChunkSize - 1) - index * ChunkSize;
+
+		if (chunk_first == 0 && chunk_last == ChunkSize - 1) {
+			return chunks_.erase(it);
+		}
+
+		std::fill(it->second->begin() + chunk_first, it->second->begin() + chunk_last + 1, 0);
+		return std::next(it);
+	};
+
+	// whichever is fewer, the chunks in the range or the chunks we have
+	if (last_index - first_index < chunks_.size()) {
+		for (std::size_t index = first_index; index <= last_index; ++index) {
+			auto it = chunks_.find(index);
+			if (it != chunks_.end()) {
+				clear(it);
+			}
+		}
+	} else {
+		for (auto it = chunks_.begin(); it != chunks_.end();) {
+			if (it->first >= first_index && it->first <= last_index) {
+				it = clear(it);
+			} else {
+				++it;
+			}
+		}
+	}
+}
+
+/**
+ * catches up on changed bytes (and formatting) since we last looked
+ *
+ * @brief InstructionBoundaries::sync
+ */
+void InstructionBoundaries::sync() {
+
+	InstructionCache &cache   = edb::v1::instruction_cache();
+	const uint64_t generation = CapstoneEDB::generation();
+	const uint64_t sequence   = cache.sequence();
+
+	std::vector<InstructionCache::Range> ranges;
+
+	if (generation != generation_ || !cache.changesSince(sequence_, &ranges)) {
+		chunks_.clear();
+	} else {
+		for (const InstructionCache::Range &range : ranges) {
+			if (range.size != 0) {
+				// an instruction starting a little earlier may reach into the range
+				const edb::address_t first = (range.address >= edb::Instruction::MaxSize - 1) ? range.address - (edb::Instruction::MaxSize - 1) : edb::address_t(0);
+				clearSizes(first, range.address + (range.size - 1));
+			}
+		}
+	}
+
+	generation_ = generation;
+	sequence_   = sequence;
+}
+
+/**
+ * decodes forward from <from> until reaching (or passing) <to>, recording
+ * every instruction along the way
+ *
+ * @brief InstructionBoundaries::sweep
+ * @param from
+ * @param to
+ */
+void InstructionBoundaries::sweep(edb::address_t from, edb::address_t to) {
+
+	uint8_t buffer[0x1000];
+	edb::address_t base  = from;
+	std::size_t buffered = 0;
+
+	edb::address_t address = from;
+	while (address < to) {
+
+		if (const std::size_t size = sizeAt(address)) {
+			address += size;
+			continue;
+		}
+
+		// make sure that we have a whole instruction worth of bytes, unless
+		// the region ends first
+		std::size_t offset = address - base;
+		if (offset >= buffered || (offset + edb::Instruction::MaxSize > buffered && base + buffered < end_)) {
+			base     = address;
+			buffered = std::min<std::size_t>(sizeof(buffer), end_ - address);
+			offset   = 0;
+			if (!edb::v1::get_instruction_bytes(base, buffer, &buffered)) {
+				return;
+			}
+		}
+
+		const edb::Instruction inst(&buffer[offset], &buffer[buffered], address, edb::Instruction::Mode::Basic);
+		setSizeAt(address, inst.byteSize());
+		address += inst.byteSize();
+	}
+}
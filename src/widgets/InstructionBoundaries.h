@@ -0,0 +1,75 @@
+/*
+Copyright (C) 2026 agent <agent@local>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INSTRUCTION_BOUNDARIES_H_20240301_
+#define INSTRUCTION_BOUNDARIES_H_20240301_
+
+#include "Types.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <set>
+#include <unordered_map>
+
+class IAnalyzer;
+class IRegion;
+
+// Remembers where instructions start within a region, so that the view can
+// step backwards one instruction at a time without disassembling everything
+// above it again. It is filled lazily, by sweeping forward from the closest
+// known instruction start (the region start, or a function or basic block
+// start the analyzer told us about). The instructions recorded never overlap,
+// a later sweep which disagrees with an earlier one wins.
+class InstructionBoundaries {
+public:
+	void setRegion(const std::shared_ptr<IRegion> &region);
+	void seed(IAnalyzer *analyzer);
+	void record(edb::address_t address, std::size_t size);
+	[[nodiscard]] std::optional<edb::address_t> previous(IAnalyzer *analyzer, edb::address_t address);
+
+private:
+	static constexpr std::size_t ChunkSize = 0x10000;
+	static constexpr std::size_t MaxSweep  = 0x10000;
+
+	// a byte per address, the size of the instruction starting there (or 0)
+	using Chunk = std::array<uint8_t, ChunkSize>;
+
+	// only the chunks which were swept are there, keyed by their index within
+	// the region. Regions can be huge reservations which are never looked at
+	using ChunkMap = std::unordered_map<std::size_t, std::unique_ptr<Chunk>>;
+
+private:
+	[[nodiscard]] std::size_t sizeAt(edb::address_t address) const;
+	[[nodiscard]] std::optional<edb::address_t> endingAt(edb::address_t address) const;
+	void setSizeAt(edb::address_t address, std::size_t size);
+	void clearSizes(edb::address_t first, edb::address_t last);
+	void sync();
+	void sweep(edb::address_t from, edb::address_t to);
+
+private:
+	std::shared_ptr<IRegion> region_;
+	edb::address_t start_{0};
+	edb::address_t end_{0};
+	ChunkMap chunks_;
+	std::set<edb::address_t> anchors_;
+	uint64_t generation_ = 0;
+	uint64_t sequence_   = 0;
+};
+
+#endif
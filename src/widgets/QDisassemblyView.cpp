@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ISymbolManager.h"
 #include "IThread.h"
 #include "Instruction.h"
+#include "LengthDecoder.h"
 #include "MemoryRegions.h"
 #include "SessionManager.h"
 #include "State.h"
@@ -64,6 +65,9 @@ struct WidgetState1 {
 
 constexpr int DefaultByteWidth = 8;
 
+// in KB, enough for a few screens worth of highlighted lines on a HiDPI display
+constexpr int LineCacheSize = 64 * 1024;
+
 struct show_separator_tag {};
 
 template <class T>
@@ -109,15 +113,6 @@ bool near_line(int x, int linex) {
 	return std::abs(x - linex) < 3;
 }
 
-//------------------------------------------------------------------------------
-// Name:
-// Desc:
-//------------------------------------------------------------------------------
-int instruction_size(const uint8_t *buffer, std::size_t size) {
-	edb::Instruction inst(buffer, buffer + size, 0);
-	return inst.byteSize();
-}
-
 //------------------------------------------------------------------------------
 // Name: format_instruction_bytes
 // Desc:
@@ -155,7 +150,7 @@ QDisassemblyView::QDisassemblyView(QWidget *parent)
 	  breakpointRenderer_(QLatin1String(":/debugger/images/breakpoint.svg")),
 	  currentRenderer_(QLatin1String(":/debugger/images/arrow-right.svg")),
 	  currentBpRenderer_(QLatin1String(":/debugger/images/arrow-right-red.svg")),
-	  syntaxCache_(256) {
+	  lineCache_(LineCacheSize) {
 
 	// TODO(eteran): it makes more sense for these to have setters/getters and it just be told
 	// by the parent what these colors should be
@@ -271,68 +266,43 @@ void QDisassemblyView::keyPressEvent(QKeyEvent *event) {
 //------------------------------------------------------------------------------
 int QDisassemblyView::previousInstruction(IAnalyzer *analyzer, int current_address) const {
 
-	// If we have an analyzer, and the current address is within a function
-	// then first we find the beginning of that function.
-	// Then, we attempt to disassemble from there until we run into
-	// the address we were on (stopping one instruction early).
-	// this allows us to identify with good accuracy where the
-	// previous instruction was making upward scrolling more functional.
-	//
-	// If all else fails, fall back on the old heuristic which works "ok"
-	if (analyzer) {
-		edb::address_t address = addressOffset_ + current_address;
-
-		// find the containing function
-		if (Result<edb::address_t, QString> function_address = analyzer->findContainingFunction(address)) {
-
-			if (address != *function_address) {
-				edb::address_t function_start = *function_address;
-
-				// disassemble from function start until the NEXT address is where we started
-				while (true) {
-					uint8_t buf[edb::Instruction::MaxSize];
-
-					size_t buf_size = sizeof(buf);
-					if (region_) {
-						buf_size = std::min<size_t>((function_start - region_->base()), sizeof(buf));
-					}
-
-					if (edb::v1::get_instruction_bytes(function_start, buf, &buf_size)) {
-						const edb::Instruction inst(buf, buf + buf_size, function_start);
-						if (!inst) {
-							break;
-						}
-
-						// if the NEXT address would be our target, then
-						// we are at the previous instruction!
-						if (function_start + inst.byteSize() >= current_address + addressOffset_) {
-							break;
-						}
-
-						function_start += inst.byteSize();
-					} else {
-						break;
-					}
-				}
-
-				current_address = (function_start - addressOffset_);
-				return current_address;
-			}
-		}
+	// most of the time we already know which instruction ends right where we
+	// are, otherwise the boundaries sweep forward from the closest function,
+	// basic block (or anything else they know about) to find out
+	if (std::optional<edb::address_t> previous = boundaries_.previous(analyzer, addressOffset_ + current_address)) {
+		return static_cast<int>(*previous - addressOffset_);
 	}
 
 	// fall back on the old heuristic
 	// iteration goal: to get exactly one new line above current instruction line
 	edb::address_t address = addressOffset_ + current_address;
 
+#if defined(EDB_X86) || defined(EDB_X86_64)
+	// read the whole window once, so the length decoder can rule out most of
+	// the candidates before we ask capstone about them one by one
+	uint8_t window[edb::Instruction::MaxSize];
+	size_t window_size     = sizeof(window);
+	const bool have_window = current_address >= static_cast<int>(sizeof(window)) && edb::v1::get_instruction_bytes(address - sizeof(window), window, &window_size) && window_size == sizeof(window);
+#endif
+
 	for (int i = static_cast<int>(edb::Instruction::MaxSize); i > 0; --i) {
 		edb::address_t prev_address = address - i;
 		if (address >= addressOffset_) {
 
+#if defined(EDB_X86) || defined(EDB_X86_64)
+			if (have_window) {
+				const CapstoneEDB::LengthInfo info = CapstoneEDB::decode_length(window + sizeof(window) - i, window + sizeof(window), prev_address);
+				if (info.size != 0 && info.size != i) {
+					continue;
+				}
+			}
+#endif
+
 			uint8_t buf[edb::Instruction::MaxSize];
 			int size               = sizeof(buf);
 			Result<int, QString> n = getInstructionSize(prev_address, buf, &size);
 			if (n && *n == i) {
+				boundaries_.record(prev_address, i);
 				return current_address - i;
 			}
 		}
@@ -374,8 +344,8 @@ int QDisassemblyView::followingInstruction(int current_address) const {
 		return current_address + 1;
 	}
 
-	const edb::Instruction inst(buf, buf + buf_size, current_address);
-	return current_address + inst.byteSize();
+	const auto entry = edb::v1::instruction_cache().find(addressOffset_ + current_address, buf, buf_size);
+	return current_address + entry->instruction().byteSize();
 }
 
 //------------------------------------------------------------------------------
@@ -527,6 +497,8 @@ void QDisassemblyView::setRegion(const std::shared_ptr<IRegion> &r) {
 	// reset region, so we don't bother check that condition
 	if ((r && !r->equals(region_)) || (!r)) {
 		region_ = r;
+		boundaries_.setRegion(region_);
+		boundaries_.seed(edb::v1::analyzer());
 		setAddressOffset(region_ ? region_->start() : edb::address_t(0));
 		updateScrollbars();
 		Q_EMIT regionChanged();
@@ -566,8 +538,9 @@ void QDisassemblyView::scrollTo(edb::address_t address) {
 // Name: instructionString
 // Desc:
 //------------------------------------------------------------------------------
-QString QDisassemblyView::instructionString(const edb::Instruction &inst) const {
-	auto opcode = QString::fromStdString(edb::v1::formatter().toString(inst));
+QString QDisassemblyView::instructionString(const InstructionCache::Entry &entry) const {
+	const edb::Instruction &inst = entry.instruction();
+	QString opcode               = entry.text();
 
 	if (is_call(inst) || is_jump(inst)) {
 		if (inst.operandCount() == 1) {
@@ -607,85 +580,89 @@ QString QDisassemblyView::instructionString(const edb::Instruction &inst) const
 // Name: drawInstruction
 // Desc:
 //------------------------------------------------------------------------------
-void QDisassemblyView::drawInstruction(QPainter &painter, const edb::Instruction &inst, const DrawingContext *ctx, int y, bool selected) {
+void QDisassemblyView::drawInstruction(QPainter &painter, const InstructionCache::Entry &entry, const DrawingContext *ctx, int y, bool selected) {
 
 	painter.save();
 
+	const edb::Instruction &inst = entry.instruction();
+
 	const bool is_filling      = edb::v1::arch_processor().isFilling(inst);
 	const int x                = fontWidth_ + fontWidth_ + ctx->l3 + (fontWidth_ / 2);
 	const int inst_pixel_width = ctx->l4 - x;
 
 	const bool syntax_highlighting_enabled = edb::v1::config().syntax_highlighting_enabled && !selected;
+	const bool highlighted                 = syntax_highlighting_enabled && !is_filling;
 
-	QString opcode = instructionString(inst);
+	const QString opcode = instructionString(entry);
 
-	if (is_filling) {
-		if (syntax_highlighting_enabled) {
-			painter.setPen(fillingBytesColor_);
-		}
+	// highlighting and laying out the text is most of the work
+	// of painting a line, so we keep the result for as long as the line looks
+	// the same. The text changes with the bytes, the formatter options and the
+	// symbols, so comparing it covers all of those
+	CachedLine *line = lineCache_.object(inst.rva());
+	if (!line || line->width != inst_pixel_width || line->highlighted != highlighted || line->text != opcode) {
 
-		opcode = painter.fontMetrics().elidedText(opcode, Qt::ElideRight, inst_pixel_width);
+		line              = new CachedLine;
+		line->text        = opcode;
+		line->width       = inst_pixel_width;
+		line->highlighted = highlighted;
 
-		painter.drawText(
-			x,
-			y,
-			opcode.length() * fontWidth_,
-			ctx->lineHeight,
-			Qt::AlignVCenter,
-			opcode);
-	} else {
-
-		// NOTE(eteran): do this early, so that elided text still gets the part shown
-		// properly highlighted
-		QVector<QTextLayout::FormatRange> highlightData;
-		if (syntax_highlighting_enabled) {
-			highlightData = highlighter_->highlightBlock(opcode);
-		}
-
-		opcode = painter.fontMetrics().elidedText(opcode, Qt::ElideRight, inst_pixel_width);
+		if (highlighted) {
+			// NOTE(eteran): do this early, so that elided text still gets the part shown
+			// properly highlighted
+			const QVector<QTextLayout::FormatRange> highlightData = highlighter_->highlightBlock(opcode);
+			const QString elided                                  = painter.fontMetrics().elidedText(opcode, Qt::ElideRight, inst_pixel_width);
 
-		if (syntax_highlighting_enabled) {
+			// create the text layout
+			QTextLayout textLayout(elided, painter.font());
 
-			QPixmap *map = syntaxCache_[opcode];
-			if (!map) {
+			textLayout.setTextOption(QTextOption(Qt::AlignVCenter));
 
-				// create the text layout
-				QTextLayout textLayout(opcode, painter.font());
+			textLayout.beginLayout();
 
-				textLayout.setTextOption(QTextOption(Qt::AlignVCenter));
+			// generate the lines one at a time
+			// setting the positions as we go
+			Q_FOREVER {
+				QTextLine text_line = textLayout.createLine();
 
-				textLayout.beginLayout();
+				if (!text_line.isValid()) {
+					break;
+				}
 
-				// generate the lines one at a time
-				// setting the positions as we go
-				Q_FOREVER {
-					QTextLine line = textLayout.createLine();
+				text_line.setPosition(QPoint(0, 0));
+			}
 
-					if (!line.isValid()) {
-						break;
-					}
+			textLayout.endLayout();
 
-					line.setPosition(QPoint(0, 0));
-				}
+			line->pixmap = QPixmap(QSize(elided.length() * fontWidth_, ctx->lineHeight) * devicePixelRatio());
+			line->pixmap.setDevicePixelRatio(devicePixelRatio());
+			line->pixmap.fill(Qt::transparent);
+			QPainter cache_painter(&line->pixmap);
+			cache_painter.setPen(painter.pen());
+			cache_painter.setFont(painter.font());
 
-				textLayout.endLayout();
+			// now the render the text at the location given
+			textLayout.draw(&cache_painter, QPoint(0, 0), highlightData);
+		} else {
+			line->staticText.setText(painter.fontMetrics().elidedText(opcode, Qt::ElideRight, inst_pixel_width));
+			line->staticText.setTextFormat(Qt::PlainText);
+			line->staticText.prepare(painter.transform(), painter.font());
+		}
 
-				map = new QPixmap(QSize(opcode.length() * fontWidth_, ctx->lineHeight) * devicePixelRatio());
-				map->setDevicePixelRatio(devicePixelRatio());
-				map->fill(Qt::transparent);
-				QPainter cache_painter(map);
-				cache_painter.setPen(painter.pen());
-				cache_painter.setFont(painter.font());
+		// the cost is roughly how many KB the line takes up
+		const int cost = highlighted ? std::max(1, (line->pixmap.width() * line->pixmap.height() * 4) / 1024) : 1;
+		lineCache_.insert(inst.rva(), line, cost);
+	}
 
-				// now the render the text at the location given
-				textLayout.draw(&cache_painter, QPoint(0, 0), highlightData);
-				syntaxCache_.insert(opcode, map);
-			}
-			painter.drawPixmap(x, y, *map);
-		} else {
-			QRectF rectangle(x, y, opcode.length() * fontWidth_, ctx->lineHeight);
-			painter.drawText(rectangle, Qt::AlignVCenter, opcode);
+	if (highlighted) {
+		painter.drawPixmap(x, y, line->pixmap);
+	} else {
+		if (is_filling && syntax_highlighting_enabled) {
+			painter.setPen(fillingBytesColor_);
 		}
+
+		// the same as drawing it vertically centered in the line
+		painter.drawStaticText(QPointF(x, y + (ctx->lineHeight - painter.fontMetrics().height()) / 2.0), line->staticText);
 	}
 
 	painter.restore();
@@ -748,15 +725,11 @@ int QDisassemblyView::updateDisassembly(int lines_to_render) {
 
 	while (line < lines_to_render && offset < max_offset) {
 		edb::address_t address = start_address + offset;
-		instructions_.emplace_back(
-			&inst_buf[offset],  // instruction bytes
-			&inst_buf[bufsize], // end of buffer
-			address             // address of instruction
-		);
+		instructions_.push_back(edb::v1::instruction_cache().find(address, &inst_buf[offset], bufsize - offset));
 		showAddresses_.push_back(address);
 
-		if (instructions_[line].valid()) {
-			offset += instructions_[line].byteSize();
+		if (instructions_[line]->instruction().valid()) {
+			offset += instructions_[line]->instruction().byteSize();
 		} else {
 			++offset;
 		}
@@ -778,7 +751,7 @@ int QDisassemblyView::updateDisassembly(int lines_to_render) {
 int QDisassemblyView::getSelectedLineNumber() const {
 
 	for (size_t line = 0; line < instructions_.size(); ++line) {
-		if (instructions_[line].rva() == selectedAddress()) {
+		if (instructions_[line]->instruction().rva() == selectedAddress()) {
 			return static_cast<int>(line);
 		}
 	}
@@ -790,7 +763,7 @@ int QDisassemblyView::getSelectedLineNumber() const {
 // Name: drawHeaderAndBackground
 // Desc:
 //------------------------------------------------------------------------------
-void QDisassemblyView::drawHeaderAndBackground(QPainter &painter, const DrawingContext *ctx, const std::unique_ptr<IBinary> &binary_info) {
+void QDisassemblyView::drawHeaderAndBackground(QPainter &painter, const DrawingContext *ctx, const std::shared_ptr<IBinary> &binary_info) {
 
 	painter.save();
 
@@ -834,10 +807,11 @@ void QDisassemblyView::drawRegisterBadges(QPainter &painter, DrawingContext *ctx
 	painter.save();
 	if (IProcess *process = edb::v1::debugger_core->process()) {
 
-		if (process->isPaused()) {
+		std::shared_ptr<IThread> thread = process->currentThread();
+		if (thread && thread->isPaused()) {
 
 			State state;
-			process->currentThread()->getState(&state);
+			thread->getState(&state);
 
 			std::vector<QString> badge_labels(ctx->linesToRender);
 			{
@@ -1052,7 +1026,7 @@ void QDisassemblyView::drawInstructionBytes(QPainter &painter, const DrawingCont
 
 	for (int line = 0; line < ctx->linesToRender; line++) {
 
-		auto &&inst = instructions_[line];
+		auto &&inst = instructions_[line]->instruction();
 		if (ctx->selectedLines != line) {
 			painter_lambda(inst, line);
 		}
@@ -1060,7 +1034,7 @@ void QDisassemblyView::drawInstructionBytes(QPainter &painter, const DrawingCont
 
 	if (ctx->selectedLines < ctx->linesToRender) {
 		painter.setPen(palette().color(ctx->group, QPalette::HighlightedText));
-		painter_lambda(instructions_[ctx->selectedLines], ctx->selectedLines);
+		painter_lambda(instructions_[ctx->selectedLines]->instruction(), ctx->selectedLines);
 	}
 
 	painter.restore();
@@ -1116,7 +1090,7 @@ void QDisassemblyView::drawFunctionMarkers(QPainter &painter, const DrawingConte
 
 				// find the end and draw the other corner
 				for (end_line = start_line; end_line < ctx->linesToRender; end_line++) {
-					auto adjusted_end_addr = showAddresses_[end_line] + instructions_[end_line].byteSize() - 1;
+					auto adjusted_end_addr = showAddresses_[end_line] + instructions_[end_line]->instruction().byteSize() - 1;
 					if (adjusted_end_addr == end_addr) {
 						auto y = end_line * ctx->lineHeight;
 
@@ -1177,7 +1151,7 @@ void QDisassemblyView::drawComments(QPainter &painter, const DrawingContext *ctx
 		}
 
 		QString annotation = comments_.value(address, QStringLiteral(""));
-		auto &&inst        = instructions_[line];
+		auto &&inst        = instructions_[line]->instruction();
 		if (annotation.isEmpty() && inst && !is_jump(inst) && !is_call(inst)) {
 			// draw ascii representations of immediate constants
 			size_t op_count = inst.operandCount();
@@ -1226,7 +1200,7 @@ void QDisassemblyView::drawJumpArrows(QPainter &painter, const DrawingContext *c
 
 	for (int line = 0; line < ctx->linesToRender; ++line) {
 
-		auto &&inst = instructions_[line];
+		auto &&inst = instructions_[line]->instruction();
 		if (is_jump(inst) && is_immediate(inst[0])) {
 
 			const edb::address_t target = inst[0]->imm;
@@ -1243,7 +1217,7 @@ void QDisassemblyView::drawJumpArrows(QPainter &painter, const DrawingContext *c
 					// check if dst address is in viewport
 					for (int i = 0; i < ctx->linesToRender; ++i) {
 
-						if (instructions_[i].rva() == target) {
+						if (instructions_[i]->instruction().rva() == target) {
 							jump_arrow.destLine       = i;
 							jump_arrow.destInViewport = true;
 							break;
@@ -1251,7 +1225,7 @@ void QDisassemblyView::drawJumpArrows(QPainter &painter, const DrawingContext *c
 
 						if (i < ctx->linesToRender - 1) {
 							// if target is in middle of instruction
-							if (target > instructions_[i].rva() && target < instructions_[i + 1].rva()) {
+							if (target > instructions_[i]->instruction().rva() && target < instructions_[i + 1]->instruction().rva()) {
 								jump_arrow.destLine                  = i + 1;
 								jump_arrow.destInMiddleOfInstruction = true;
 								jump_arrow.destInViewport            = true;
@@ -1301,7 +1275,7 @@ void QDisassemblyView::drawJumpArrows(QPainter &painter, const DrawingContext *c
 	for (size_t jump_arrow_idx = 0; jump_arrow_idx < jump_arrow_vec.size(); jump_arrow_idx++) {
 
 		JumpArrow &jump_arrow = jump_arrow_vec[jump_arrow_idx];
-		bool is_dst_upward    = jump_arrow.target < instructions_[jump_arrow.sourceLine].rva();
+		bool is_dst_upward    = jump_arrow.target < instructions_[jump_arrow.sourceLine]->instruction().rva();
 		int jump_arrow_dst    = jump_arrow.destInViewport ? jump_arrow.destLine * ctx->lineHeight : (is_dst_upward ? 0 : viewport()->height());
 
 		int size_block     = fontWidth_ * 2;
@@ -1344,7 +1318,7 @@ void QDisassemblyView::drawJumpArrows(QPainter &painter, const DrawingContext *c
 
 				const JumpArrow &jump_arrow_prev = jump_arrow_vec[jump_arrow_prev_idx];
 
-				bool is_dst_upward_prev = jump_arrow_prev.target < instructions_[jump_arrow_prev.sourceLine].rva();
+				bool is_dst_upward_prev = jump_arrow_prev.target < instructions_[jump_arrow_prev.sourceLine]->instruction().rva();
 				int jump_arrow_prev_dst = jump_arrow_prev.destInViewport ? jump_arrow_prev.destLine * ctx->lineHeight : (is_dst_upward_prev ? 0 : viewport()->height());
 
 				bool jumps_overlap = isLineOverlap(
@@ -1380,7 +1354,7 @@ void QDisassemblyView::drawJumpArrows(QPainter &painter, const DrawingContext *c
 
 	for (const JumpArrow &jump_arrow : jump_arrow_vec) {
 
-		bool is_dst_upward = jump_arrow.target < instructions_[jump_arrow.sourceLine].rva();
+		bool is_dst_upward = jump_arrow.target < instructions_[jump_arrow.sourceLine]->instruction().rva();
 
 		// horizontal line
 		int end_x   = ctx->l1 - 3;
@@ -1404,8 +1378,8 @@ void QDisassemblyView::drawJumpArrows(QPainter &painter, const DrawingContext *c
 			arrow_width = 2.0; // enlarge arrow width
 		}
 
-		bool conditional_jmp   = is_conditional_jump(instructions_[jump_arrow.sourceLine]);
-		bool unconditional_jmp = is_unconditional_jump(instructions_[jump_arrow.sourceLine]);
+		bool conditional_jmp   = is_conditional_jump(instructions_[jump_arrow.sourceLine]->instruction());
+		bool unconditional_jmp = is_unconditional_jump(instructions_[jump_arrow.sourceLine]->instruction());
 
 		// if direct jmp, then draw in solid line
 		if (unconditional_jmp) {
@@ -1427,7 +1401,7 @@ void QDisassemblyView::drawJumpArrows(QPainter &painter, const DrawingContext *c
 		// if current conditional jump is taken, then draw arrow in red
 		if (showAddresses_[jump_arrow.sourceLine] == currentAddress_) { // if eip
 			if (conditional_jmp) {
-				if (edb::v1::arch_processor().isExecuted(instructions_[jump_arrow.sourceLine], state)) {
+				if (edb::v1::arch_processor().isExecuted(instructions_[jump_arrow.sourceLine]->instruction(), state)) {
 					arrow_color = takenJumpColor_;
 				}
 			}
@@ -1521,10 +1495,10 @@ void QDisassemblyView::drawDisassembly(QPainter &painter, const DrawingContext *
 		if (ctx->selectedLines == line) {
 			QPen prevPen = painter.pen();
 			painter.setPen(palette().color(ctx->group, QPalette::HighlightedText));
-			drawInstruction(painter, instructions_[line], ctx, line * ctx->lineHeight, true);
+			drawInstruction(painter, *instructions_[line], ctx, line * ctx->lineHeight, true);
 			painter.setPen(prevPen);
 		} else {
-			drawInstruction(painter, instructions_[line], ctx, line * ctx->lineHeight, false);
+			drawInstruction(painter, *instructions_[line], ctx, line * ctx->lineHeight, false);
 		}
 	}
 
@@ -1584,7 +1558,7 @@ void QDisassemblyView::paintEvent(QPaintEvent *) {
 		partialLastLine_ = false;
 	}
 
-	const auto binary_info = edb::v1::get_binary_info(region_);
+	const auto binary_info = edb::v1::cached_binary_info(region_);
 	const auto group       = hasFocus() ? QPalette::Active : QPalette::Inactive;
 
 	lines_to_render         = updateDisassembly(lines_to_render);
@@ -1627,7 +1601,8 @@ void QDisassemblyView::paintEvent(QPaintEvent *) {
 
 	const int64_t renderTime = timer.elapsed();
 	if (renderTime > 50) {
-		qDebug() << "Painting took longer than desired: " << renderTime << "ms";
+		qDebug() << "Painting took longer than desired: " << renderTime << "ms"
+				 << "(binary info probes saved so far:" << edb::v1::binary_info_probes_saved() << ")";
 	}
 }
 
@@ -1636,7 +1611,7 @@ void QDisassemblyView::paintEvent(QPaintEvent *) {
 // Desc: overloaded version of setFont, calculates font metrics for later
 //------------------------------------------------------------------------------
 void QDisassemblyView::setFont(const QFont &f) {
-	syntaxCache_.clear();
+	lineCache_.clear();
 
 	QFont newFont(f);
 
@@ -1809,7 +1784,7 @@ Result<int, QString> QDisassemblyView::getInstructionSize(edb::address_t address
 		bool ok = edb::v1::get_instruction_bytes(address, buf, size);
 
 		if (ok) {
-			return instruction_size(buf, *size);
+			return static_cast<int>(edb::v1::instruction_cache().find(address, buf, *size)->instruction().byteSize());
 		}
 	}
 
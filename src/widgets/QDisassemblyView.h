@@ -19,6 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef QDISASSEMBLY_VIEW_H_20061101_
 #define QDISASSEMBLY_VIEW_H_20061101_
 
+#include "InstructionBoundaries.h"
+#include "InstructionCache.h"
 #include "NavigationHistory.h"
 #include "Types.h"
 
@@ -27,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QCache>
 #include <QPainterPath>
 #include <QPixmap>
+#include <QStaticText>
 #include <QSvgRenderer>
 
 #include <memory>
@@ -119,7 +122,7 @@ private:
 	[[nodiscard]] int previousInstruction(IAnalyzer *analyzer, int current_address) const;
 	[[nodiscard]] int previousInstructions(int current_address, int count) const;
 	[[nodiscard]] QString formatAddress(edb::address_t address) const;
-	[[nodiscard]] QString instructionString(const edb::Instruction &inst) const;
+	[[nodiscard]] QString instructionString(const InstructionCache::Entry &entry) const;
 	[[nodiscard]] Result<int, QString> getInstructionSize(edb::address_t address, uint8_t *buf, int *size) const;
 	[[nodiscard]] Result<int, QString> getInstructionSize(edb::address_t address) const;
 	[[nodiscard]] std::optional<unsigned int> getLineOfAddress(edb::address_t addr) const;
@@ -130,8 +133,8 @@ private:
 	void updateScrollbars();
 	void updateSelectedAddress(QMouseEvent *event);
 
-	void drawInstruction(QPainter &painter, const edb::Instruction &inst, const DrawingContext *ctx, int y, bool selected);
-	void drawHeaderAndBackground(QPainter &painter, const DrawingContext *ctx, const std::unique_ptr<IBinary> &binary_info);
+	void drawInstruction(QPainter &painter, const InstructionCache::Entry &entry, const DrawingContext *ctx, int y, bool selected);
+	void drawHeaderAndBackground(QPainter &painter, const DrawingContext *ctx, const std::shared_ptr<IBinary> &binary_info);
 	void drawRegisterBadges(QPainter &painter, DrawingContext *ctx);
 	void drawSymbolNames(QPainter &painter, const DrawingContext *ctx);
 	void drawSidebarElements(QPainter &painter, const DrawingContext *ctx);
@@ -171,7 +174,8 @@ private:
 private:
 	std::shared_ptr<IRegion> region_;
 	QVector<edb::address_t> showAddresses_;
-	std::vector<CapstoneEDB::Instruction> instructions_;
+	std::vector<std::shared_ptr<const InstructionCache::Entry>> instructions_;
+	mutable InstructionBoundaries boundaries_;
 	SyntaxHighlighter *highlighter_;
 	bool showAddressSeparator_;
 	QHash<edb::address_t, QString> comments_;
@@ -180,7 +184,18 @@ private:
 	QSvgRenderer currentRenderer_;
 	QSvgRenderer currentBpRenderer_;
 	std::vector<uint8_t> instructionBuffer_;
-	QCache<QString, QPixmap> syntaxCache_;
+
+private:
+	// an instruction's text, laid out (and highlighted) for painting
+	struct CachedLine {
+		QString text; // before eliding, this includes any symbols
+		int width        = 0;
+		bool highlighted = false;
+		QStaticText staticText;
+		QPixmap pixmap;
+	};
+
+	QCache<edb::address_t, CachedLine> lineCache_;
 
 private:
 	struct JumpArrow {